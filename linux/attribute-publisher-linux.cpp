@@ -0,0 +1,65 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <attribute-publisher.h>
+
+#include <esp_log.h>
+
+#include <inttypes.h>
+
+#include <air-quality-sensor-manager.h>
+
+/* attribute_publisher for the Linux build. Its data model comes from the upstream ZAP file with the clusters served
+ * by AirQualitySensorManager, so cluster_instance_policy is the only one built; the other policies and the bench need
+ * esp_matter. */
+
+using namespace chip::app::Clusters;
+
+namespace attribute_publisher {
+
+static const char *TAG = "attribute_publisher";
+
+static uint16_t s_endpoint_id;
+
+void cluster_instance_policy::init(uint16_t endpoint_id)
+{
+    AirQualitySensorManager::InitInstance(endpoint_id);
+}
+
+/* The manager serves the endpoint it was created for. The upstream endpoint has the temperature and humidity clusters
+ * too, so they are published here as well. */
+uint32_t cluster_instance_policy::publish(uint16_t /* endpoint_id */, const measurement_pipeline::result_t &result)
+{
+    AirQualitySensorManager *manager = AirQualitySensorManager::GetInstance();
+    if (manager == nullptr) {
+        return 2;
+    }
+    manager->OnAirQualityChangeHandler(static_cast<AirQuality::AirQualityEnum>(result.air_quality));
+    manager->OnCarbonDioxideMeasurementChangeHandler(result.co2_ppm);
+    /* The clusters count in hundredths */
+    manager->OnTemperatureMeasurementChangeHandler(static_cast<int16_t>(result.temperature_m_deg_c / 10));
+    manager->OnHumidityMeasurementChangeHandler(static_cast<uint16_t>(result.humidity_m_percent_rh / 10));
+    return 0;
+}
+
+void init(uint16_t endpoint_id)
+{
+    s_endpoint_id = endpoint_id;
+    selected_policy_t::init(endpoint_id);
+    ESP_LOGI(TAG, "Publishing through %s", selected_policy_t::k_name);
+}
+
+void publish(const measurement_pipeline::result_t &result)
+{
+    uint32_t failures = selected_policy_t::publish(s_endpoint_id, result);
+    if (failures != 0) {
+        ESP_LOGW(TAG, "%s refused %" PRIu32 " attribute(s)", selected_policy_t::k_name, failures);
+    }
+}
+
+} // namespace attribute_publisher
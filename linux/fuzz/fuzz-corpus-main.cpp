@@ -0,0 +1,106 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* Runs a fuzz target's corpus without libFuzzer, so the corpus is replayed by every host test run and can be replayed
+ * under any compiler and sanitizer. The target aborts on a failed check.
+ *
+ * Usage: <target>-corpus-test [file or directory...], by default the corpus the target was built with. */
+
+#include <dirent.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#ifndef FUZZ_CORPUS_DIR
+#error "FUZZ_CORPUS_DIR must point at the target's corpus"
+#endif
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+namespace {
+
+bool run_file(const std::string &path)
+{
+    FILE *file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        fprintf(stderr, "cannot open %s\n", path.c_str());
+        return false;
+    }
+    std::vector<uint8_t> input;
+    uint8_t buffer[4096];
+    size_t count;
+    while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        input.insert(input.end(), buffer, buffer + count);
+    }
+    fclose(file);
+    /* An exact-size copy, so reading past the input is caught */
+    uint8_t *data = new uint8_t[input.size() + 1];
+    std::copy(input.begin(), input.end(), data);
+    LLVMFuzzerTestOneInput(data, input.size());
+    delete[] data;
+    return true;
+}
+
+/* Run `path`, or every file in it if it is a directory; returns the number of inputs run, -1 on error */
+int run_path(const std::string &path)
+{
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+        fprintf(stderr, "cannot open %s\n", path.c_str());
+        return -1;
+    }
+    if (!S_ISDIR(info.st_mode)) {
+        return run_file(path) ? 1 : -1;
+    }
+    DIR *dir = opendir(path.c_str());
+    if (dir == nullptr) {
+        fprintf(stderr, "cannot open %s\n", path.c_str());
+        return -1;
+    }
+    std::vector<std::string> names;
+    while (struct dirent *entry = readdir(dir)) {
+        if (entry->d_name[0] != '.') {
+            names.push_back(entry->d_name);
+        }
+    }
+    closedir(dir);
+    std::sort(names.begin(), names.end());
+    int runs = 0;
+    for (const std::string &name : names) {
+        if (!run_file(path + "/" + name)) {
+            return -1;
+        }
+        runs++;
+    }
+    return runs;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::vector<std::string> paths(argv + 1, argv + argc);
+    if (paths.empty()) {
+        paths.push_back(FUZZ_CORPUS_DIR);
+    }
+    int runs = 0;
+    for (const std::string &path : paths) {
+        int count = run_path(path);
+        if (count < 0) {
+            return 1;
+        }
+        runs += count;
+    }
+    printf("%s: %d input(s) passed\n", argv[0], runs);
+    return runs > 0 ? 0 : 1;
+}
@@ -0,0 +1,91 @@
+#!/usr/bin/env python3
+#
+# This example code is in the Public Domain (or CC0 licensed, at your option.)
+#
+# Unless required by applicable law or agreed to in writing, this
+# software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+# CONDITIONS OF ANY KIND, either express or implied.
+
+"""Seed corpora for the fuzz targets in this directory.
+
+The response frames are the simulated SCD4x's, taken from a trace recorded
+with `trace-replay --capture-sim` (linux/traces/sim-ramp-2h.csv by default),
+one every --every records. Each frame is written in the input layout of both
+targets, described at the top of their sources. The read target also gets
+inputs with no response bytes, which leave the simulator's own answer in place,
+before and after its first measurement is ready and with either transfer
+NACKed.
+
+    ./make-corpus.py ../traces/sim-ramp-2h.csv corpus
+"""
+
+import argparse
+import os
+import struct
+
+WORDS_PER_MEASUREMENT = 3
+MEASUREMENT_INTERVAL_US = 5000000
+
+
+def crc8(data):
+    crc = 0xFF
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = (crc << 1) ^ 0x31 if crc & 0x80 else crc << 1
+            crc &= 0xFF
+    return crc
+
+
+def frame(words):
+    out = bytearray()
+    for word in words:
+        data = struct.pack(">H", word)
+        out += data + bytes([crc8(data)])
+    return bytes(out)
+
+
+def read_trace(path):
+    with open(path) as trace:
+        for line in trace:
+            if not line.strip() or line.startswith("#") or line.startswith("timestamp_us"):
+                continue
+            fields = [int(field, 0) for field in line.split(",")]
+            yield fields[0], fields[1:4]
+
+
+def read_input(flags, advance_us, response=b""):
+    return struct.pack("<BI", flags, advance_us) + response
+
+
+def write(directory, name, data):
+    os.makedirs(directory, exist_ok=True)
+    with open(os.path.join(directory, name), "wb") as out:
+        out.write(data)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("trace", nargs="?", default=os.path.join(os.path.dirname(__file__), "..", "traces",
+                                                                 "sim-ramp-2h.csv"))
+    parser.add_argument("corpus", nargs="?", default=os.path.join(os.path.dirname(__file__), "corpus"))
+    parser.add_argument("--every", type=int, default=120, help="records between two captured frames")
+    args = parser.parse_args()
+
+    decode_dir = os.path.join(args.corpus, "sensirion-decode")
+    read_dir = os.path.join(args.corpus, "scd4x-read-measurement")
+    for index, (timestamp_us, words) in enumerate(read_trace(args.trace)):
+        if index % args.every:
+            continue
+        name = "sim-%010d" % timestamp_us
+        write(decode_dir, name, bytes([WORDS_PER_MEASUREMENT]) + frame(words))
+        write(read_dir, name, read_input(0, MEASUREMENT_INTERVAL_US, frame(words)))
+
+    write(read_dir, "sim-own-response", read_input(0, MEASUREMENT_INTERVAL_US))
+    write(read_dir, "sim-not-ready", read_input(0, MEASUREMENT_INTERVAL_US - 1))
+    write(read_dir, "write-nack", read_input(1, MEASUREMENT_INTERVAL_US))
+    write(read_dir, "read-nack", read_input(2, MEASUREMENT_INTERVAL_US))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,123 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* libFuzzer target for scd4x_read_measurement_raw() against the simulated SCD4x.
+ *
+ * Input:
+ * - byte 0: bit 0 NACKs the command write, bit 1 NACKs the response read;
+ * - bytes 1 to 4: time in µs, little-endian, that passes between starting periodic measurement and the read;
+ * - the rest: the bytes the read returns, in place of the simulator's. Missing bytes are left as the simulator sent
+ *   them, so a corpus entry of just the header exercises the simulator's own response and its data-ready timing.
+ *
+ * The read must succeed exactly when the bus did and every word's CRC matches, and then return the words sent. */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "scd4x_i2c.h"
+#include "scd4x_sim.h"
+#include "sensirion_common.h"
+#include "sensirion_i2c.h"
+#include "sensirion_i2c_hal.h"
+
+namespace {
+
+const size_t k_header_size = 5;
+
+uint64_t s_now_us;
+const uint8_t *s_response;
+size_t s_response_size;
+uint8_t s_flags;
+/* The frame the driver was given, to check what it decoded */
+uint8_t s_delivered[SENSIRION_I2C_CMD_BUFFER_SIZE];
+uint8_t s_delivered_size;
+bool s_bus_failed;
+
+uint64_t get_time_usec()
+{
+    return s_now_us;
+}
+
+void sleep_usec(uint32_t duration_us)
+{
+    s_now_us += duration_us;
+}
+
+const sensirion_i2c_hal_clock_t k_clock = {get_time_usec, sleep_usec};
+
+int8_t fuzz_write(uint8_t address, const uint8_t *data, uint8_t count)
+{
+    int8_t result = scd4x_sim_bus.write(address, data, count);
+    if (s_flags & 1) {
+        result = -1;
+    }
+    s_bus_failed = s_bus_failed || result != 0;
+    return result;
+}
+
+int8_t fuzz_read(uint8_t address, uint8_t *data, uint8_t count)
+{
+    int8_t result = scd4x_sim_bus.read(address, data, count);
+    if (s_flags & 2) {
+        result = -1;
+    }
+    memcpy(data, s_response, s_response_size < count ? s_response_size : count);
+    memcpy(s_delivered, data, count <= sizeof(s_delivered) ? count : sizeof(s_delivered));
+    s_delivered_size = count;
+    s_bus_failed = s_bus_failed || result != 0;
+    return result;
+}
+
+const sensirion_i2c_hal_bus_t k_bus = {fuzz_read, fuzz_write};
+
+} // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    if (size < k_header_size) {
+        return 0;
+    }
+    s_flags = data[0];
+    uint32_t advance_us = (uint32_t)data[1] | (uint32_t)data[2] << 8 | (uint32_t)data[3] << 16 | (uint32_t)data[4] << 24;
+    s_response = data + k_header_size;
+    s_response_size = size - k_header_size;
+    s_delivered_size = 0;
+    s_bus_failed = false;
+
+    s_now_us = 0;
+    sensirion_i2c_hal_set_clock(&k_clock);
+    sensirion_i2c_hal_set_bus(&scd4x_sim_bus);
+    scd4x_init(SCD40_I2C_ADDR_62);
+    scd4x_sim_reset();
+    scd4x_start_periodic_measurement();
+    s_now_us += advance_us;
+
+    sensirion_i2c_hal_set_bus(&k_bus);
+    uint16_t words[3] = {0xdead, 0xdead, 0xdead};
+    int16_t error = scd4x_read_measurement_raw(&words[0], &words[1], &words[2]);
+    sensirion_i2c_hal_set_bus(NULL);
+    sensirion_i2c_hal_set_clock(NULL);
+
+    bool crcs_match = s_delivered_size == 3 * (SENSIRION_WORD_SIZE + CRC8_LEN);
+    for (uint8_t i = 0; crcs_match && i < s_delivered_size; i += SENSIRION_WORD_SIZE + CRC8_LEN) {
+        crcs_match = sensirion_i2c_generate_crc(&s_delivered[i], SENSIRION_WORD_SIZE) == s_delivered[i + 2];
+    }
+    if ((error == NO_ERROR) != (!s_bus_failed && crcs_match)) {
+        abort();
+    }
+    if (error != NO_ERROR) {
+        return 0;
+    }
+    for (uint8_t i = 0; i < 3; i++) {
+        if (sensirion_common_bytes_to_uint16_t(&s_delivered[i * 3]) != words[i]) {
+            abort();
+        }
+    }
+    return 0;
+}
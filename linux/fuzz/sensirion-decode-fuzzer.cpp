@@ -0,0 +1,65 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* libFuzzer target for the response decoders.
+ *
+ * Input: one byte giving the number of words, then the received frame. The frame is copied into a buffer of exactly
+ * num_words * 3 bytes, padded with zeros if the input is short, so the sanitizers catch any access past it.
+ * sensirion_i2c_decode_words() and sensirion_i2c_compact_words_inplace() must agree on the result, accept a frame
+ * exactly when every word's CRC matches, and on success the frame must encode back from the decoded words. */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include "sensirion_common.h"
+#include "sensirion_i2c.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    if (size == 0) {
+        return 0;
+    }
+    uint16_t num_words = data[0] % (SENSIRION_MAX_BUFFER_WORDS + 1);
+    size_t frame_size = (size_t)num_words * (SENSIRION_WORD_SIZE + CRC8_LEN);
+    std::vector<uint8_t> frame(frame_size);
+    if (frame_size > 0) {
+        memcpy(frame.data(), data + 1, size - 1 < frame_size ? size - 1 : frame_size);
+    }
+
+    bool crcs_match = true;
+    for (size_t i = 0; i < frame_size; i += SENSIRION_WORD_SIZE + CRC8_LEN) {
+        crcs_match = crcs_match && sensirion_i2c_generate_crc(&frame[i], SENSIRION_WORD_SIZE) == frame[i + 2];
+    }
+
+    std::vector<uint16_t> words(num_words);
+    int16_t decode_error = sensirion_i2c_decode_words(frame.data(), words.data(), num_words);
+    std::vector<uint8_t> compacted(frame);
+    int16_t compact_error = sensirion_i2c_compact_words_inplace(compacted.data(), num_words);
+
+    if (decode_error != compact_error || (decode_error == NO_ERROR) != crcs_match) {
+        abort();
+    }
+    if (decode_error != NO_ERROR) {
+        return 0;
+    }
+    std::vector<uint8_t> encoded(frame_size);
+    uint16_t offset = 0;
+    for (uint16_t i = 0; i < num_words; i++) {
+        if (sensirion_common_bytes_to_uint16_t(&compacted[i * SENSIRION_WORD_SIZE]) != words[i]) {
+            abort();
+        }
+        offset = sensirion_i2c_add_uint16_t_to_buffer(encoded.data(), offset, words[i]);
+    }
+    if (encoded != frame) {
+        abort();
+    }
+    return 0;
+}
@@ -0,0 +1,138 @@
+#!/usr/bin/env python3
+#
+# This example code is in the Public Domain (or CC0 licensed, at your option.)
+#
+# Unless required by applicable law or agreed to in writing, this
+# software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+# CONDITIONS OF ANY KIND, either express or implied.
+
+"""Download the measurement history from a commissioned air-quality-sensor-app
+over Bulk Data Exchange and check the file.
+
+Sends a Diagnostic Logs RetrieveLogsRequest (EndUserSupport intent, BDX) to
+endpoint 0 with chip-tool, so the whole path runs: the Diagnostic Logs
+server, the BDX transfer and HistoryLogProvider generating the CSV a block at
+a time. The received file must have the history header, whole lines only,
+times on the interval grid in increasing order and, with --load-stats, CO2
+averages within the range the app published. Prints the size, the number of
+records and how long chip-tool took.
+
+Not yet run against a live device: the chip-tool invocation and where it
+stores the file follow the README's ESP32 instructions and may need
+--output for a given chip-tool build.
+
+    ./out/host/air-quality-sensor-app --load-stats /tmp/load.csv &
+    chip-tool pairing onnetwork 1 20202021
+    (wait for a few history intervals)
+    ./history-download.py --node-id 1 --load-stats /tmp/load.csv
+"""
+
+import argparse
+import csv
+import os
+import subprocess
+import sys
+import time
+
+HEADER = "time_s,co2_ppm,temperature_c,humidity_percent"
+INTENT_END_USER_SUPPORT = 0
+PROTOCOL_BDX = 1
+
+
+def download(args, output):
+    if os.path.exists(output):
+        os.remove(output)
+    command = [args.chip_tool, "diagnosticlogs", "retrieve-logs-request",
+               str(INTENT_END_USER_SUPPORT), str(PROTOCOL_BDX),
+               str(args.node_id), "0",
+               "--TransferFileDesignator", args.designator]
+    if args.storage_directory:
+        command += ["--storage-directory", args.storage_directory]
+    if args.commissioner_name:
+        command += ["--commissioner-name", args.commissioner_name]
+    start = time.monotonic()
+    result = subprocess.run(command, stdout=subprocess.PIPE,
+                            stderr=subprocess.STDOUT, text=True)
+    elapsed = time.monotonic() - start
+    if result.returncode != 0:
+        sys.exit(f"chip-tool failed ({result.returncode}):\n"
+                 + result.stdout[-2000:])
+    if not os.path.exists(output):
+        sys.exit(f"{output} not found after the download; pass --output "
+                 f"with where this chip-tool stores BDX files")
+    return elapsed
+
+
+def published_range(path):
+    with open(path, newline="") as f:
+        values = [int(row["co2_ppm"]) for row in csv.DictReader(f)]
+    return (min(values), max(values)) if values else None
+
+
+def check(path, interval_s, co2_range):
+    """Problems found in the downloaded file, and its record count."""
+    with open(path, "rb") as f:
+        data = f.read()
+    problems = []
+    if not data.endswith(b"\n"):
+        problems.append("file does not end with a whole line")
+    lines = data.decode("ascii", errors="replace").splitlines()
+    if not lines or lines[0] != HEADER:
+        problems.append(f"header is {lines[0] if lines else None!r}")
+        return problems, 0
+    previous = None
+    for number, line in enumerate(lines[1:], start=2):
+        fields = line.split(",")
+        try:
+            time_s, co2_ppm = int(fields[0]), int(fields[1])
+            float(fields[2]), float(fields[3])
+        except (IndexError, ValueError):
+            problems.append(f"line {number}: {line!r}")
+            continue
+        if len(fields) != 4:
+            problems.append(f"line {number}: {len(fields)} fields")
+        if time_s % interval_s != 0:
+            problems.append(f"line {number}: {time_s} s is off the grid")
+        if previous is not None and time_s <= previous:
+            problems.append(f"line {number}: time goes back to {time_s} s")
+        if co2_range and not co2_range[0] <= co2_ppm <= co2_range[1]:
+            problems.append(f"line {number}: {co2_ppm} ppm outside the "
+                            f"published {co2_range[0]}-{co2_range[1]}")
+        previous = time_s
+    return problems, len(lines) - 1
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description=__doc__.split("\n\n")[0],
+        formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--node-id", type=int, required=True)
+    parser.add_argument("--chip-tool", default="chip-tool")
+    parser.add_argument("--storage-directory")
+    parser.add_argument("--commissioner-name")
+    parser.add_argument("--designator", default="history.csv",
+                        help="TransferFileDesignator sent to the device")
+    parser.add_argument("--output",
+                        help="where chip-tool stores the received file "
+                        "(default /tmp/<designator>)")
+    parser.add_argument("--interval-s", type=int, default=60,
+                        help="CONFIG_SENSOR_HISTORY_INTERVAL_S of the app")
+    parser.add_argument("--load-stats",
+                        help="CSV written by the app's --load-stats, to "
+                        "check the CO2 values against")
+    args = parser.parse_args()
+
+    output = args.output or os.path.join("/tmp", args.designator)
+    elapsed = download(args, output)
+    co2_range = published_range(args.load_stats) if args.load_stats else None
+    problems, records = check(output, args.interval_s, co2_range)
+    print(f"{os.path.getsize(output)} bytes, {records} records, "
+          f"chip-tool took {elapsed:.2f} s")
+    for problem in problems[:20]:
+        print(problem)
+    if problems:
+        sys.exit(f"{len(problems)} problems in {output}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,19 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <lib/support/logging/CHIPLogging.h>
+
+/* ESP-IDF logging for the sources shared with the ESP32 build, through the CHIP log. CHIP has no warning level, so
+ * warnings go out as progress messages. */
+#define ESP_LOGE(tag, format, ...) ChipLogError(NotSpecified, "%s: " format, tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) ChipLogProgress(NotSpecified, "%s: " format, tag, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) ChipLogProgress(NotSpecified, "%s: " format, tag, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) ChipLogDetail(NotSpecified, "%s: " format, tag, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) ChipLogDetail(NotSpecified, "%s: " format, tag, ##__VA_ARGS__)
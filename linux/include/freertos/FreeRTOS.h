@@ -0,0 +1,22 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <pthread.h>
+
+/* The FreeRTOS critical sections used by the sources shared with the ESP32 build, as mutexes. None of those sources
+ * nests them. */
+typedef pthread_mutex_t portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED PTHREAD_MUTEX_INITIALIZER
+
+#define taskENTER_CRITICAL(mux) pthread_mutex_lock(mux)
+#define taskEXIT_CRITICAL(mux) pthread_mutex_unlock(mux)
+#define portENTER_CRITICAL(mux) pthread_mutex_lock(mux)
+#define portEXIT_CRITICAL(mux) pthread_mutex_unlock(mux)
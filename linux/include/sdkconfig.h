@@ -0,0 +1,34 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+/* Kconfig values used by the sources shared with the ESP32 build, at their defaults in main/Kconfig.projbuild */
+#define CONFIG_SENSOR_FILTER 1
+#define CONFIG_SENSOR_FILTER_OUTLIER_PPM 0
+#define CONFIG_SENSOR_FILTER_MEDIAN_WINDOW 3
+#define CONFIG_SENSOR_FILTER_EMA_SHIFT 0
+#define CONFIG_SENSOR_FILTER_KALMAN 0
+
+/* The Linux data model comes from the upstream ZAP file, whose clusters are served by AirQualitySensorManager */
+#define CONFIG_SENSOR_PUBLISHER_CLUSTER_INSTANCE 1
+
+#define CONFIG_SENSOR_VENDOR_ID 0xFFF1
+
+#define CONFIG_SENSOR_EVENTS_CO2_THRESHOLDS "1000,1500"
+#define CONFIG_SENSOR_EVENTS_CO2_HYSTERESIS_PPM 50
+#define CONFIG_SENSOR_EVENTS_BACKLOG 96
+
+#define CONFIG_SENSOR_HISTORY_RECORDS 1440
+#define CONFIG_SENSOR_HISTORY_INTERVAL_S 60
+
+#define CONFIG_SENSOR_ROLLUP_MINUTES 60
+#define CONFIG_SENSOR_ROLLUP_HOURS 48
+#define CONFIG_SENSOR_ROLLUP_DAYS 14
+#define CONFIG_SENSOR_ROLLUP_MAX_HOLD_S 300
+#define CONFIG_SENSOR_ROLLUP_EXPOSURE_PPM 1000
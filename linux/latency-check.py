@@ -0,0 +1,192 @@
+#!/usr/bin/env python3
+#
+# This example code is in the Public Domain (or CC0 licensed, at your option.)
+#
+# Unless required by applicable law or agreed to in writing, this
+# software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+# CONDITIONS OF ANY KIND, either express or implied.
+
+"""Subscriber-side check of how old a CO2 value is when a controller sees it.
+
+Subscribes to CO2 MeasuredValue on an air-quality-sensor-app that is already
+commissioned with chip-tool and runs with --load-stats, then matches every
+report with the sample that produced it. The app stamps each sample when its
+I2C read completes and again when it is published, in CLOCK_REALTIME, and
+both run on the same host, so each report splits into device time (read to
+publish) and delivery time (publish to arrival at chip-tool, which includes
+the report engine, the min interval and the network).
+
+The read stamp is taken by load_stats::on_read() as the read returns, and
+the publish stamp once the whole sample_path has run, events, history and
+rollups included. Both are CLOCK_REALTIME, unlike the sample path itself,
+which runs on virtual_clock and so on the sped-up sensor clock whenever
+--sample-period-ms is below 5000. The app runs the same latency tracer as the
+ESP32, but without its console, so only this side's figures are printed.
+
+Not yet run against a live device: the matching has only been exercised
+offline, on synthetic --load-stats rows and chip-tool lines.
+
+Prints the count, mean, percentiles and a histogram of each part, with the
+same buckets as the ESP32 `latency stats` command; --csv keeps every match.
+
+    ./out/host/air-quality-sensor-app --load-stats /tmp/load.csv &
+    chip-tool pairing onnetwork 1 20202021
+    ./latency-check.py --load-stats /tmp/load.csv --node-id 1 --duration 300
+"""
+
+import argparse
+import csv
+import re
+import statistics
+import subprocess
+import sys
+import threading
+import time
+
+BUCKET_LIMITS_MS = [1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000,
+                    10000, 60000]
+PERCENTILES = [50, 90, 95, 99, 99.9]
+
+LOG_TIME_RE = re.compile(r"^\[(\d+\.\d+)\]")
+REPORT_RE = re.compile(r"CHIP:TOO:\s+MeasuredValue:\s+(-?[0-9.]+)")
+
+
+def percentile(ordered, fraction):
+    return ordered[min(len(ordered) - 1, int(fraction * len(ordered)))]
+
+
+def read_samples(path):
+    with open(path, newline="") as f:
+        return [{key: int(value) for key, value in row.items()}
+                for row in csv.DictReader(f)]
+
+
+def collect_reports(args):
+    command = [args.chip_tool, "interactive", "start"]
+    if args.storage_directory:
+        command += ["--storage-directory", args.storage_directory]
+    if args.commissioner_name:
+        command += ["--commissioner-name", args.commissioner_name]
+    process = subprocess.Popen(command, stdin=subprocess.PIPE,
+                               stdout=subprocess.PIPE,
+                               stderr=subprocess.STDOUT, text=True, bufsize=1)
+    reports = []
+
+    def read_output():
+        for line in process.stdout:
+            report = REPORT_RE.search(line)
+            if report:
+                match = LOG_TIME_RE.match(line)
+                arrival = float(match.group(1)) if match else time.time()
+                reports.append((arrival, int(float(report.group(1)))))
+
+    reader = threading.Thread(target=read_output, daemon=True)
+    reader.start()
+    process.stdin.write(
+        f"carbondioxideconcentrationmeasurement subscribe measured-value "
+        f"{args.min_interval} {args.max_interval} {args.node_id} 1\n")
+    process.stdin.flush()
+    time.sleep(args.duration)
+    try:
+        process.stdin.write("quit()\n")
+        process.stdin.flush()
+        process.wait(timeout=5)
+    except (OSError, subprocess.TimeoutExpired):
+        process.kill()
+    reader.join(timeout=1)
+    return reports
+
+
+def match(reports, samples, window_s):
+    """(arrival, value, read, publish) for every report, against the latest
+    sample published before it with the reported value."""
+    matches = []
+    unmatched = 0
+    for arrival, value in reports:
+        found = None
+        for sample in reversed(samples):
+            published = sample["time_us"] / 1e6
+            if published > arrival:
+                continue
+            if arrival - published > window_s:
+                break
+            if sample["co2_ppm"] == value:
+                found = (arrival, value, sample["read_time_us"] / 1e6,
+                         published)
+                break
+        if found is None:
+            unmatched += 1
+        else:
+            matches.append(found)
+    return matches, unmatched
+
+
+def print_distribution(name, values_ms):
+    ordered = sorted(values_ms)
+    line = (f"{name}: count {len(ordered)} min {ordered[0]:.1f} "
+            f"mean {statistics.mean(ordered):.1f}")
+    for p in PERCENTILES:
+        line += f" p{p:g} {percentile(ordered, p / 100):.1f}"
+    print(line + f" max {ordered[-1]:.1f} (ms)")
+
+
+def print_histogram(columns):
+    names = list(columns)
+    print("bucket_le_ms," + ",".join(names))
+    for i in range(len(BUCKET_LIMITS_MS) + 1):
+        low = BUCKET_LIMITS_MS[i - 1] if i > 0 else float("-inf")
+        high = BUCKET_LIMITS_MS[i] if i < len(BUCKET_LIMITS_MS) else None
+        counts = [sum(1 for v in columns[name]
+                      if v > low and (high is None or v <= high))
+                  for name in names]
+        label = str(high) if high is not None else "inf"
+        print(label + "," + ",".join(str(c) for c in counts))
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description=__doc__.split("\n\n")[0],
+        formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--load-stats", required=True,
+                        help="CSV written by the app's --load-stats")
+    parser.add_argument("--node-id", type=int, required=True)
+    parser.add_argument("--chip-tool", default="chip-tool")
+    parser.add_argument("--storage-directory")
+    parser.add_argument("--commissioner-name")
+    parser.add_argument("--min-interval", type=int, default=0)
+    parser.add_argument("--max-interval", type=int, default=60)
+    parser.add_argument("--duration", type=float, default=120,
+                        help="seconds to stay subscribed")
+    parser.add_argument("--csv", help="write every matched report here")
+    args = parser.parse_args()
+
+    reports = collect_reports(args)
+    samples = read_samples(args.load_stats)
+    matches, unmatched = match(reports, samples, args.max_interval + 5)
+    if not matches:
+        sys.exit(f"no report matched a sample ({len(reports)} reports, "
+                 f"{len(samples)} samples)")
+
+    columns = {
+        "device": [(m[3] - m[2]) * 1000 for m in matches],
+        "delivery": [(m[0] - m[3]) * 1000 for m in matches],
+        "total": [(m[0] - m[2]) * 1000 for m in matches],
+    }
+    print(f"{len(reports)} reports, {unmatched} unmatched")
+    for name, values in columns.items():
+        print_distribution(name, values)
+    print_histogram(columns)
+
+    if args.csv:
+        with open(args.csv, "w", newline="") as f:
+            writer = csv.writer(f)
+            writer.writerow(["arrival_s", "co2_ppm", "read_s", "publish_s",
+                             "total_ms"])
+            for arrival, value, read, published in matches:
+                writer.writerow([f"{arrival:.6f}", value, f"{read:.6f}",
+                                 f"{published:.6f}",
+                                 f"{(arrival - read) * 1000:.3f}"])
+
+
+if __name__ == "__main__":
+    main()
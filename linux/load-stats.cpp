@@ -0,0 +1,74 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <load-stats.h>
+
+#include <inttypes.h>
+#include <malloc.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <app/InteractionModelEngine.h>
+#include <lib/support/logging/CHIPLogging.h>
+
+namespace load_stats {
+
+static FILE *s_file;
+static uint32_t s_seq;
+static int64_t s_last_cpu_us;
+static size_t s_heap_peak_bytes;
+static int64_t s_read_time_us;
+
+static int64_t clock_us(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+bool init(const char *path)
+{
+    s_file = fopen(path, "w");
+    if (s_file == nullptr) {
+        ChipLogError(NotSpecified, "Failed to open %s", path);
+        return false;
+    }
+    fprintf(s_file, "seq,time_us,read_time_us,co2_ppm,air_quality,cpu_us,heap_bytes,heap_peak_bytes,subscriptions\n");
+    fflush(s_file);
+    s_last_cpu_us = clock_us(CLOCK_PROCESS_CPUTIME_ID);
+    return true;
+}
+
+void on_read()
+{
+    s_read_time_us = clock_us(CLOCK_REALTIME);
+}
+
+void on_sample(const measurement_pipeline::result_t &result)
+{
+    if (s_file == nullptr) {
+        return;
+    }
+
+    int64_t cpu_us = clock_us(CLOCK_PROCESS_CPUTIME_ID);
+    size_t heap_bytes = mallinfo2().uordblks;
+    if (heap_bytes > s_heap_peak_bytes) {
+        s_heap_peak_bytes = heap_bytes;
+    }
+    uint32_t subscriptions = chip::app::InteractionModelEngine::GetInstance()->GetNumActiveReadHandlers(
+        chip::app::ReadHandler::InteractionType::Subscribe);
+
+    fprintf(s_file, "%" PRIu32 ",%" PRId64 ",%" PRId64 ",%u,%d,%" PRId64 ",%zu,%zu,%" PRIu32 "\n", s_seq++,
+            clock_us(CLOCK_REALTIME), s_read_time_us, result.co2_ppm, result.air_quality, cpu_us - s_last_cpu_us,
+            heap_bytes, s_heap_peak_bytes, subscriptions);
+    /* The harness tails the file while the device runs */
+    fflush(s_file);
+    s_last_cpu_us = cpu_us;
+}
+
+} // namespace load_stats
@@ -0,0 +1,37 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <measurement-pipeline.h>
+
+/** Per-sample load figures for the subscription scale harness and the latency checker
+ *
+ * One CSV line per published sample: `seq,time_us,read_time_us,co2_ppm,air_quality,cpu_us,heap_bytes,
+ * heap_peak_bytes,subscriptions`. `time_us` (publish) and `read_time_us` (I2C read complete) are CLOCK_REALTIME,
+ * so they line up with the report times seen by controllers on the same host; `cpu_us` is process CPU time since
+ * the previous sample, which covers the reports generated for it; heap figures are glibc bytes in use at the sample
+ * and the largest value seen at any sample so far.
+ */
+namespace load_stats {
+
+/** Start writing the figures to `path`, truncating it; without a call nothing is recorded
+ *
+ * @return true if the file could be opened.
+ */
+bool init(const char *path);
+
+/** Note the CLOCK_REALTIME of a read that just completed; the next `on_sample()` reports it as `read_time_us` */
+void on_read();
+
+/** Record a sample that was just published; must be called from the Matter event loop */
+void on_sample(const measurement_pipeline::result_t &result);
+
+} // namespace load_stats
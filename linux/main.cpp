@@ -0,0 +1,195 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <AppMain.h>
+#include <lib/support/CHIPArgParser.hpp>
+#include <lib/support/logging/CHIPLogging.h>
+#include <platform/CHIPDeviceLayer.h>
+#include <system/SystemClock.h>
+
+#include <attribute-publisher.h>
+#include <deadline-grid.h>
+#include <latency-trace.h>
+#include <load-stats.h>
+#include <measurement-pipeline.h>
+#include <sample-path.h>
+#include <sensor-events.h>
+#include <sensor-history.h>
+#include <virtual-clock.h>
+
+#include <time.h>
+
+#include "drivers/scd4x_i2c.h"
+#include "drivers/sensirion_common.h"
+#include "drivers/sensirion_i2c_hal.h"
+
+using namespace chip;
+
+/* Air quality device on a simulated SCD4x, commissionable over IP. Every sample goes through sample_path like on the
+ * ESP32: the same pipeline, publisher (its cluster instance policy), events, history and rollups. */
+
+static constexpr EndpointId k_root_endpoint_id = 0;
+static constexpr EndpointId k_endpoint_id = 1;
+/* Periodic measurement interval of the sensor */
+static constexpr uint32_t k_sensor_period_ms = 5000;
+
+static uint32_t s_sample_period_ms = k_sensor_period_ms;
+static uint64_t s_clock_origin_us;
+/* Sampling deadlines, in real monotonic time */
+static deadline_grid::grid_t s_grid;
+
+/* With a shorter sample period the simulated sensor runs on a clock that is sped up to match, so it still has a new
+ * measurement every period. virtual_clock reads the same clock, so the history and rollup intervals speed up too. */
+static uint64_t monotonic_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static uint64_t scaled_get_time_usec()
+{
+    return s_clock_origin_us + (monotonic_us() - s_clock_origin_us) * k_sensor_period_ms / s_sample_period_ms;
+}
+
+static void scaled_sleep_usec(uint32_t useconds)
+{
+    uint64_t real_us = (uint64_t)useconds * s_sample_period_ms / k_sensor_period_ms;
+    struct timespec ts = { (time_t)(real_us / 1000000), (long)(real_us % 1000000) * 1000 };
+    nanosleep(&ts, nullptr);
+}
+
+static const sensirion_i2c_hal_clock_t s_scaled_clock = {
+    .get_time_usec = scaled_get_time_usec,
+    .sleep_usec = scaled_sleep_usec,
+};
+
+enum {
+    k_option_sample_period_ms = 0x2000,
+    k_option_load_stats,
+};
+
+static bool handle_option(const char *program, ArgParser::OptionSet *options, int id, const char *name,
+                          const char *value)
+{
+    switch (id) {
+    case k_option_sample_period_ms:
+        if (!ArgParser::ParseInt(value, s_sample_period_ms) || s_sample_period_ms == 0 ||
+            s_sample_period_ms > k_sensor_period_ms) {
+            ArgParser::PrintArgError("%s: invalid value for %s: %s\n", program, name, value);
+            return false;
+        }
+        return true;
+    case k_option_load_stats:
+        return load_stats::init(value);
+    default:
+        ArgParser::PrintArgError("%s: INTERNAL ERROR: unhandled option: %s\n", program, name);
+        return false;
+    }
+}
+
+static ArgParser::OptionDef s_option_defs[] = {
+    { "sample-period-ms", ArgParser::kArgumentRequired, k_option_sample_period_ms },
+    { "load-stats", ArgParser::kArgumentRequired, k_option_load_stats },
+    {},
+};
+
+static ArgParser::OptionSet s_options = {
+    handle_option, s_option_defs, "AIR QUALITY OPTIONS",
+    "  --sample-period-ms <ms>\n"
+    "       Publish a sample every <ms> (at most 5000, the default) by speeding up the simulated sensor.\n"
+    "\n"
+    "  --load-stats <file>\n"
+    "       Write per-sample CPU, heap and subscription figures to <file> as CSV.\n"
+    "\n"
+};
+
+static void sample_timer_cb(System::Layer *layer, void *context);
+
+/* Arm for a deadline on the grid started by ApplicationInit(), so the time spent sampling and any delay of the event
+ * loop do not add up */
+static void start_sample_timer(System::Layer *layer, void *context, int64_t deadline_us)
+{
+    int64_t now_us = (int64_t)monotonic_us();
+    /* Rounded up, so the timer never fires before the deadline */
+    uint32_t delay_ms = deadline_us > now_us ? (uint32_t)((deadline_us - now_us + 999) / 1000) : 0;
+    layer->StartTimer(System::Clock::Milliseconds32(delay_ms), sample_timer_cb, context);
+}
+
+/* Runs in the Matter event loop, so both halves of sample_path run here, one after the other. Deadlines the loop
+ * missed are skipped rather than sampled in a burst. */
+static void sample_timer_cb(System::Layer *layer, void *context)
+{
+    int64_t deadline_us;
+    int64_t next_deadline_us = deadline_grid::advance(&s_grid, (int64_t)monotonic_us(), &deadline_us);
+
+    bool data_ready = false;
+    int16_t error = scd4x_get_data_ready_status(&data_ready);
+    if (error == NO_ERROR && data_ready) {
+        scd4x_measurement_raw_t raw;
+        error = scd4x_read_measurement_raw(&raw.co2_concentration, &raw.temperature, &raw.relative_humidity);
+        if (error == NO_ERROR) {
+            load_stats::on_read();
+            measurement_pipeline::result_t result;
+            sample_path::on_read(raw, virtual_clock::now_us(), &result);
+            sample_path::on_event_loop(result);
+            load_stats::on_sample(result);
+        }
+    }
+    if (error != NO_ERROR) {
+        ChipLogError(NotSpecified, "Failed to read measurement, error:%d", error);
+    }
+
+    start_sample_timer(layer, context, next_deadline_us);
+}
+
+void ApplicationInit()
+{
+    sensirion_i2c_hal_init();
+    if (s_sample_period_ms != k_sensor_period_ms) {
+        s_clock_origin_us = monotonic_us();
+        sensirion_i2c_hal_set_clock(&s_scaled_clock);
+    }
+    scd4x_init(0x62);
+    int16_t error = scd4x_start_periodic_measurement();
+    if (error != NO_ERROR) {
+        ChipLogError(NotSpecified, "Failed to start periodic measurement, error:%d", error);
+    }
+
+    attribute_publisher::init(k_endpoint_id);
+    if (latency_trace::init(k_endpoint_id) != ESP_OK) {
+        ChipLogError(NotSpecified, "Failed to trace the CO2 report latency");
+    }
+    if (sensor_events::init(k_endpoint_id) != ESP_OK) {
+        ChipLogError(NotSpecified, "Failed to set up the sensor events");
+    }
+    /* The upstream data model has the Diagnostic Logs cluster on the root endpoint */
+    sensor_history::set_log_provider(k_root_endpoint_id);
+
+    s_grid.period_ms = s_sample_period_ms;
+    int64_t now_us = (int64_t)monotonic_us();
+    start_sample_timer(&DeviceLayer::SystemLayer(), nullptr, now_us + deadline_grid::start(&s_grid, now_us, 0));
+}
+
+void ApplicationShutdown()
+{
+    DeviceLayer::SystemLayer().CancelTimer(sample_timer_cb, nullptr);
+    scd4x_stop_periodic_measurement();
+    sensirion_i2c_hal_free();
+}
+
+int main(int argc, char *argv[])
+{
+    if (ChipLinuxAppInit(argc, argv, &s_options) != 0) {
+        return -1;
+    }
+
+    ChipLinuxAppMainLoop();
+
+    return 0;
+}
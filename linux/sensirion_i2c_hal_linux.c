@@ -0,0 +1,87 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+ * Sensirion I2C HAL for the Linux port. There is no I2C bus: transactions go
+ * to the simulated SCD4x by default, and to whatever
+ * sensirion_i2c_hal_set_bus() installs otherwise.
+ */
+
+/* nanosleep(), clock_gettime() and CLOCK_MONOTONIC are POSIX, not C11 */
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <time.h>
+
+#include "scd4x_sim.h"
+#include "sensirion_common.h"
+#include "sensirion_config.h"
+#include "sensirion_i2c_hal.h"
+
+int16_t sensirion_i2c_hal_select_bus(uint8_t bus_idx) {
+    (void)bus_idx;
+    return NOT_IMPLEMENTED_ERROR;
+}
+
+void sensirion_i2c_hal_init(void) {
+}
+
+void sensirion_i2c_hal_free(void) {
+}
+
+static const sensirion_i2c_hal_bus_t* volatile hal_bus = &scd4x_sim_bus;
+
+/**
+ * NULL restores the simulated sensor, which stands in for the hardware bus.
+ */
+void sensirion_i2c_hal_set_bus(const sensirion_i2c_hal_bus_t* bus) {
+    hal_bus = bus ? bus : &scd4x_sim_bus;
+}
+
+int8_t sensirion_i2c_hal_read(uint8_t address, uint8_t* data, uint8_t count) {
+    return hal_bus->read(address, data, count);
+}
+
+int8_t sensirion_i2c_hal_write(uint8_t address, const uint8_t* data,
+                               uint8_t count) {
+    return hal_bus->write(address, data, count);
+}
+
+static void sensirion_i2c_hal_real_sleep_usec(uint32_t useconds) {
+    struct timespec ts = {
+        .tv_sec = useconds / 1000000,
+        .tv_nsec = (long)(useconds % 1000000) * 1000,
+    };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+}
+
+static uint64_t sensirion_i2c_hal_real_get_time_usec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+static const sensirion_i2c_hal_clock_t real_clock = {
+    .get_time_usec = sensirion_i2c_hal_real_get_time_usec,
+    .sleep_usec = sensirion_i2c_hal_real_sleep_usec,
+};
+
+static const sensirion_i2c_hal_clock_t* volatile hal_clock = &real_clock;
+
+void sensirion_i2c_hal_set_clock(const sensirion_i2c_hal_clock_t* clock) {
+    hal_clock = clock ? clock : &real_clock;
+}
+
+void sensirion_i2c_hal_sleep_usec(uint32_t useconds) {
+    hal_clock->sleep_usec(useconds);
+}
+
+uint64_t sensirion_i2c_hal_get_time_usec(void) {
+    return hal_clock->get_time_usec();
+}
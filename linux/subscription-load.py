@@ -0,0 +1,348 @@
+#!/usr/bin/env python3
+#
+# This example code is in the Public Domain (or CC0 licensed, at your option.)
+#
+# Unless required by applicable law or agreed to in writing, this
+# software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+# CONDITIONS OF ANY KIND, either express or implied.
+
+"""Subscription scale harness for the Linux build.
+
+Starts air-quality-sensor-app with a fresh KVS, commissions it into M fabrics
+with chip-tool, then opens N subscriptions to the CO2 MeasuredValue and
+AirQuality attributes, spread round-robin over the fabrics and over the given
+min/max intervals. The device publishes a sample every --sample-period-ms and
+writes its per-sample CPU time, heap and subscription count (--load-stats);
+chip-tool's output gives the time every report arrived. Both run on the same
+host, so report latency is the arrival time minus the time the device
+completed the I2C read of the sample that produced the value.
+
+CPU time per report is the device's CPU time while subscribed, minus the
+per-sample cost measured before any subscription, divided by the reports
+received. Heap figures are the glibc in-use peak seen at samples and the
+process's peak RSS (VmHWM). Every sample goes through the same sample_path
+as on the ESP32, so the per-sample cost includes the attribute publisher, the
+latency tracer, the events, the history and the rollups, not only reporting.
+
+Not yet run against a live device: report matching has only been exercised
+offline, on synthetic --load-stats rows and chip-tool lines; the chip-tool
+command lines and log patterns follow the README and may need adjusting for
+a given chip-tool build.
+
+Example, sweeping subscriptions on three fabrics:
+
+    for n in 3 6 12 24 48; do
+        ./subscription-load.py --app out/host/air-quality-sensor-app \\
+            --chip-tool $CHIP_TOOL --subscriptions $n --fabrics 3 \\
+            --sample-period-ms 1000 --summary sweep.csv
+    done
+"""
+
+import argparse
+import csv
+import os
+import re
+import shutil
+import statistics
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+SETUP_PIN_CODE = 20202021
+
+# chip-tool commissioner names map to fabric ids 1, 2, 3; higher fabric ids
+# are given by number.
+COMMISSIONER_NAMES = ["alpha", "beta", "gamma"]
+
+ATTRIBUTES = [
+    ("carbondioxideconcentrationmeasurement", "measured-value"),
+    ("airquality", "air-quality"),
+]
+
+LOG_TIME_RE = re.compile(r"^\[(\d+\.\d+)\]")
+REPORT_RE = re.compile(r"CHIP:TOO:\s+(MeasuredValue|AirQuality):\s+(-?[0-9.]+)")
+ESTABLISHED_RE = re.compile(r"Subscription established")
+MANUAL_CODE_RE = re.compile(r"Manual pairing code: \[(\d+)\]")
+
+
+def commissioner_name(fabric):
+    if fabric < len(COMMISSIONER_NAMES):
+        return COMMISSIONER_NAMES[fabric]
+    return str(fabric + 1)
+
+
+def percentile(values, fraction):
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(fraction * len(ordered)))]
+
+
+class ChipTool:
+    """One chip-tool process per fabric, in interactive mode so its
+    subscriptions stay open."""
+
+    def __init__(self, args, fabric):
+        self.args = args
+        self.fabric = fabric
+        self.name = commissioner_name(fabric)
+        self.reports = []  # (arrival time s, attribute, value)
+        self.established = 0
+        self.lock = threading.Lock()
+        self.process = None
+
+    def common_args(self):
+        return ["--storage-directory", self.args.storage,
+                "--commissioner-name", self.name]
+
+    def run(self, command, timeout=120):
+        result = subprocess.run(
+            [self.args.chip_tool] + command + self.common_args(),
+            stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True,
+            timeout=timeout)
+        if result.returncode != 0:
+            sys.stdout.write(result.stdout[-4000:])
+            raise RuntimeError(f"chip-tool {' '.join(command)} failed "
+                               f"on fabric {self.name}")
+        return result.stdout
+
+    def start_interactive(self):
+        self.process = subprocess.Popen(
+            [self.args.chip_tool, "interactive", "start"] + self.common_args(),
+            stdin=subprocess.PIPE, stdout=subprocess.PIPE,
+            stderr=subprocess.STDOUT, text=True, bufsize=1)
+        threading.Thread(target=self._read_output, daemon=True).start()
+
+    def subscribe(self, cluster, attribute, min_interval, max_interval):
+        self.process.stdin.write(
+            f"{cluster} subscribe {attribute} {min_interval} {max_interval} "
+            f"{self.args.node_id} 1 --keepSubscriptions true\n")
+        self.process.stdin.flush()
+
+    def stop(self):
+        if self.process is None:
+            return
+        try:
+            self.process.stdin.write("quit()\n")
+            self.process.stdin.flush()
+            self.process.wait(timeout=5)
+        except (OSError, subprocess.TimeoutExpired):
+            self.process.kill()
+
+    def _read_output(self):
+        for line in self.process.stdout:
+            now = time.time()
+            match = LOG_TIME_RE.match(line)
+            arrival = float(match.group(1)) if match else now
+            report = REPORT_RE.search(line)
+            with self.lock:
+                if report:
+                    self.reports.append((arrival, report.group(1),
+                                         int(float(report.group(2)))))
+                elif ESTABLISHED_RE.search(line):
+                    self.established += 1
+
+
+def read_load_stats(path):
+    with open(path, newline="") as f:
+        return [{key: int(value) for key, value in row.items()}
+                for row in csv.DictReader(f)]
+
+
+def vm_hwm_kb(pid):
+    try:
+        with open(f"/proc/{pid}/status") as f:
+            for line in f:
+                if line.startswith("VmHWM:"):
+                    return int(line.split()[1])
+    except OSError:
+        pass
+    return 0
+
+
+def match_latencies(reports, samples, window_s):
+    """Latency of every report against the sample that produced its value.
+
+    CO2 changes with nearly every sample, so a CO2 report belongs to the
+    latest sample at or before it with the reported value. AirQuality only
+    changes now and then: its report belongs to the first sample of the run
+    of equal values, and when that run started more than window_s earlier
+    the report is a max-interval heartbeat and has no latency."""
+    latencies = []
+    unmatched = 0
+    for arrival, attribute, value in reports:
+        key = "co2_ppm" if attribute == "MeasuredValue" else "air_quality"
+        source = None
+        for sample in reversed(samples):
+            if sample["time_us"] / 1e6 > arrival:
+                continue
+            sample_s = sample["read_time_us"] / 1e6
+            if sample[key] == value:
+                source = sample_s
+                if key == "co2_ppm":
+                    break
+            elif source is not None:
+                break
+            if arrival - sample_s > window_s:
+                break
+        if source is None:
+            unmatched += 1
+        elif arrival - source <= window_s:
+            latencies.append(arrival - source)
+    return latencies, unmatched
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description=__doc__.split("\n\n")[0],
+        formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--app", required=True,
+                        help="air-quality-sensor-app executable")
+    parser.add_argument("--chip-tool", default="chip-tool",
+                        help="chip-tool executable")
+    parser.add_argument("--subscriptions", type=int, default=6)
+    parser.add_argument("--fabrics", type=int, default=2)
+    parser.add_argument("--min-intervals", default="0,1,5",
+                        help="comma-separated, used round-robin")
+    parser.add_argument("--max-intervals", default="10,30,60",
+                        help="comma-separated, used round-robin")
+    parser.add_argument("--sample-period-ms", type=int, default=1000,
+                        help="device sample period, at most 5000")
+    parser.add_argument("--baseline", type=float, default=20,
+                        help="seconds sampled before subscribing")
+    parser.add_argument("--duration", type=float, default=120,
+                        help="seconds measured with all subscriptions open")
+    parser.add_argument("--node-id", type=int, default=0x1234)
+    parser.add_argument("--discriminator", type=int, default=3840)
+    parser.add_argument("--work-dir",
+                        help="keep the KVS, chip-tool storage and logs here")
+    parser.add_argument("--summary",
+                        help="append a line of results to this CSV file")
+    args = parser.parse_args()
+
+    min_intervals = [int(v) for v in args.min_intervals.split(",")]
+    max_intervals = [int(v) for v in args.max_intervals.split(",")]
+    work_dir = args.work_dir or tempfile.mkdtemp(prefix="subscription-load-")
+    os.makedirs(work_dir, exist_ok=True)
+    kvs = os.path.join(work_dir, "kvs")
+    args.storage = os.path.join(work_dir, "chip-tool")
+    load_path = os.path.join(work_dir, "load.csv")
+    for path in (kvs, args.storage):
+        if os.path.isdir(path):
+            shutil.rmtree(path)
+        elif os.path.exists(path):
+            os.remove(path)
+    os.makedirs(args.storage)
+
+    device_log = open(os.path.join(work_dir, "device.log"), "w")
+    device = subprocess.Popen(
+        [args.app, "--KVS", kvs, "--discriminator", str(args.discriminator),
+         "--sample-period-ms", str(args.sample_period_ms),
+         "--load-stats", load_path],
+        stdout=device_log, stderr=subprocess.STDOUT)
+    tools = [ChipTool(args, fabric) for fabric in range(args.fabrics)]
+    try:
+        time.sleep(2)
+        print(f"Commissioning into {args.fabrics} fabric(s)")
+        tools[0].run(["pairing", "onnetwork-long", str(args.node_id),
+                      str(SETUP_PIN_CODE), str(args.discriminator)])
+        for tool in tools[1:]:
+            output = tools[0].run(["pairing", "open-commissioning-window",
+                                   str(args.node_id), "1", "300", "1000",
+                                   str(args.discriminator)])
+            code = MANUAL_CODE_RE.search(output)
+            if code is None:
+                raise RuntimeError("no manual pairing code in chip-tool output")
+            tool.run(["pairing", "code", str(args.node_id), code.group(1)])
+
+        print(f"Measuring the idle cost for {args.baseline:.0f} s")
+        baseline_start = time.time()
+        time.sleep(args.baseline)
+        baseline_end = time.time()
+
+        print(f"Opening {args.subscriptions} subscription(s)")
+        for tool in tools:
+            tool.start_interactive()
+        for i in range(args.subscriptions):
+            cluster, attribute = ATTRIBUTES[i % len(ATTRIBUTES)]
+            tools[i % args.fabrics].subscribe(
+                cluster, attribute, min_intervals[i % len(min_intervals)],
+                max_intervals[i % len(max_intervals)])
+        deadline = time.time() + 60
+        while (sum(t.established for t in tools) < args.subscriptions
+               and time.time() < deadline):
+            time.sleep(0.5)
+        # Skip the priming reports sent when the subscriptions were set up
+        time.sleep(max(min_intervals) + args.sample_period_ms / 1000.0)
+
+        print(f"Measuring for {args.duration:.0f} s")
+        measure_start = time.time()
+        time.sleep(args.duration)
+        measure_end = time.time()
+        hwm_kb = vm_hwm_kb(device.pid)
+    finally:
+        for tool in tools:
+            tool.stop()
+        device.terminate()
+        try:
+            device.wait(timeout=5)
+        except subprocess.TimeoutExpired:
+            device.kill()
+        device_log.close()
+
+    samples = read_load_stats(load_path)
+    baseline = [s for s in samples
+                if baseline_start <= s["time_us"] / 1e6 < baseline_end]
+    measured = [s for s in samples
+                if measure_start <= s["time_us"] / 1e6 < measure_end]
+    reports = sorted(r for t in tools for r in t.reports
+                     if measure_start <= r[0] < measure_end)
+    if not baseline or not measured:
+        sys.exit("no samples recorded by the device, see device.log in "
+                 + work_dir)
+
+    idle_cpu_us = statistics.mean(s["cpu_us"] for s in baseline)
+    extra_cpu_us = (sum(s["cpu_us"] for s in measured)
+                    - idle_cpu_us * len(measured))
+    cpu_per_report_us = extra_cpu_us / len(reports) if reports else 0
+    latencies, unmatched = match_latencies(
+        reports, samples,
+        max(min_intervals) + 2 * args.sample_period_ms / 1000.0 + 2)
+    latencies_ms = [l * 1000 for l in latencies] or [0]
+    established = max(s["subscriptions"] for s in measured)
+    heap_peak = max(s["heap_peak_bytes"] for s in samples)
+
+    results = {
+        "subscriptions": args.subscriptions,
+        "fabrics": args.fabrics,
+        "sample_period_ms": args.sample_period_ms,
+        "established": established,
+        "samples": len(measured),
+        "reports": len(reports),
+        "unmatched_reports": unmatched,
+        "idle_cpu_us_per_sample": round(idle_cpu_us),
+        "cpu_us_per_report": round(cpu_per_report_us),
+        "latency_p50_ms": round(percentile(latencies_ms, 0.5), 1),
+        "latency_p95_ms": round(percentile(latencies_ms, 0.95), 1),
+        "latency_max_ms": round(max(latencies_ms), 1),
+        "heap_peak_bytes": heap_peak,
+        "vm_hwm_kb": hwm_kb,
+    }
+    for key, value in results.items():
+        print(f"{key}: {value}")
+    if established < args.subscriptions:
+        print(f"only {established} of {args.subscriptions} subscriptions "
+              "were established")
+    print(f"Logs and load figures in {work_dir}")
+
+    if args.summary:
+        new_file = not os.path.exists(args.summary)
+        with open(args.summary, "a", newline="") as f:
+            writer = csv.DictWriter(f, fieldnames=list(results))
+            if new_file:
+                writer.writeheader()
+            writer.writerow(results)
+
+
+if __name__ == "__main__":
+    main()
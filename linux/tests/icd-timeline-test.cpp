@@ -0,0 +1,70 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* Simulates an hour of radio activity for every power profile and checks how they rank.
+ *
+ * For each publish period the radio-on time per hour is printed as `matter esp icd timeline` prints it on the
+ * device, with the CHIP default ICD timing. The always-on router must cost the whole hour, the sleepy end device with
+ * independent timers less, and the aligned ICD less still. A poll-only profile and a single publish are checked
+ * against their radio-on time worked out by hand. */
+
+#include "test-support.h"
+
+#include <icd-timeline.h>
+
+namespace {
+
+constexpr uint64_t k_hour_ms = 3600ULL * 1000;
+
+/* CHIP defaults, as used by icd-schedule.cpp without the ICD server */
+const icd_timeline::icd_timing_t k_timing = {5000, 200, 300 * 1000, 1000};
+
+const uint32_t k_publish_periods_ms[] = {5000, 30000, 31000, 60000, 300000};
+
+void check_ordering(uint32_t publish_period_ms)
+{
+    icd_timeline::profile_t profiles[icd_timeline::k_profile_count];
+    icd_timeline::build_profiles(publish_period_ms, k_timing, profiles);
+    icd_timeline::print_hour(stdout, profiles, icd_timeline::k_profile_count, "\n");
+
+    uint64_t router_ms = icd_timeline::simulate_radio_on_ms(profiles[0], k_hour_ms);
+    uint64_t independent_ms = icd_timeline::simulate_radio_on_ms(profiles[1], k_hour_ms);
+    uint64_t aligned_ms = icd_timeline::simulate_radio_on_ms(profiles[2], k_hour_ms);
+    TEST_CHECK_EQUAL(router_ms, k_hour_ms);
+    TEST_CHECK(independent_ms < router_ms);
+    TEST_CHECK(aligned_ms < independent_ms);
+    TEST_CHECK(aligned_ms > 0);
+}
+
+void check_hand_worked()
+{
+    /* Slow polls only: one 4 ms poll every 5 s from t = 5 s, the one at exactly 1 h falls outside */
+    icd_timeline::profile_t polls = {"polls", false, 0, 0, 5000, 200, 1000, 0, 0};
+    TEST_CHECK_EQUAL(icd_timeline::simulate_radio_on_ms(polls, k_hour_ms), 719 * 4);
+
+    /* One publish at t = 0 within 5 s: 8 ms transmit, fast polls at 200, 400, 600 and 800 ms, none at the end of the
+     * active threshold, then the slow poll restarted by the transmission falls at exactly 5 s, outside */
+    icd_timeline::profile_t publish = {"publish", false, 60000, 0, 5000, 200, 1000, 0, 0};
+    TEST_CHECK_EQUAL(icd_timeline::simulate_radio_on_ms(publish, 5000), 8 + 4 * 4);
+
+    /* Alignment rounds up to whole slow polls, never below one */
+    TEST_CHECK_EQUAL(icd_timeline::align_period(30000, 5000), 30000);
+    TEST_CHECK_EQUAL(icd_timeline::align_period(31000, 5000), 35000);
+    TEST_CHECK_EQUAL(icd_timeline::align_period(1000, 5000), 5000);
+}
+
+} // namespace
+
+int main()
+{
+    for (uint32_t publish_period_ms : k_publish_periods_ms) {
+        check_ordering(publish_period_ms);
+    }
+    check_hand_worked();
+    return test_support::Finish("icd-timeline-test");
+}
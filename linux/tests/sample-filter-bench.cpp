@@ -0,0 +1,100 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* Host benchmark of the sample_filter stages.
+ *
+ * Each stage, every median window and the chain configured in linux/include/sdkconfig.h run over the CO2 of
+ * linux/traces/sim-ramp-2h.csv, cycled as often as needed, so the samples vary the way real ones do. Prints
+ * `name,iterations,total_ns,ns_per_op` lines like sensirion-decode-bench.
+ *
+ * Usage: sample-filter-bench [iterations] */
+
+#include "test-support.h"
+
+#include <chrono>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#include "sample-filter.h"
+#include "trace-replay.h"
+
+#ifndef TRACE_DIR
+#error "TRACE_DIR must point at linux/traces"
+#endif
+
+namespace {
+
+volatile int32_t s_sink;
+
+template <typename Filter>
+void bench(const char *name, uint32_t iterations, const std::vector<int32_t> &samples)
+{
+    Filter filter;
+    size_t index = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; i++) {
+        s_sink = s_sink + filter.Process(samples[index]);
+        index = index + 1 == samples.size() ? 0 : index + 1;
+    }
+    int64_t total_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    printf("%s,%" PRIu32 ",%" PRId64 ",%" PRId64 "\n", name, iterations, total_ns,
+           iterations ? total_ns / iterations : 0);
+}
+
+/* The whole pipeline, conversions and classification included */
+class Pipeline
+{
+public:
+    int32_t Process(int32_t sample)
+    {
+        scd4x_measurement_raw_t raw = {(uint16_t)sample, 0x6667, 0x5eb9};
+        measurement_pipeline::result_t result;
+        measurement_pipeline::process(&raw, 0, &result);
+        return result.co2_ppm + result.air_quality;
+    }
+};
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    uint32_t iterations = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 0) : 1000000;
+
+    std::vector<trace_replay::record_t> records;
+    std::string error;
+    if (!trace_replay::load(TRACE_DIR "/sim-ramp-2h.csv", &records, &error) || records.empty()) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    std::vector<int32_t> samples;
+    for (const trace_replay::record_t &record : records) {
+        samples.push_back(scd4x_signal_co2_concentration(record.raw.co2_concentration));
+    }
+
+    printf("name,iterations,total_ns,ns_per_op\n");
+    bench<sample_filter::Passthrough>("passthrough", iterations, samples);
+    bench<sample_filter::Median<3>>("median_3", iterations, samples);
+    bench<sample_filter::Median<5>>("median_5", iterations, samples);
+    bench<sample_filter::Median<7>>("median_7", iterations, samples);
+    bench<sample_filter::Median<9>>("median_9", iterations, samples);
+    bench<sample_filter::Ema<3>>("ema_3", iterations, samples);
+    bench<sample_filter::Kalman<1, 16>>("kalman_1_16", iterations, samples);
+    bench<sample_filter::OutlierReject<200>>("outlier_200", iterations, samples);
+    bench<sample_filter::Chain<sample_filter::OutlierReject<200>, sample_filter::Median<5>,
+                               sample_filter::Kalman<1, 16>, sample_filter::Ema<3>>>("chain_all", iterations, samples);
+
+    /* measurement_pipeline::process() takes raw words */
+    for (size_t i = 0; i < records.size(); i++) {
+        samples[i] = records[i].raw.co2_concentration;
+    }
+    bench<Pipeline>("measurement_pipeline", iterations, samples);
+    return 0;
+}
@@ -0,0 +1,235 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* Runs every sample_filter stage over the CO2 of a recorded trace.
+ *
+ * The input is linux/traces/sim-ramp-2h.csv with an isolated +2000 ppm spike injected every 97 samples and a real
+ * +800 ppm step from the middle on. Each stage is checked against a floating-point or brute-force reference of what it
+ * computes, and the outputs of all stages are compared with sim-ramp-2h.filters.expected.csv so any change in their
+ * rounding shows up. `sample-filter-test --print` writes that file to stdout.
+ *
+ * Usage: sample-filter-test [--print] */
+
+#include "test-support.h"
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "sample-filter.h"
+#include "trace-replay.h"
+
+#ifndef TRACE_DIR
+#error "TRACE_DIR must point at linux/traces"
+#endif
+
+namespace {
+
+const size_t k_spike_every = 97;
+const int32_t k_spike_ppm = 2000;
+const int32_t k_step_ppm = 800;
+
+/* The stages under test, with the parameters used in the expected file */
+using median_3_t = sample_filter::Median<3>;
+using median_9_t = sample_filter::Median<9>;
+using ema_3_t = sample_filter::Ema<3>;
+using kalman_t = sample_filter::Kalman<1, 16>;
+using outlier_t = sample_filter::OutlierReject<200, 2>;
+
+struct sample_t {
+    int64_t timestamp_us;
+    int32_t co2_ppm;
+    bool spike;
+};
+
+struct outputs_t {
+    int32_t median_3;
+    int32_t median_9;
+    int32_t ema_3;
+    int32_t kalman;
+    int32_t outlier;
+};
+
+std::vector<sample_t> load_input()
+{
+    std::vector<trace_replay::record_t> records;
+    std::string error;
+    if (!trace_replay::load(TRACE_DIR "/sim-ramp-2h.csv", &records, &error)) {
+        printf("%s\n", error.c_str());
+        test_support::g_failures++;
+    }
+    std::vector<sample_t> samples;
+    for (size_t i = 0; i < records.size(); i++) {
+        sample_t sample = {records[i].timestamp_us, scd4x_signal_co2_concentration(records[i].raw.co2_concentration),
+                           i % k_spike_every == k_spike_every / 2};
+        if (i >= records.size() / 2) {
+            sample.co2_ppm += k_step_ppm;
+        }
+        if (sample.spike) {
+            sample.co2_ppm += k_spike_ppm;
+        }
+        samples.push_back(sample);
+    }
+    return samples;
+}
+
+std::vector<outputs_t> run_stages(const std::vector<sample_t> &samples)
+{
+    median_3_t median_3;
+    median_9_t median_9;
+    ema_3_t ema_3;
+    kalman_t kalman;
+    outlier_t outlier;
+    std::vector<outputs_t> outputs;
+    for (const sample_t &sample : samples) {
+        outputs.push_back({median_3.Process(sample.co2_ppm), median_9.Process(sample.co2_ppm),
+                           ema_3.Process(sample.co2_ppm), kalman.Process(sample.co2_ppm),
+                           outlier.Process(sample.co2_ppm)});
+    }
+    return outputs;
+}
+
+void print_outputs(FILE *out, const std::vector<sample_t> &samples, const std::vector<outputs_t> &outputs)
+{
+    fprintf(out, "timestamp_us,co2_ppm,median_3,median_9,ema_3,kalman_1_16,outlier_200\n");
+    for (size_t i = 0; i < samples.size(); i++) {
+        fprintf(out, "%lld,%d,%d,%d,%d,%d,%d\n", (long long)samples[i].timestamp_us, samples[i].co2_ppm,
+                outputs[i].median_3, outputs[i].median_9, outputs[i].ema_3, outputs[i].kalman, outputs[i].outlier);
+    }
+}
+
+/* Median of the last `window` inputs, the first one standing in for those before the trace started */
+int32_t reference_median(const std::vector<sample_t> &samples, size_t index, size_t window)
+{
+    std::vector<int32_t> values;
+    for (size_t k = 0; k < window; k++) {
+        values.push_back(samples[index >= k ? index - k : 0].co2_ppm);
+    }
+    std::nth_element(values.begin(), values.begin() + window / 2, values.end());
+    return values[window / 2];
+}
+
+void check_median(const std::vector<sample_t> &samples, const std::vector<outputs_t> &outputs)
+{
+    for (size_t i = 0; i < samples.size(); i++) {
+        TEST_CHECK_EQUAL(outputs[i].median_3, reference_median(samples, i, 3));
+        TEST_CHECK_EQUAL(outputs[i].median_9, reference_median(samples, i, 9));
+        /* An isolated spike never reaches the output */
+        TEST_CHECK(outputs[i].median_3 < samples[i].co2_ppm || !samples[i].spike);
+    }
+}
+
+void check_ema(const std::vector<sample_t> &samples, const std::vector<outputs_t> &outputs)
+{
+    /* The fixed-point average truncates by less than one ppm, and the output is rounded */
+    double average = samples[0].co2_ppm;
+    for (size_t i = 0; i < samples.size(); i++) {
+        average += (samples[i].co2_ppm - average) / 8;
+        TEST_CHECK(fabs(outputs[i].ema_3 - average) <= 1.5);
+    }
+}
+
+void check_kalman(const std::vector<sample_t> &samples, const std::vector<outputs_t> &outputs)
+{
+    double estimate = samples[0].co2_ppm;
+    double variance = 16;
+    TEST_CHECK_EQUAL(outputs[0].kalman, samples[0].co2_ppm);
+    for (size_t i = 1; i < samples.size(); i++) {
+        variance += 1;
+        double gain = variance / (variance + 16);
+        estimate += gain * (samples[i].co2_ppm - estimate);
+        variance *= 1 - gain;
+        TEST_CHECK(fabs(outputs[i].kalman - estimate) <= 2.0);
+    }
+    /* Converges to the steady-state gain of about 0.22 */
+    TEST_CHECK(variance > 3.4 && variance < 3.6);
+}
+
+void check_outlier(const std::vector<sample_t> &samples, const std::vector<outputs_t> &outputs)
+{
+    size_t step_index = samples.size() / 2;
+    for (size_t i = 1; i < samples.size(); i++) {
+        if (samples[i].spike) {
+            /* Replaced by the last accepted sample */
+            TEST_CHECK_EQUAL(outputs[i].outlier, outputs[i - 1].outlier);
+        } else if (i == step_index || i == step_index + 1) {
+            /* The step is rejected twice, then taken as real */
+            TEST_CHECK_EQUAL(outputs[i].outlier, outputs[step_index - 1].outlier);
+        } else {
+            TEST_CHECK_EQUAL(outputs[i].outlier, samples[i].co2_ppm);
+        }
+    }
+}
+
+void check_expected(const std::vector<sample_t> &samples, const std::vector<outputs_t> &outputs)
+{
+    FILE *expected = fopen(TRACE_DIR "/sim-ramp-2h.filters.expected.csv", "r");
+    FILE *actual = tmpfile();
+    TEST_CHECK(expected != nullptr && actual != nullptr);
+    if (expected == nullptr || actual == nullptr) {
+        return;
+    }
+    print_outputs(actual, samples, outputs);
+    rewind(actual);
+    char expected_line[128];
+    char actual_line[128];
+    size_t line = 0;
+    bool more = true;
+    while (more) {
+        line++;
+        bool have_expected = fgets(expected_line, sizeof(expected_line), expected) != nullptr;
+        bool have_actual = fgets(actual_line, sizeof(actual_line), actual) != nullptr;
+        more = have_expected && have_actual;
+        if (have_expected != have_actual || (more && strcmp(expected_line, actual_line) != 0)) {
+            printf("line %zu differs from the expected output\n", line);
+            test_support::g_failures++;
+            break;
+        }
+    }
+    fclose(expected);
+    fclose(actual);
+}
+
+/* The chain applies its stages in order and resets all of them */
+void check_chain(const std::vector<sample_t> &samples, const std::vector<outputs_t> &outputs)
+{
+    sample_filter::Chain<outlier_t, median_3_t, sample_filter::Optional<false, ema_3_t>> chain;
+    for (int pass = 0; pass < 2; pass++) {
+        median_3_t median;
+        for (size_t i = 0; i < samples.size(); i++) {
+            TEST_CHECK_EQUAL(chain.Process(samples[i].co2_ppm), median.Process(outputs[i].outlier));
+        }
+        chain.Reset();
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::vector<sample_t> samples = load_input();
+    if (samples.empty()) {
+        return test_support::Finish("sample-filter-test");
+    }
+    std::vector<outputs_t> outputs = run_stages(samples);
+
+    if (argc > 1 && strcmp(argv[1], "--print") == 0) {
+        print_outputs(stdout, samples, outputs);
+        return 0;
+    }
+
+    check_median(samples, outputs);
+    check_ema(samples, outputs);
+    check_kalman(samples, outputs);
+    check_outlier(samples, outputs);
+    check_chain(samples, outputs);
+    check_expected(samples, outputs);
+    return test_support::Finish("sample-filter-test");
+}
@@ -0,0 +1,270 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* Samples the simulated SCD4x on the deadline grid for 8 days of simulated time.
+ *
+ * The esp_timer of `sensor_scheduler` is stood in for by the simulated clock: each deadline fires up to 3 ms late and
+ * runs what the timer callback runs, with the sample read through the driver at every deadline. Along the way the
+ * grid must keep its cadence through a stalled sample, a bus outage and a period change, and the sensor, drifted
+ * 60 ppm high, must be brought back by ASC at the end of its initial period, then drift low and be brought back again
+ * at the end of the first standard period. */
+
+#include "test-support.h"
+
+#include <inttypes.h>
+
+#include <deadline-grid.h>
+#include <virtual-clock.h>
+
+#include "scd4x_i2c.h"
+#include "scd4x_sim.h"
+#include "sensirion_common.h"
+#include "sensirion_i2c_hal.h"
+
+namespace {
+
+constexpr int64_t k_second_us = 1000 * 1000;
+constexpr int64_t k_hour_us = 3600 * k_second_us;
+constexpr uint32_t k_period_ms = 5000;
+constexpr int64_t k_max_latency_us = 3000;
+
+/* Sensor defaults: 400 ppm target, 44 h initial and 156 h standard period */
+constexpr int64_t k_asc_initial_us = 44 * k_hour_us;
+constexpr int64_t k_asc_standard_us = 156 * k_hour_us;
+
+/* Lowest reading of the simulator's ramp, with its noise, once brought back to the ASC target */
+constexpr uint16_t k_corrected_low_ppm = 396;
+constexpr uint16_t k_corrected_high_ppm = 410;
+
+struct sampler_t {
+    int64_t origin_us;    /* Grid anchor: every deadline is a whole number of base periods after it */
+    int64_t previous_us;  /* Previous sampled deadline */
+    int64_t longest_gap_us;
+    int64_t first_good_us; /* First good read since the last reset, -1 if none */
+    uint32_t reads;
+    uint32_t failures;
+    uint32_t off_grid;
+    uint16_t lowest_ppm;
+};
+
+sampler_t s_sampler;
+deadline_grid::grid_t s_grid;
+int64_t s_next_us;
+int64_t s_stall_us;
+uint32_t s_latency_seed = 1;
+
+void reset_sampler()
+{
+    s_sampler.longest_gap_us = 0;
+    s_sampler.first_good_us = -1;
+    s_sampler.reads = 0;
+    s_sampler.failures = 0;
+    s_sampler.off_grid = 0;
+    s_sampler.lowest_ppm = 0xFFFF;
+}
+
+void advance_to(int64_t time_us)
+{
+    int64_t now_us = virtual_clock::now_us();
+    if (time_us > now_us) {
+        test_support::SimulatedClock::AdvanceUs((uint64_t)(time_us - now_us));
+    }
+}
+
+/* What the app's sample callback does, minus the hand-off: read the sensor at the deadline */
+bool sample(int64_t deadline_us)
+{
+    if ((deadline_us - s_sampler.origin_us) % ((int64_t)k_period_ms * 1000) != 0) {
+        s_sampler.off_grid++;
+    }
+    if (s_sampler.previous_us && deadline_us - s_sampler.previous_us > s_sampler.longest_gap_us) {
+        s_sampler.longest_gap_us = deadline_us - s_sampler.previous_us;
+    }
+    s_sampler.previous_us = deadline_us;
+
+    uint16_t co2_ppm;
+    int32_t temperature_m_deg_c;
+    int32_t humidity_m_percent_rh;
+    s_sampler.reads++;
+    if (scd4x_read_measurement(&co2_ppm, &temperature_m_deg_c, &humidity_m_percent_rh) != NO_ERROR) {
+        s_sampler.failures++;
+    } else {
+        if (s_sampler.first_good_us < 0) {
+            s_sampler.first_good_us = virtual_clock::now_us();
+        }
+        if (co2_ppm < s_sampler.lowest_ppm) {
+            s_sampler.lowest_ppm = co2_ppm;
+        }
+    }
+
+    /* A sample that holds the timer task, as a blocking read on a hung bus would */
+    virtual_clock::sleep_us((uint32_t)s_stall_us);
+    s_stall_us = 0;
+    return true;
+}
+
+/* The esp_timer firing at each armed deadline, a little late, and running the scheduler's timer callback */
+void run_until(int64_t end_us)
+{
+    while (s_next_us <= end_us) {
+        s_latency_seed = s_latency_seed * 1103515245u + 12345u;
+        advance_to(s_next_us + (s_latency_seed >> 16) % k_max_latency_us);
+
+        int64_t deadline_us;
+        s_next_us = deadline_grid::advance(&s_grid, virtual_clock::now_us(), &deadline_us);
+        int64_t jitter_us = virtual_clock::now_us() - deadline_us;
+        if (sample(deadline_us)) {
+            deadline_grid::record_jitter(&s_grid, jitter_us);
+        } else {
+            deadline_grid::record_missed(&s_grid);
+        }
+    }
+}
+
+int8_t dead_read(uint8_t address, uint8_t *data, uint8_t count)
+{
+    return -1;
+}
+
+int8_t dead_write(uint8_t address, const uint8_t *data, uint8_t count)
+{
+    return -1;
+}
+
+/* Sensor unplugged or SDA held low: nothing is acknowledged */
+const sensirion_i2c_hal_bus_t k_dead_bus = {dead_read, dead_write};
+
+void check_days(int64_t start_us)
+{
+    reset_sampler();
+    run_until(start_us + 40 * k_hour_us);
+
+    TEST_CHECK_EQUAL(s_sampler.reads, 40 * 720);
+    TEST_CHECK_EQUAL(s_sampler.failures, 0);
+    TEST_CHECK_EQUAL(s_sampler.off_grid, 0);
+    TEST_CHECK_EQUAL(s_sampler.longest_gap_us, (int64_t)k_period_ms * 1000);
+    TEST_CHECK_EQUAL(s_grid.stats.samples, s_sampler.reads);
+    TEST_CHECK_EQUAL(s_grid.stats.missed_deadlines, 0);
+    TEST_CHECK(s_grid.stats.max_us < k_max_latency_us);
+    uint32_t bucketed = 0;
+    for (uint32_t count : s_grid.stats.buckets) {
+        bucketed += count;
+    }
+    TEST_CHECK_EQUAL(bucketed, s_grid.stats.samples);
+    TEST_CHECK_EQUAL(s_grid.stats.buckets[DEADLINE_GRID_JITTER_BUCKETS - 1], 0);
+
+    /* Before ASC has run: the ramp's low end of 450 ppm, give or take the noise, read 60 ppm high */
+    TEST_CHECK(s_sampler.lowest_ppm >= 446 + 60 && s_sampler.lowest_ppm <= 453 + 60);
+}
+
+void check_stall()
+{
+    reset_sampler();
+    uint32_t missed = s_grid.stats.missed_deadlines;
+    s_stall_us = 17500 * 1000;
+    run_until(virtual_clock::now_us() + 10 * 60 * k_second_us);
+
+    /* The stalled sample's successor runs 12.5 s late, the two deadlines after it are skipped, not burst */
+    TEST_CHECK_EQUAL(s_grid.stats.missed_deadlines - missed, 2);
+    TEST_CHECK_EQUAL(s_sampler.longest_gap_us, 3 * (int64_t)k_period_ms * 1000);
+    TEST_CHECK(s_grid.stats.max_us >= 12500 * 1000);
+    TEST_CHECK_EQUAL(s_sampler.off_grid, 0);
+    TEST_CHECK_EQUAL(s_sampler.failures, 0);
+}
+
+void check_bus_outage()
+{
+    reset_sampler();
+    sensirion_i2c_hal_set_bus(&k_dead_bus);
+    run_until(virtual_clock::now_us() + 10 * 60 * k_second_us);
+    TEST_CHECK_EQUAL(s_sampler.failures, s_sampler.reads);
+    TEST_CHECK(s_sampler.reads >= 119);
+    TEST_CHECK_EQUAL(s_sampler.off_grid, 0);
+
+    /* Recovery: the sensor measured on throughout, so the first deadline after the bus comes back reads it */
+    reset_sampler();
+    int64_t restored_us = virtual_clock::now_us();
+    sensirion_i2c_hal_set_bus(&scd4x_sim_bus);
+    run_until(restored_us + 10 * 60 * k_second_us);
+    TEST_CHECK_EQUAL(s_sampler.failures, 0);
+    TEST_CHECK(s_sampler.first_good_us >= restored_us);
+    TEST_CHECK(s_sampler.first_good_us - restored_us < (int64_t)k_period_ms * 1000 + k_max_latency_us + 2000);
+}
+
+void check_period_change()
+{
+    /* Takes effect from the deadline after the armed one, which keeps the grid anchored */
+    reset_sampler();
+    s_grid.period_ms = 2 * k_period_ms;
+    int64_t start_us = virtual_clock::now_us();
+    run_until(start_us + k_hour_us);
+    TEST_CHECK(s_sampler.reads >= 359 && s_sampler.reads <= 361);
+    TEST_CHECK_EQUAL(s_sampler.longest_gap_us, 2 * (int64_t)k_period_ms * 1000);
+    TEST_CHECK_EQUAL(s_sampler.off_grid, 0);
+
+    s_grid.period_ms = k_period_ms;
+}
+
+/* Lowest reading over the next hour, which spans at least one low of the 40 min ramp */
+uint16_t lowest_over_hour()
+{
+    reset_sampler();
+    run_until(virtual_clock::now_us() + k_hour_us);
+    TEST_CHECK_EQUAL(s_sampler.failures, 0);
+    return s_sampler.lowest_ppm;
+}
+
+void check_asc(int64_t start_us)
+{
+    /* The initial period ends 44 h after measurement started; the lowest reading before it reads as 400 ppm */
+    run_until(start_us + k_asc_initial_us);
+    uint16_t lowest_ppm = lowest_over_hour();
+    TEST_CHECK(lowest_ppm >= k_corrected_low_ppm && lowest_ppm <= k_corrected_high_ppm);
+
+    /* The sensor then drifts 30 ppm low; nothing changes until the standard period ends */
+    scd4x_sim_set_drift(30);
+    run_until(start_us + k_asc_initial_us + k_asc_standard_us - 2 * k_hour_us);
+    lowest_ppm = lowest_over_hour();
+    TEST_CHECK(lowest_ppm >= k_corrected_low_ppm - 30 && lowest_ppm <= k_corrected_high_ppm - 30);
+
+    run_until(start_us + k_asc_initial_us + k_asc_standard_us);
+    lowest_ppm = lowest_over_hour();
+    TEST_CHECK(lowest_ppm >= k_corrected_low_ppm && lowest_ppm <= k_corrected_high_ppm);
+}
+
+} // namespace
+
+int main()
+{
+    test_support::SimulatedClock::Install();
+    sensirion_i2c_hal_set_bus(&scd4x_sim_bus);
+    scd4x_init(SCD40_I2C_ADDR_62);
+    scd4x_sim_reset();
+    scd4x_sim_set_drift(60);
+
+    /* As app_main: sampling starts once the sensor measures, the first deadline one measurement interval on */
+    TEST_CHECK_EQUAL(scd4x_start_periodic_measurement(), NO_ERROR);
+    int64_t start_us = virtual_clock::now_us();
+    s_grid.period_ms = k_period_ms;
+    s_next_us = start_us + deadline_grid::start(&s_grid, start_us, k_period_ms);
+    s_sampler.origin_us = start_us;
+
+    check_days(start_us);
+    check_stall();
+    check_bus_outage();
+    check_period_change();
+    check_asc(start_us);
+
+    printf("sampled %.1f simulated days, %" PRIu32 " samples, %" PRIu32 " missed deadlines\n",
+           (double)(virtual_clock::now_us() - start_us) / (24 * k_hour_us), s_grid.stats.samples,
+           s_grid.stats.missed_deadlines);
+
+    sensirion_i2c_hal_set_bus(NULL);
+    test_support::SimulatedClock::Remove();
+    return test_support::Finish("sampling-days-test");
+}
@@ -0,0 +1,202 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* Walks every entry of the generated SCD4x command table through the simulated sensor.
+ *
+ * The table is compared with the datasheet figures written out below, independently of scd4x_commands.def, and every
+ * command is then run with scd4x_execute() on a recording bus in front of the simulator: the frame must carry the
+ * command code and the argument words, the driver must read exactly the response words, the simulator must accept
+ * both, and the command must take its execution time on the simulated clock. */
+
+#include "test-support.h"
+
+#include <string.h>
+
+#include "scd4x_i2c.h"
+#include "scd4x_sim.h"
+#include "sensirion_common.h"
+#include "sensirion_i2c.h"
+#include "sensirion_i2c_hal.h"
+
+namespace {
+
+struct expected_command_t {
+    scd4x_command_t command;
+    uint16_t code;
+    uint8_t num_args;
+    uint8_t num_response_words;
+    uint32_t exec_time_us;
+};
+
+/* SCD4x datasheet, section 3 */
+const expected_command_t k_expected[] = {
+    {scd4x_cmd_start_periodic_measurement, 0x21b1, 0, 0, 0},
+    {scd4x_cmd_read_measurement_raw, 0xec05, 0, 3, 1000},
+    {scd4x_cmd_stop_periodic_measurement, 0x3f86, 0, 0, 500000},
+    {scd4x_cmd_set_temperature_offset_raw, 0x241d, 1, 0, 1000},
+    {scd4x_cmd_get_temperature_offset_raw, 0x2318, 0, 1, 1000},
+    {scd4x_cmd_set_sensor_altitude, 0x2427, 1, 0, 1000},
+    {scd4x_cmd_get_sensor_altitude, 0x2322, 0, 1, 1000},
+    {scd4x_cmd_set_ambient_pressure_raw, 0xe000, 1, 0, 1000},
+    {scd4x_cmd_get_ambient_pressure_raw, 0xe000, 0, 1, 1000},
+    {scd4x_cmd_perform_forced_recalibration, 0x362f, 1, 1, 400000},
+    {scd4x_cmd_set_automatic_self_calibration_enabled, 0x2416, 1, 0, 1000},
+    {scd4x_cmd_get_automatic_self_calibration_enabled, 0x2313, 0, 1, 1000},
+    {scd4x_cmd_set_automatic_self_calibration_target, 0x243a, 1, 0, 1000},
+    {scd4x_cmd_get_automatic_self_calibration_target, 0x233f, 0, 1, 1000},
+    {scd4x_cmd_start_low_power_periodic_measurement, 0x21ac, 0, 0, 0},
+    {scd4x_cmd_get_data_ready_status_raw, 0xe4b8, 0, 1, 1000},
+    {scd4x_cmd_persist_settings, 0x3615, 0, 0, 800000},
+    {scd4x_cmd_get_serial_number, 0x3682, 0, 3, 1000},
+    {scd4x_cmd_perform_self_test, 0x3639, 0, 1, 10000000},
+    {scd4x_cmd_perform_factory_reset, 0x3632, 0, 0, 1200000},
+    {scd4x_cmd_reinit, 0x3646, 0, 0, 30000},
+    {scd4x_cmd_get_sensor_variant_raw, 0x202f, 0, 1, 1000},
+    {scd4x_cmd_measure_single_shot, 0x219d, 0, 0, 5000000},
+    {scd4x_cmd_measure_single_shot_rht_only, 0x2196, 0, 0, 50000},
+    {scd4x_cmd_power_down, 0x36e0, 0, 0, 1000},
+    {scd4x_cmd_wake_up, 0x36f6, 0, 0, 30000},
+    {scd4x_cmd_set_automatic_self_calibration_initial_period, 0x2445, 1, 0, 1000},
+    {scd4x_cmd_get_automatic_self_calibration_initial_period, 0x2340, 0, 1, 1000},
+    {scd4x_cmd_set_automatic_self_calibration_standard_period, 0x244e, 1, 0, 1000},
+    {scd4x_cmd_get_automatic_self_calibration_standard_period, 0x234b, 0, 1, 1000},
+};
+const size_t k_expected_count = sizeof(k_expected) / sizeof(k_expected[0]);
+
+/* What crossed the bus since the last Clear() */
+struct bus_log_t {
+    int writes;
+    int reads;
+    uint8_t write_frame[SENSIRION_I2C_CMD_BUFFER_SIZE];
+    uint8_t write_count;
+    int8_t write_result;
+    uint8_t read_count;
+    int8_t read_result;
+};
+
+bus_log_t s_log;
+
+void clear_log()
+{
+    memset(&s_log, 0, sizeof(s_log));
+}
+
+int8_t recording_read(uint8_t address, uint8_t *data, uint8_t count)
+{
+    s_log.reads++;
+    s_log.read_count = count;
+    s_log.read_result = scd4x_sim_bus.read(address, data, count);
+    return s_log.read_result;
+}
+
+int8_t recording_write(uint8_t address, const uint8_t *data, uint8_t count)
+{
+    s_log.writes++;
+    s_log.write_count = count;
+    memcpy(s_log.write_frame, data, count < sizeof(s_log.write_frame) ? count : sizeof(s_log.write_frame));
+    s_log.write_result = scd4x_sim_bus.write(address, data, count);
+    return s_log.write_result;
+}
+
+const sensirion_i2c_hal_bus_t k_recording_bus = {recording_read, recording_write};
+
+/* Put the simulator in a state where `command` is accepted and has something to answer */
+void prepare(scd4x_command_t command)
+{
+    scd4x_sim_reset();
+    switch (command) {
+    case scd4x_cmd_read_measurement_raw:
+    case scd4x_cmd_get_data_ready_status_raw:
+        scd4x_start_periodic_measurement();
+        test_support::SimulatedClock::AdvanceUs(5000000);
+        break;
+    case scd4x_cmd_stop_periodic_measurement:
+        scd4x_start_periodic_measurement();
+        break;
+    case scd4x_cmd_wake_up:
+        scd4x_power_down();
+        break;
+    default:
+        break;
+    }
+}
+
+void check_descriptor(const expected_command_t &expected)
+{
+    const sensirion_i2c_cmd_desc_t &desc = scd4x_commands[expected.command];
+    printf("%s\n", scd4x_command_names[expected.command]);
+    TEST_CHECK_EQUAL(desc.code, expected.code);
+    TEST_CHECK_EQUAL(desc.num_args, expected.num_args);
+    TEST_CHECK_EQUAL(desc.num_response_words, expected.num_response_words);
+    TEST_CHECK_EQUAL(desc.exec_time_us, expected.exec_time_us);
+}
+
+void check_on_simulator(const expected_command_t &expected)
+{
+    const sensirion_i2c_cmd_desc_t &desc = scd4x_commands[expected.command];
+    const uint16_t args[SENSIRION_I2C_CMD_MAX_ARGS] = {0x0190, 0x0190};
+    uint16_t response[SENSIRION_I2C_CMD_MAX_RESPONSE_WORDS];
+
+    prepare(expected.command);
+    clear_log();
+    uint64_t started_us = test_support::SimulatedClock::NowUs();
+    int16_t error = scd4x_execute(expected.command, args, response);
+    uint64_t elapsed_us = test_support::SimulatedClock::NowUs() - started_us;
+
+    TEST_CHECK_EQUAL(error, NO_ERROR);
+    TEST_CHECK_EQUAL(elapsed_us, expected.exec_time_us);
+
+    /* One frame: the code, then every argument word with its CRC */
+    TEST_CHECK_EQUAL(s_log.writes, 1);
+    TEST_CHECK_EQUAL(s_log.write_count, SENSIRION_COMMAND_SIZE + expected.num_args * (SENSIRION_WORD_SIZE + 1));
+    TEST_CHECK_EQUAL(sensirion_common_bytes_to_uint16_t(s_log.write_frame), expected.code);
+    for (uint8_t i = 0; i < expected.num_args; i++) {
+        const uint8_t *word = &s_log.write_frame[SENSIRION_COMMAND_SIZE + i * 3];
+        TEST_CHECK_EQUAL(sensirion_common_bytes_to_uint16_t(word), args[i]);
+        TEST_CHECK_EQUAL(word[2], sensirion_i2c_generate_crc(word, SENSIRION_WORD_SIZE));
+    }
+    /* The simulator only refuses wake_up, which the sensor never acknowledges */
+    bool acknowledged = !(desc.flags & SENSIRION_I2C_CMD_FLAG_NO_ACK);
+    TEST_CHECK_EQUAL(s_log.write_result == 0, acknowledged);
+
+    /* Exactly the response words, which the simulator had ready */
+    TEST_CHECK_EQUAL(s_log.reads, expected.num_response_words > 0 ? 1 : 0);
+    if (expected.num_response_words > 0) {
+        TEST_CHECK_EQUAL(s_log.read_count, expected.num_response_words * (SENSIRION_WORD_SIZE + 1));
+        TEST_CHECK_EQUAL(s_log.read_result, 0);
+    }
+}
+
+} // namespace
+
+int main()
+{
+    TEST_CHECK_EQUAL(k_expected_count, SCD4X_COMMAND_COUNT);
+
+    /* Every table entry is covered exactly once */
+    bool seen[SCD4X_COMMAND_COUNT] = {};
+    for (const expected_command_t &expected : k_expected) {
+        TEST_CHECK(expected.command < SCD4X_COMMAND_COUNT && !seen[expected.command]);
+        if (expected.command < SCD4X_COMMAND_COUNT) {
+            seen[expected.command] = true;
+        }
+    }
+
+    test_support::SimulatedClock::Install();
+    sensirion_i2c_hal_set_bus(&k_recording_bus);
+    scd4x_init(SCD40_I2C_ADDR_62);
+
+    for (const expected_command_t &expected : k_expected) {
+        check_descriptor(expected);
+        check_on_simulator(expected);
+    }
+
+    sensirion_i2c_hal_set_bus(NULL);
+    test_support::SimulatedClock::Remove();
+    return test_support::Finish("scd4x-commands-test");
+}
@@ -0,0 +1,131 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* Checks scd4x_convert_measurements() against the scalar conversions for every one of the 65536 raw words.
+ *
+ * The batch and the scalar path must agree bit for bit, on the whole range in one call and on short, misaligned
+ * slices that end in the loop's scalar tail once the compiler vectorizes it. The scalar results are also checked
+ * against the Sensirion integer formulas computed in 64 bits, and against the datasheet formulas to within the
+ * 4 m°C / 3 m%RH the integer scaling and truncation cost. */
+
+#include "test-support.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <vector>
+
+#include "scd4x_i2c.h"
+
+namespace {
+
+constexpr uint32_t k_words = 65536;
+
+struct converted_t {
+    std::vector<uint16_t> co2;
+    std::vector<int32_t> temperature;
+    std::vector<int32_t> humidity;
+};
+
+/* The raw words in a different order per channel, so a mixed-up channel does not go unnoticed */
+std::vector<uint16_t> s_raw_co2(k_words), s_raw_temperature(k_words), s_raw_humidity(k_words);
+
+converted_t convert(uint32_t offset, uint32_t count)
+{
+    converted_t out = {std::vector<uint16_t>(count), std::vector<int32_t>(count), std::vector<int32_t>(count)};
+    scd4x_convert_measurements(&s_raw_co2[offset], &s_raw_temperature[offset], &s_raw_humidity[offset], out.co2.data(),
+                               out.temperature.data(), out.humidity.data(), count);
+    return out;
+}
+
+/* Compare a converted slice with the scalar path, stopping at the first mismatch of each channel */
+void check_slice(uint32_t offset, uint32_t count)
+{
+    converted_t out = convert(offset, count);
+    for (uint32_t i = 0; i < count; i++) {
+        if (out.co2[i] != scd4x_signal_co2_concentration(s_raw_co2[offset + i])) {
+            TEST_CHECK_EQUAL(out.co2[i], scd4x_signal_co2_concentration(s_raw_co2[offset + i]));
+            break;
+        }
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        if (out.temperature[i] != scd4x_signal_temperature(s_raw_temperature[offset + i])) {
+            TEST_CHECK_EQUAL(out.temperature[i], scd4x_signal_temperature(s_raw_temperature[offset + i]));
+            break;
+        }
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        if (out.humidity[i] != scd4x_signal_relative_humidity(s_raw_humidity[offset + i])) {
+            TEST_CHECK_EQUAL(out.humidity[i], scd4x_signal_relative_humidity(s_raw_humidity[offset + i]));
+            break;
+        }
+    }
+}
+
+void check_scalar_formulas()
+{
+    int temperature_mismatches = 0;
+    int humidity_mismatches = 0;
+    double temperature_max_error = 0;
+    double humidity_max_error = 0;
+    for (uint32_t raw = 0; raw < k_words; raw++) {
+        /* Sensirion's integer formulas, in 64 bits so an overflow in the driver would show */
+        int64_t temperature = ((21875 * (int64_t)raw) >> 13) - 45000;
+        int64_t humidity = (12500 * (int64_t)raw) >> 13;
+        temperature_mismatches += scd4x_signal_temperature((uint16_t)raw) != temperature;
+        humidity_mismatches += scd4x_signal_relative_humidity((uint16_t)raw) != humidity;
+
+        /* Datasheet section 3.6: T = -45 + 175 * raw / (2^16 - 1), RH = 100 * raw / (2^16 - 1) */
+        double temperature_datasheet = -45000.0 + 175000.0 * raw / 65535;
+        double humidity_datasheet = 100000.0 * raw / 65535;
+        temperature_max_error =
+            fmax(temperature_max_error, fabs(scd4x_signal_temperature((uint16_t)raw) - temperature_datasheet));
+        humidity_max_error =
+            fmax(humidity_max_error, fabs(scd4x_signal_relative_humidity((uint16_t)raw) - humidity_datasheet));
+    }
+    TEST_CHECK_EQUAL(temperature_mismatches, 0);
+    TEST_CHECK_EQUAL(humidity_mismatches, 0);
+    TEST_CHECK(temperature_max_error <= 4.0);
+    TEST_CHECK(humidity_max_error <= 3.0);
+    printf("datasheet error: %.3f m°C, %.3f m%%RH\n", temperature_max_error, humidity_max_error);
+}
+
+} // namespace
+
+int main()
+{
+    for (uint32_t i = 0; i < k_words; i++) {
+        s_raw_co2[i] = (uint16_t)i;
+        s_raw_temperature[i] = (uint16_t)(k_words - 1 - i);
+        s_raw_humidity[i] = (uint16_t)(i * 40503u);
+    }
+
+    check_scalar_formulas();
+
+    /* The whole range in one call */
+    check_slice(0, k_words);
+
+    /* Short and misaligned slices, covering every tail length up to twice the widest vector */
+    for (uint32_t offset = 0; offset < 4; offset++) {
+        for (uint32_t count = 0; count <= 33; count++) {
+            check_slice(k_words - 40 + offset, count);
+        }
+    }
+
+    /* A count of zero writes nothing */
+    uint16_t co2 = 0xabcd;
+    int32_t temperature = 0x12345678;
+    int32_t humidity = 0x12345678;
+    scd4x_convert_measurements(&s_raw_co2[0], &s_raw_temperature[0], &s_raw_humidity[0], &co2, &temperature, &humidity,
+                               0);
+    TEST_CHECK_EQUAL(co2, 0xabcd);
+    TEST_CHECK_EQUAL(temperature, 0x12345678);
+    TEST_CHECK_EQUAL(humidity, 0x12345678);
+
+    return test_support::Finish("scd4x-convert-test");
+}
@@ -0,0 +1,255 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* Drives several outstanding commands through sensirion_i2c_cmd_poll_all() and checks when each response is read.
+ *
+ * The bus in front of the simulated SCD4x charges every transaction its 100 kHz wire time on the simulated clock and
+ * NACKs a read that starts before the device has had the command's full execution time since the end of its write,
+ * the way a real sensor does. Two scripted devices share the bus with the simulator so one pass of poll_all() spends
+ * bus time on several commands. Every read must come after the execution time and no later than one frame after. */
+
+#include "test-support.h"
+
+#include <string.h>
+
+#include "scd4x_i2c.h"
+#include "scd4x_sim.h"
+#include "sensirion_common.h"
+#include "sensirion_i2c.h"
+#include "sensirion_i2c_cmd.h"
+#include "sensirion_i2c_hal.h"
+
+namespace {
+
+/* 9 clocks per byte at 100 kHz, plus one byte's worth for the address */
+constexpr uint64_t k_byte_us = 90;
+/* Longest frame in this test: a 9-word response */
+constexpr uint64_t k_max_frame_us = (1 + SENSIRION_I2C_CMD_MAX_RESPONSE_WORDS * 3) * k_byte_us;
+
+constexpr uint8_t k_device_a = 0x10;
+constexpr uint8_t k_device_b = 0x11;
+
+const sensirion_i2c_cmd_desc_t k_command_a = {0x1234, 0, 2, 1000, 0};
+const sensirion_i2c_cmd_desc_t k_command_b = {0x5678, 1, 1, 20000, 0};
+
+/* Bus-side view of one device */
+struct device_t {
+    uint8_t address;
+    uint32_t exec_time_us;
+    uint64_t write_end_us;
+    uint64_t read_start_us;
+    int writes;
+    int reads;
+    int early_reads;
+};
+
+device_t s_devices[] = {
+    {SCD40_I2C_ADDR_62, 1000, 0, 0, 0, 0, 0},
+    {k_device_a, k_command_a.exec_time_us, 0, 0, 0, 0, 0},
+    {k_device_b, k_command_b.exec_time_us, 0, 0, 0, 0, 0},
+};
+
+device_t *find_device(uint8_t address)
+{
+    for (device_t &device : s_devices) {
+        if (device.address == address) {
+            return &device;
+        }
+    }
+    return nullptr;
+}
+
+void reset_devices()
+{
+    for (device_t &device : s_devices) {
+        device.write_end_us = 0;
+        device.read_start_us = 0;
+        device.writes = 0;
+        device.reads = 0;
+        device.early_reads = 0;
+    }
+}
+
+/* The scripted devices answer word i of any command with its code plus i */
+uint16_t scripted_word(uint8_t address, uint8_t index)
+{
+    return (uint16_t)((address == k_device_a ? k_command_a.code : k_command_b.code) + index);
+}
+
+int8_t timed_read(uint8_t address, uint8_t *data, uint8_t count)
+{
+    device_t *device = find_device(address);
+    if (device == nullptr) {
+        return -1;
+    }
+    uint64_t start_us = test_support::SimulatedClock::NowUs();
+    test_support::SimulatedClock::AdvanceUs((count + 1) * k_byte_us);
+    device->reads++;
+    device->read_start_us = start_us;
+    if (start_us < device->write_end_us + device->exec_time_us) {
+        device->early_reads++;
+        return -1;
+    }
+    if (address == SCD40_I2C_ADDR_62) {
+        return scd4x_sim_bus.read(address, data, count);
+    }
+    for (uint8_t i = 0; i + 3 <= count; i += 3) {
+        sensirion_common_uint16_t_to_bytes(scripted_word(address, i / 3), &data[i]);
+        data[i + 2] = sensirion_i2c_generate_crc(&data[i], SENSIRION_WORD_SIZE);
+    }
+    return 0;
+}
+
+int8_t timed_write(uint8_t address, const uint8_t *data, uint8_t count)
+{
+    device_t *device = find_device(address);
+    if (device == nullptr) {
+        return -1;
+    }
+    test_support::SimulatedClock::AdvanceUs((count + 1) * k_byte_us);
+    device->writes++;
+    device->write_end_us = test_support::SimulatedClock::NowUs();
+    if (address == SCD40_I2C_ADDR_62) {
+        return scd4x_sim_bus.write(address, data, count);
+    }
+    return 0;
+}
+
+const sensirion_i2c_hal_bus_t k_timed_bus = {timed_read, timed_write};
+
+/* Simulator measuring 800 ppm with a sample waiting */
+void prepare_simulator()
+{
+    scd4x_sim_reset();
+    scd4x_sim_set_signal(800, 21000, 45000);
+    TEST_CHECK_EQUAL(scd4x_start_periodic_measurement(), NO_ERROR);
+    test_support::SimulatedClock::AdvanceUs(5000000);
+}
+
+/* Every read came after its execution time and within one frame of it */
+void check_read_timing(const device_t &device)
+{
+    TEST_CHECK_EQUAL(device.writes, 1);
+    TEST_CHECK_EQUAL(device.reads, 1);
+    TEST_CHECK_EQUAL(device.early_reads, 0);
+    uint64_t ready_us = device.write_end_us + device.exec_time_us;
+    TEST_CHECK(device.read_start_us >= ready_us);
+    TEST_CHECK(device.read_start_us <= ready_us + k_max_frame_us);
+}
+
+void test_poll_all()
+{
+    prepare_simulator();
+    reset_devices();
+
+    sensirion_i2c_cmd_t measurement;
+    sensirion_i2c_cmd_t command_a;
+    sensirion_i2c_cmd_t command_b;
+    const uint16_t arg = 0x0190;
+    TEST_CHECK_EQUAL(sensirion_i2c_cmd_start(&measurement, SCD40_I2C_ADDR_62,
+                                             &scd4x_commands[scd4x_cmd_read_measurement_raw], nullptr),
+                     NO_ERROR);
+    TEST_CHECK_EQUAL(sensirion_i2c_cmd_start(&command_a, k_device_a, &k_command_a, nullptr), NO_ERROR);
+    TEST_CHECK_EQUAL(sensirion_i2c_cmd_start(&command_b, k_device_b, &k_command_b, &arg), NO_ERROR);
+    sensirion_i2c_cmd_t *const commands[] = {&measurement, &command_a, &command_b};
+
+    /* One pass writes all three: the last write ends well after the `now_us` it was given */
+    int passes = 0;
+    for (;;) {
+        uint64_t now_us = test_support::SimulatedClock::NowUs();
+        uint64_t next_us = sensirion_i2c_cmd_poll_all(commands, 3, now_us);
+        if (next_us == UINT64_MAX || ++passes > 100) {
+            break;
+        }
+        if (next_us > test_support::SimulatedClock::NowUs()) {
+            test_support::SimulatedClock::AdvanceUs(next_us - test_support::SimulatedClock::NowUs());
+        }
+    }
+    TEST_CHECK(passes <= 100);
+
+    for (const sensirion_i2c_cmd_t *command : commands) {
+        TEST_CHECK_EQUAL(command->state, SENSIRION_I2C_CMD_STATE_DONE);
+        TEST_CHECK_EQUAL(command->error, NO_ERROR);
+    }
+    for (const device_t &device : s_devices) {
+        check_read_timing(device);
+    }
+
+    /* The reads went in order of readiness, not of the array */
+    TEST_CHECK(s_devices[0].read_start_us < s_devices[1].read_start_us);
+    TEST_CHECK(s_devices[1].read_start_us < s_devices[2].read_start_us);
+
+    TEST_CHECK_EQUAL(sensirion_i2c_cmd_response_word(&measurement, 0), 800);
+    TEST_CHECK_EQUAL(sensirion_i2c_cmd_response_word(&command_a, 0), k_command_a.code);
+    TEST_CHECK_EQUAL(sensirion_i2c_cmd_response_word(&command_a, 1), k_command_a.code + 1);
+    TEST_CHECK_EQUAL(sensirion_i2c_cmd_response_word(&command_b, 0), k_command_b.code);
+}
+
+/* A caller that takes the time once and polls with it right after the write still never reads early */
+void test_stale_now()
+{
+    prepare_simulator();
+    reset_devices();
+
+    sensirion_i2c_cmd_t measurement;
+    TEST_CHECK_EQUAL(sensirion_i2c_cmd_start(&measurement, SCD40_I2C_ADDR_62,
+                                             &scd4x_commands[scd4x_cmd_read_measurement_raw], nullptr),
+                     NO_ERROR);
+    uint64_t stale_us = test_support::SimulatedClock::NowUs();
+    TEST_CHECK(!sensirion_i2c_cmd_poll(&measurement, stale_us));
+    TEST_CHECK_EQUAL(measurement.ready_at_us, s_devices[0].write_end_us + s_devices[0].exec_time_us);
+
+    /* Advance to what the stale time would have claimed: still not ready, no read */
+    test_support::SimulatedClock::AdvanceUs(stale_us + s_devices[0].exec_time_us -
+                                            test_support::SimulatedClock::NowUs());
+    TEST_CHECK(!sensirion_i2c_cmd_poll(&measurement, test_support::SimulatedClock::NowUs()));
+    TEST_CHECK_EQUAL(s_devices[0].reads, 0);
+
+    test_support::SimulatedClock::AdvanceUs(measurement.ready_at_us - test_support::SimulatedClock::NowUs());
+    TEST_CHECK(sensirion_i2c_cmd_poll(&measurement, test_support::SimulatedClock::NowUs()));
+    TEST_CHECK_EQUAL(measurement.error, NO_ERROR);
+    check_read_timing(s_devices[0]);
+    TEST_CHECK_EQUAL(s_devices[0].read_start_us, measurement.ready_at_us);
+}
+
+/* The blocking path takes exactly write, execution and read time */
+void test_run()
+{
+    prepare_simulator();
+    reset_devices();
+
+    sensirion_i2c_cmd_t measurement;
+    TEST_CHECK_EQUAL(sensirion_i2c_cmd_start(&measurement, SCD40_I2C_ADDR_62,
+                                             &scd4x_commands[scd4x_cmd_read_measurement_raw], nullptr),
+                     NO_ERROR);
+    uint64_t started_us = test_support::SimulatedClock::NowUs();
+    TEST_CHECK_EQUAL(sensirion_i2c_cmd_run(&measurement), NO_ERROR);
+    uint64_t elapsed_us = test_support::SimulatedClock::NowUs() - started_us;
+
+    check_read_timing(s_devices[0]);
+    uint64_t write_us = (1 + SENSIRION_COMMAND_SIZE) * k_byte_us;
+    uint64_t read_us = (1 + 3 * 3) * k_byte_us;
+    TEST_CHECK_EQUAL(elapsed_us, write_us + s_devices[0].exec_time_us + read_us);
+}
+
+} // namespace
+
+int main()
+{
+    test_support::SimulatedClock::Install();
+    sensirion_i2c_hal_set_bus(&k_timed_bus);
+    scd4x_init(SCD40_I2C_ADDR_62);
+
+    test_poll_all();
+    test_stale_now();
+    test_run();
+
+    sensirion_i2c_hal_set_bus(NULL);
+    test_support::SimulatedClock::Remove();
+    return test_support::Finish("sensirion-cmd-poll-test");
+}
@@ -0,0 +1,146 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* Corrupted response frames must never reach the caller.
+ *
+ * Every single-bit error, and every two-bit error within one word, in the frames the simulated SCD4x sends back is
+ * fed through the single-pass decoders and through scd4x_read_measurement_raw(), and each one must end in CRC_ERROR.
+ * The same frames unmodified must decode to the words that were sent. */
+
+#include "test-support.h"
+
+#include <string.h>
+
+#include "scd4x_i2c.h"
+#include "scd4x_sim.h"
+#include "sensirion_common.h"
+#include "sensirion_i2c.h"
+#include "sensirion_i2c_hal.h"
+
+namespace {
+
+const uint16_t k_words[3] = {0x01f4, 0x6667, 0x5eb9};
+const uint8_t k_frame_size = sizeof(k_words) / sizeof(k_words[0]) * (SENSIRION_WORD_SIZE + CRC8_LEN);
+
+/* Bits of the next read to flip, -1 for none */
+int s_flip_bits[2] = {-1, -1};
+
+int8_t flipping_read(uint8_t address, uint8_t *data, uint8_t count)
+{
+    int8_t result = scd4x_sim_bus.read(address, data, count);
+    for (int bit : s_flip_bits) {
+        if (result == 0 && bit >= 0 && bit / 8 < count) {
+            data[bit / 8] ^= (uint8_t)(1u << (bit % 8));
+        }
+    }
+    return result;
+}
+
+int8_t passthrough_write(uint8_t address, const uint8_t *data, uint8_t count)
+{
+    return scd4x_sim_bus.write(address, data, count);
+}
+
+const sensirion_i2c_hal_bus_t k_flipping_bus = {flipping_read, passthrough_write};
+
+void make_frame(uint8_t *frame)
+{
+    uint16_t offset = 0;
+    for (uint16_t word : k_words) {
+        offset = sensirion_i2c_add_uint16_t_to_buffer(frame, offset, word);
+    }
+}
+
+/* Both single-pass decoders on a frame with the given bits flipped; -1 leaves the frame intact */
+void check_decoders(int first_bit, int second_bit)
+{
+    uint8_t frame[k_frame_size];
+    make_frame(frame);
+    const int bits[] = {first_bit, second_bit};
+    for (int bit : bits) {
+        if (bit >= 0) {
+            frame[bit / 8] ^= (uint8_t)(1u << (bit % 8));
+        }
+    }
+    int16_t expected = first_bit < 0 && second_bit < 0 ? NO_ERROR : CRC_ERROR;
+
+    uint16_t words[3] = {};
+    TEST_CHECK_EQUAL(sensirion_i2c_decode_words(frame, words, 3), expected);
+    if (expected == NO_ERROR) {
+        TEST_CHECK(memcmp(words, k_words, sizeof(words)) == 0);
+    }
+
+    TEST_CHECK_EQUAL(sensirion_i2c_compact_words_inplace(frame, 3), expected);
+    if (expected == NO_ERROR) {
+        for (int i = 0; i < 3; i++) {
+            TEST_CHECK_EQUAL(sensirion_common_bytes_to_uint16_t(&frame[i * SENSIRION_WORD_SIZE]), k_words[i]);
+        }
+    }
+}
+
+/* A measurement read from the simulator with the given bits of its response flipped */
+int16_t read_measurement(int first_bit, int second_bit, uint16_t *co2)
+{
+    uint16_t temperature;
+    uint16_t humidity;
+    /* Each read consumes the measurement, so wait for the next one */
+    test_support::SimulatedClock::AdvanceUs(5000000);
+    s_flip_bits[0] = first_bit;
+    s_flip_bits[1] = second_bit;
+    int16_t error = scd4x_read_measurement_raw(co2, &temperature, &humidity);
+    s_flip_bits[0] = s_flip_bits[1] = -1;
+    return error;
+}
+
+} // namespace
+
+int main()
+{
+    const int frame_bits = k_frame_size * 8;
+    const int word_bits = (SENSIRION_WORD_SIZE + CRC8_LEN) * 8;
+
+    check_decoders(-1, -1);
+    for (int bit = 0; bit < frame_bits; bit++) {
+        check_decoders(bit, -1);
+    }
+    for (int word = 0; word < 3; word++) {
+        for (int first = word * word_bits; first < (word + 1) * word_bits; first++) {
+            for (int second = first + 1; second < (word + 1) * word_bits; second++) {
+                check_decoders(first, second);
+            }
+        }
+    }
+
+    test_support::SimulatedClock::Install();
+    sensirion_i2c_hal_set_bus(&k_flipping_bus);
+    scd4x_init(SCD40_I2C_ADDR_62);
+    scd4x_sim_reset();
+    scd4x_sim_set_signal(500, 22500, 45000);
+    TEST_CHECK_EQUAL(scd4x_start_periodic_measurement(), NO_ERROR);
+
+    uint16_t co2 = 0;
+    TEST_CHECK_EQUAL(read_measurement(-1, -1, &co2), NO_ERROR);
+    TEST_CHECK_EQUAL(co2, 500);
+    for (int bit = 0; bit < frame_bits; bit++) {
+        co2 = 0;
+        TEST_CHECK_EQUAL(read_measurement(bit, -1, &co2), CRC_ERROR);
+        TEST_CHECK_EQUAL(co2, 0);
+    }
+    for (int first = 0; first < word_bits; first++) {
+        for (int second = first + 1; second < word_bits; second++) {
+            TEST_CHECK_EQUAL(read_measurement(first, second, &co2), CRC_ERROR);
+        }
+    }
+    /* A corrupted read leaves the driver and the simulator in step */
+    TEST_CHECK_EQUAL(read_measurement(-1, -1, &co2), NO_ERROR);
+    TEST_CHECK_EQUAL(co2, 500);
+
+    sensirion_i2c_hal_set_bus(NULL);
+    test_support::SimulatedClock::Remove();
+    return test_support::Finish("sensirion-crc-test");
+}
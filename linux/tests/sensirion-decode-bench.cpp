@@ -0,0 +1,113 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* Host benchmark of the response decode path.
+ *
+ * Times the single-pass decoders against the two-pass copy, check and byte-swap they replaced (kept here as a
+ * reference), and a whole scd4x_read_measurement_raw() against the simulated SCD4x on a simulated clock. Prints
+ * `name,iterations,total_ns,ns_per_op` lines, like `matter esp bench drivers` on the device.
+ *
+ * Usage: sensirion-decode-bench [iterations] */
+
+#include "test-support.h"
+
+#include <chrono>
+#include <inttypes.h>
+#include <stdlib.h>
+
+#include "scd4x_i2c.h"
+#include "scd4x_sim.h"
+#include "sensirion_common.h"
+#include "sensirion_i2c.h"
+#include "sensirion_i2c_hal.h"
+
+namespace {
+
+const uint16_t k_num_words = 3;
+const uint16_t k_frame_size = k_num_words * (SENSIRION_WORD_SIZE + CRC8_LEN);
+
+volatile uint32_t s_sink;
+
+/* The decode before the single-pass rework: CRC check and copy into a byte buffer, then a second byte-swap pass */
+int16_t two_pass_decode(const uint8_t *frame, uint16_t *data_words, uint16_t num_words)
+{
+    uint8_t *data = (uint8_t *)data_words;
+    uint16_t size = num_words * (SENSIRION_WORD_SIZE + CRC8_LEN);
+    for (uint16_t i = 0, j = 0; i < size; i += SENSIRION_WORD_SIZE + CRC8_LEN) {
+        int16_t ret = sensirion_i2c_check_crc(&frame[i], SENSIRION_WORD_SIZE, frame[i + SENSIRION_WORD_SIZE]);
+        if (ret != NO_ERROR) {
+            return ret;
+        }
+        data[j++] = frame[i];
+        data[j++] = frame[i + 1];
+    }
+    for (uint16_t i = 0; i < num_words; i++) {
+        const uint8_t *word_bytes = (const uint8_t *)&data_words[i];
+        data_words[i] = (uint16_t)(word_bytes[0] << 8 | word_bytes[1]);
+    }
+    return NO_ERROR;
+}
+
+template <typename Body>
+void bench(const char *name, uint32_t iterations, Body body)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; i++) {
+        s_sink = s_sink + (uint32_t)body(i);
+    }
+    int64_t total_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    printf("%s,%" PRIu32 ",%" PRId64 ",%" PRId64 "\n", name, iterations, total_ns,
+           iterations ? total_ns / iterations : 0);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    uint32_t iterations = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 0) : 1000000;
+
+    uint8_t frame[k_frame_size];
+    uint16_t offset = 0;
+    offset = sensirion_i2c_add_uint16_t_to_buffer(frame, offset, 0x01f4);
+    offset = sensirion_i2c_add_uint16_t_to_buffer(frame, offset, 0x6667);
+    sensirion_i2c_add_uint16_t_to_buffer(frame, offset, 0x5eb9);
+    uint16_t words[k_num_words];
+
+    printf("name,iterations,total_ns,ns_per_op\n");
+    /* The last CRC byte is corrupted on every other iteration so the error path is timed as well */
+    bench("decode_words_3", iterations, [&](uint32_t i) {
+        frame[k_frame_size - 1] ^= (uint8_t)(i & 1);
+        return sensirion_i2c_decode_words(frame, words, k_num_words) + words[0];
+    });
+    bench("two_pass_decode_3", iterations, [&](uint32_t i) {
+        frame[k_frame_size - 1] ^= (uint8_t)(i & 1);
+        return two_pass_decode(frame, words, k_num_words) + words[0];
+    });
+    bench("compact_words_inplace_3", iterations, [&](uint32_t i) {
+        uint8_t copy[k_frame_size];
+        for (uint16_t b = 0; b < k_frame_size; b++) {
+            copy[b] = frame[b];
+        }
+        copy[k_frame_size - 1] ^= (uint8_t)(i & 1);
+        return sensirion_i2c_compact_words_inplace(copy, k_num_words) + copy[0];
+    });
+
+    /* Command frame, simulated sensor and response decode; the measurement interval passes between reads */
+    test_support::SimulatedClock::Install();
+    scd4x_init(SCD40_I2C_ADDR_62);
+    scd4x_sim_reset();
+    scd4x_start_periodic_measurement();
+    bench("read_measurement_raw_sim", iterations / 10, [&](uint32_t) {
+        uint16_t co2, temperature, humidity;
+        test_support::SimulatedClock::AdvanceUs(5000000);
+        return scd4x_read_measurement_raw(&co2, &temperature, &humidity) + co2;
+    });
+    test_support::SimulatedClock::Remove();
+    return 0;
+}
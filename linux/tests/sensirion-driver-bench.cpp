@@ -0,0 +1,86 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* Host benchmark of the Sensirion driver helpers.
+ *
+ * Runs the benchmarks of `matter esp bench drivers` (CRC, command and argument buffer builders, byte decoders, frame
+ * decode and the SCD4x conversions), then whole commands against the simulated SCD4x on a simulated clock, so the
+ * execution times cost nothing and only the driver and simulator code is timed. Prints the same
+ * `name,iterations,total_ns,ns_per_op` lines as the device.
+ *
+ * Usage: sensirion-driver-bench [iterations] */
+
+#include "test-support.h"
+
+#include <chrono>
+#include <stdlib.h>
+
+#include <driver-bench.h>
+
+#include "scd4x_i2c.h"
+#include "scd4x_sim.h"
+#include "sensirion_common.h"
+#include "sensirion_i2c_hal.h"
+
+namespace {
+
+volatile uint32_t s_sink;
+
+void print(const driver_bench::result_t *result, void *ctx)
+{
+    driver_bench::print_result(stdout, result, "\n");
+}
+
+/* Timed on a steady clock: the simulated clock only moves when the driver sleeps */
+template <typename Body>
+void bench_command(const char *name, uint32_t iterations, Body body)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; i++) {
+        s_sink = s_sink + (uint32_t)body(i);
+    }
+    int64_t total_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    driver_bench::result_t result = {name, iterations, total_ns};
+    print(&result, NULL);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    uint32_t iterations = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 0) : driver_bench::k_default_iterations * 100;
+
+    driver_bench::print_header(stdout, "\n");
+    driver_bench::run(iterations, print, NULL);
+
+    /* Whole commands through the HAL: frame, simulated sensor, CRC check and decode */
+    test_support::SimulatedClock::Install();
+    sensirion_i2c_hal_set_bus(&scd4x_sim_bus);
+    scd4x_init(SCD40_I2C_ADDR_62);
+    scd4x_sim_reset();
+
+    uint32_t command_iterations = iterations / 10;
+    bench_command("set_sensor_altitude_sim", command_iterations,
+                  [](uint32_t i) { return scd4x_set_sensor_altitude((uint16_t)(i & 0x3ff)); });
+    bench_command("get_serial_number_sim", command_iterations, [](uint32_t) {
+        uint16_t serial[3];
+        return scd4x_get_serial_number(serial, 3) + serial[0];
+    });
+    scd4x_start_periodic_measurement();
+    bench_command("read_measurement_raw_sim", command_iterations, [](uint32_t) {
+        uint16_t co2, temperature, humidity;
+        test_support::SimulatedClock::AdvanceUs(5000000);
+        return scd4x_read_measurement_raw(&co2, &temperature, &humidity) + co2;
+    });
+    scd4x_stop_periodic_measurement();
+
+    sensirion_i2c_hal_set_bus(NULL);
+    test_support::SimulatedClock::Remove();
+    return 0;
+}
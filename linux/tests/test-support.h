@@ -0,0 +1,81 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "sensirion_i2c_hal.h"
+
+/** Checks and a simulated clock for the host tests
+ *
+ * The tests are plain executables that print every failed check and exit non-zero if there was one, so they need
+ * nothing beyond the driver sources and run the same under gn, a sanitizer build or by hand.
+ */
+namespace test_support {
+
+inline int g_failures = 0;
+
+/** Simulated time for the Sensirion HAL: sleeping only moves the clock, so command delays cost nothing */
+class SimulatedClock
+{
+public:
+    /** Route the HAL clock here, starting at `start_us` */
+    static void Install(uint64_t start_us = 0)
+    {
+        sNowUs = start_us;
+        sensirion_i2c_hal_set_clock(&kClock);
+    }
+
+    static void Remove() { sensirion_i2c_hal_set_clock(NULL); }
+
+    static uint64_t NowUs() { return sNowUs; }
+
+    static void AdvanceUs(uint64_t duration_us) { sNowUs += duration_us; }
+
+private:
+    static uint64_t GetTimeUsec() { return sNowUs; }
+    static void SleepUsec(uint32_t duration_us) { sNowUs += duration_us; }
+
+    static inline uint64_t sNowUs = 0;
+    static constexpr sensirion_i2c_hal_clock_t kClock = {GetTimeUsec, SleepUsec};
+};
+
+/** Exit status for main() */
+inline int Finish(const char *name)
+{
+    if (g_failures > 0) {
+        printf("%s: %d check(s) failed\n", name, g_failures);
+        return 1;
+    }
+    printf("%s: passed\n", name);
+    return 0;
+}
+
+} // namespace test_support
+
+/** Record a failure, with the expression and the source line, if `condition` is false; execution goes on */
+#define TEST_CHECK(condition)                                                                                          \
+    do {                                                                                                               \
+        if (!(condition)) {                                                                                            \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);                                       \
+            test_support::g_failures++;                                                                                \
+        }                                                                                                              \
+    } while (0)
+
+/** TEST_CHECK for an equality, printing both sides as integers */
+#define TEST_CHECK_EQUAL(actual, expected)                                                                             \
+    do {                                                                                                               \
+        long long actual_value = (long long)(actual);                                                                  \
+        long long expected_value = (long long)(expected);                                                              \
+        if (actual_value != expected_value) {                                                                          \
+            printf("%s:%d: %s is %lld, expected %lld\n", __FILE__, __LINE__, #actual, actual_value, expected_value);   \
+            test_support::g_failures++;                                                                                \
+        }                                                                                                              \
+    } while (0)
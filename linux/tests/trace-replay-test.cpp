@@ -0,0 +1,121 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* Replays the recorded traces in linux/traces and compares the published attribute sequence with the checked-in
+ * expected output, then checks that the binary form of a trace replays to the same sequence.
+ *
+ * The expected output is for the filter settings in linux/include/sdkconfig.h; regenerate it with
+ * `trace-replay <trace> > <trace>.expected.csv` when those change. */
+
+#include "test-support.h"
+
+#include <string>
+#include <vector>
+
+#include "trace-replay.h"
+
+#ifndef TRACE_DIR
+#error "TRACE_DIR must point at linux/traces"
+#endif
+
+namespace {
+
+std::string read_all(FILE *file)
+{
+    std::string contents;
+    char buffer[4096];
+    size_t count;
+    rewind(file);
+    while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        contents.append(buffer, count);
+    }
+    return contents;
+}
+
+bool read_file(const std::string &path, std::string *contents)
+{
+    FILE *file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    *contents = read_all(file);
+    fclose(file);
+    return true;
+}
+
+/* Replay `records` and return the output, or an empty string if the replay failed */
+std::string replay_to_string(const std::vector<trace_replay::record_t> &records)
+{
+    FILE *out = tmpfile();
+    if (out == nullptr) {
+        return std::string();
+    }
+    trace_replay::stage_timing_t timings[trace_replay::STAGE_MAX];
+    bool ok = trace_replay::replay(records, out, timings);
+    std::string contents = ok ? read_all(out) : std::string();
+    fclose(out);
+    for (const trace_replay::stage_timing_t &timing : timings) {
+        TEST_CHECK_EQUAL(timing.samples, records.size());
+    }
+    return contents;
+}
+
+/* Line number of the first difference, 0 if none */
+size_t first_difference(const std::string &actual, const std::string &expected)
+{
+    size_t line = 1;
+    for (size_t i = 0; i < actual.size() || i < expected.size(); i++) {
+        if (i >= actual.size() || i >= expected.size() || actual[i] != expected[i]) {
+            return line;
+        }
+        line += actual[i] == '\n';
+    }
+    return 0;
+}
+
+void check_trace(const char *name)
+{
+    const std::string base = std::string(TRACE_DIR) + "/" + name;
+    printf("%s\n", name);
+
+    std::vector<trace_replay::record_t> records;
+    std::string error;
+    if (!trace_replay::load((base + ".csv").c_str(), &records, &error)) {
+        printf("%s\n", error.c_str());
+        test_support::g_failures++;
+        return;
+    }
+    TEST_CHECK(!records.empty());
+
+    std::string expected;
+    TEST_CHECK(read_file(base + ".expected.csv", &expected));
+    std::string actual = replay_to_string(records);
+    TEST_CHECK_EQUAL(first_difference(actual, expected), 0);
+
+    /* Through the binary form: same records, same output */
+    FILE *binary = tmpfile();
+    TEST_CHECK(binary != nullptr && trace_replay::save_binary(binary, records));
+    if (binary == nullptr) {
+        return;
+    }
+    fflush(binary);
+    std::string binary_path = "/proc/self/fd/" + std::to_string(fileno(binary));
+    std::vector<trace_replay::record_t> binary_records;
+    TEST_CHECK(trace_replay::load(binary_path.c_str(), &binary_records, &error));
+    fclose(binary);
+    TEST_CHECK_EQUAL(binary_records.size(), records.size());
+    TEST_CHECK_EQUAL(first_difference(replay_to_string(binary_records), expected), 0);
+}
+
+} // namespace
+
+int main()
+{
+    check_trace("sim-ramp-2h");
+    return test_support::Finish("trace-replay-test");
+}
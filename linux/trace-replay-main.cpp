@@ -0,0 +1,78 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include "trace-replay.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Replays a recorded SCD4x trace through the driver and measurement_pipeline on a virtual clock, or records one from
+ * the simulated sensor. */
+
+static void usage(const char *program)
+{
+    fprintf(stderr,
+            "Usage: %s <trace>\n"
+            "       Replay <trace> (CSV or binary), print the published attribute sequence on stdout and the time\n"
+            "       spent per stage on stderr.\n"
+            "   or: %s --capture-sim <seconds> [--binary]\n"
+            "       Record <seconds> of the simulated sensor, one read every 5 s, to stdout.\n"
+            "   or: %s --to-binary <trace>\n"
+            "   or: %s --to-csv <trace>\n"
+            "       Convert <trace> to the other format, to stdout.\n",
+            program, program, program, program);
+}
+
+static bool load_or_report(const char *path, std::vector<trace_replay::record_t> *records)
+{
+    std::string error;
+    if (!trace_replay::load(path, records, &error)) {
+        fprintf(stderr, "%s: %s\n", path, error.c_str());
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    std::vector<trace_replay::record_t> records;
+
+    if (argc >= 3 && strcmp(argv[1], "--capture-sim") == 0) {
+        char *end;
+        unsigned long duration_s = strtoul(argv[2], &end, 10);
+        bool binary = argc == 4 && strcmp(argv[3], "--binary") == 0;
+        if (*end != '\0' || duration_s == 0 || argc > (binary ? 4 : 3)) {
+            usage(argv[0]);
+            return 2;
+        }
+        trace_replay::capture_sim((uint32_t)duration_s, 5000, &records);
+        bool ok = binary ? trace_replay::save_binary(stdout, records) : trace_replay::save_csv(stdout, records);
+        return ok ? 0 : 1;
+    }
+
+    if (argc == 3 && (strcmp(argv[1], "--to-binary") == 0 || strcmp(argv[1], "--to-csv") == 0)) {
+        if (!load_or_report(argv[2], &records)) {
+            return 1;
+        }
+        bool ok = strcmp(argv[1], "--to-binary") == 0 ? trace_replay::save_binary(stdout, records)
+                                                       : trace_replay::save_csv(stdout, records);
+        return ok ? 0 : 1;
+    }
+
+    if (argc != 2 || argv[1][0] == '-') {
+        usage(argv[0]);
+        return 2;
+    }
+    if (!load_or_report(argv[1], &records)) {
+        return 1;
+    }
+    trace_replay::stage_timing_t timings[trace_replay::STAGE_MAX];
+    bool ok = trace_replay::replay(records, stdout, timings);
+    trace_replay::print_timings(stderr, timings);
+    return ok ? 0 : 1;
+}
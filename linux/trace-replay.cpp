@@ -0,0 +1,335 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include "trace-replay.h"
+
+#include <chrono>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "drivers/scd4x_i2c.h"
+#include "drivers/scd4x_sim.h"
+#include "drivers/sensirion_common.h"
+#include "drivers/sensirion_i2c.h"
+#include "drivers/sensirion_i2c_hal.h"
+
+namespace trace_replay {
+
+static const char k_magic[8] = {'S', 'C', 'D', '4', 'X', 'T', 'R', '1'};
+static const size_t k_binary_record_size = 14;
+
+/* Simulated HAL clock: the replay sets it to each record's timestamp, driver delays move it on */
+static uint64_t s_now_us;
+
+static uint64_t sim_get_time_usec(void)
+{
+    return s_now_us;
+}
+
+static void sim_sleep_usec(uint32_t duration_us)
+{
+    s_now_us += duration_us;
+}
+
+static const sensirion_i2c_hal_clock_t k_sim_clock = {sim_get_time_usec, sim_sleep_usec};
+
+/* Replay bus: answers read_measurement_raw with the current record's words */
+static const record_t *s_record;
+static uint8_t s_response[3 * (SENSIRION_WORD_SIZE + CRC8_LEN)];
+static bool s_response_pending;
+
+static int8_t replay_write(uint8_t address, const uint8_t *data, uint8_t count)
+{
+    const sensirion_i2c_cmd_desc_t &desc = scd4x_commands[scd4x_cmd_read_measurement_raw];
+    if (address != SCD40_I2C_ADDR_62 || count != SENSIRION_COMMAND_SIZE || s_record == nullptr ||
+        sensirion_common_bytes_to_uint16_t(data) != desc.code) {
+        return -1;
+    }
+    uint16_t offset = 0;
+    offset = sensirion_i2c_add_uint16_t_to_buffer(s_response, offset, s_record->raw.co2_concentration);
+    offset = sensirion_i2c_add_uint16_t_to_buffer(s_response, offset, s_record->raw.temperature);
+    sensirion_i2c_add_uint16_t_to_buffer(s_response, offset, s_record->raw.relative_humidity);
+    s_response_pending = true;
+    return 0;
+}
+
+static int8_t replay_read(uint8_t address, uint8_t *data, uint8_t count)
+{
+    if (address != SCD40_I2C_ADDR_62 || !s_response_pending || count != sizeof(s_response)) {
+        return -1;
+    }
+    memcpy(data, s_response, count);
+    s_response_pending = false;
+    return 0;
+}
+
+static const sensirion_i2c_hal_bus_t k_replay_bus = {replay_read, replay_write};
+
+static bool parse_csv_line(const char *line, record_t *record)
+{
+    char *end;
+    errno = 0;
+    record->timestamp_us = strtoll(line, &end, 0);
+    uint16_t *words[] = {&record->raw.co2_concentration, &record->raw.temperature, &record->raw.relative_humidity};
+    for (uint16_t *word : words) {
+        if (*end != ',') {
+            return false;
+        }
+        unsigned long value = strtoul(end + 1, &end, 0);
+        if (value > 0xffff) {
+            return false;
+        }
+        *word = (uint16_t)value;
+    }
+    while (*end == ' ' || *end == '\r' || *end == '\n') {
+        end++;
+    }
+    return *end == '\0' && errno == 0;
+}
+
+static bool load_csv(FILE *file, std::vector<record_t> *records, std::string *error)
+{
+    char line[256];
+    unsigned line_number = 0;
+    while (fgets(line, sizeof(line), file) != nullptr) {
+        line_number++;
+        if (line[0] == '#' || line[0] == '\n' || line[0] == '\r' || strncmp(line, "timestamp_us", 12) == 0) {
+            continue;
+        }
+        record_t record;
+        if (!parse_csv_line(line, &record)) {
+            *error = "line " + std::to_string(line_number) + " is not timestamp_us,co2,temperature,humidity";
+            return false;
+        }
+        records->push_back(record);
+    }
+    return true;
+}
+
+static bool load_binary(FILE *file, std::vector<record_t> *records, std::string *error)
+{
+    uint8_t bytes[k_binary_record_size];
+    size_t count;
+    while ((count = fread(bytes, 1, sizeof(bytes), file)) == sizeof(bytes)) {
+        record_t record;
+        uint64_t timestamp = 0;
+        for (int i = 7; i >= 0; i--) {
+            timestamp = timestamp << 8 | bytes[i];
+        }
+        record.timestamp_us = (int64_t)timestamp;
+        record.raw.co2_concentration = (uint16_t)(bytes[8] | bytes[9] << 8);
+        record.raw.temperature = (uint16_t)(bytes[10] | bytes[11] << 8);
+        record.raw.relative_humidity = (uint16_t)(bytes[12] | bytes[13] << 8);
+        records->push_back(record);
+    }
+    if (count != 0) {
+        *error = "truncated record at the end of the file";
+        return false;
+    }
+    return true;
+}
+
+bool load(const char *path, std::vector<record_t> *records, std::string *error)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == nullptr) {
+        *error = std::string("cannot open ") + path + ": " + strerror(errno);
+        return false;
+    }
+    char magic[sizeof(k_magic)];
+    bool binary = fread(magic, 1, sizeof(magic), file) == sizeof(magic) && memcmp(magic, k_magic, sizeof(k_magic)) == 0;
+    if (!binary) {
+        rewind(file);
+    }
+    records->clear();
+    bool ok = binary ? load_binary(file, records, error) : load_csv(file, records, error);
+    fclose(file);
+    return ok;
+}
+
+bool save_csv(FILE *file, const std::vector<record_t> &records)
+{
+    fprintf(file, "timestamp_us,co2_word,temperature_word,humidity_word\n");
+    for (const record_t &record : records) {
+        fprintf(file, "%" PRId64 ",%u,0x%04x,0x%04x\n", record.timestamp_us, record.raw.co2_concentration,
+                record.raw.temperature, record.raw.relative_humidity);
+    }
+    return ferror(file) == 0;
+}
+
+bool save_binary(FILE *file, const std::vector<record_t> &records)
+{
+    fwrite(k_magic, 1, sizeof(k_magic), file);
+    for (const record_t &record : records) {
+        uint8_t bytes[k_binary_record_size];
+        uint64_t timestamp = (uint64_t)record.timestamp_us;
+        for (int i = 0; i < 8; i++) {
+            bytes[i] = (uint8_t)(timestamp >> (8 * i));
+        }
+        const uint16_t words[] = {record.raw.co2_concentration, record.raw.temperature, record.raw.relative_humidity};
+        for (int i = 0; i < 3; i++) {
+            bytes[8 + 2 * i] = (uint8_t)words[i];
+            bytes[9 + 2 * i] = (uint8_t)(words[i] >> 8);
+        }
+        fwrite(bytes, 1, sizeof(bytes), file);
+    }
+    return ferror(file) == 0;
+}
+
+void capture_sim(uint32_t duration_s, uint32_t period_ms, std::vector<record_t> *records)
+{
+    s_now_us = 0;
+    sensirion_i2c_hal_set_clock(&k_sim_clock);
+    sensirion_i2c_hal_set_bus(&scd4x_sim_bus);
+    scd4x_init(SCD40_I2C_ADDR_62);
+    scd4x_sim_reset();
+    scd4x_start_periodic_measurement();
+
+    records->clear();
+    uint64_t period_us = (uint64_t)period_ms * 1000;
+    for (uint64_t deadline_us = period_us; deadline_us <= (uint64_t)duration_s * 1000000; deadline_us += period_us) {
+        s_now_us = deadline_us;
+        record_t record;
+        if (scd4x_read_measurement_raw(&record.raw.co2_concentration, &record.raw.temperature,
+                                       &record.raw.relative_humidity) == NO_ERROR) {
+            record.timestamp_us = (int64_t)deadline_us;
+            records->push_back(record);
+        }
+    }
+
+    scd4x_stop_periodic_measurement();
+    sensirion_i2c_hal_set_bus(NULL);
+    sensirion_i2c_hal_set_clock(NULL);
+}
+
+static int16_t temperature_centi_deg_c(const measurement_pipeline::result_t &result)
+{
+    return (int16_t)(result.temperature_m_deg_c / 10);
+}
+
+static uint16_t humidity_centi_percent(const measurement_pipeline::result_t &result)
+{
+    int32_t value = result.humidity_m_percent_rh / 10;
+    return (uint16_t)(value < 0 ? 0 : value > 10000 ? 10000 : value);
+}
+
+static uint64_t elapsed_ns(std::chrono::steady_clock::time_point start)
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+static void account(stage_timing_t *timings, stage_t stage, uint64_t ns)
+{
+    if (timings == nullptr) {
+        return;
+    }
+    timings[stage].samples++;
+    timings[stage].total_ns += ns;
+    if (ns > timings[stage].max_ns) {
+        timings[stage].max_ns = ns;
+    }
+}
+
+bool replay(const std::vector<record_t> &records, FILE *out, stage_timing_t timings[STAGE_MAX])
+{
+    static const char *const k_stage_names[STAGE_MAX] = {"acquire", "pipeline", "publish"};
+    if (timings != nullptr) {
+        for (int stage = 0; stage < STAGE_MAX; stage++) {
+            timings[stage] = {k_stage_names[stage], 0, 0, 0};
+        }
+    }
+
+    sensirion_i2c_hal_set_clock(&k_sim_clock);
+    sensirion_i2c_hal_set_bus(&k_replay_bus);
+    scd4x_init(SCD40_I2C_ADDR_62);
+    measurement_pipeline::reset();
+
+    fprintf(out, "timestamp_us,co2_raw_ppm,co2_ppm,air_quality,temperature_centi_deg_c,humidity_centi_percent,"
+                 "changed\n");
+    /* Read every record through the driver first, into one array per word for the bulk conversion */
+    size_t count = records.size();
+    std::vector<uint16_t> raw_co2(count), raw_temperature(count), raw_humidity(count);
+    std::vector<int64_t> read_time_us(count);
+    bool ok = true;
+    size_t acquired = 0;
+    for (; acquired < count; acquired++) {
+        const record_t &record = records[acquired];
+        /* The read starts at the recorded time; the command's execution time moves the clock on from there */
+        s_now_us = (uint64_t)record.timestamp_us;
+        s_record = &record;
+        auto start = std::chrono::steady_clock::now();
+        int16_t error = scd4x_read_measurement_raw(&raw_co2[acquired], &raw_temperature[acquired],
+                                                   &raw_humidity[acquired]);
+        account(timings, STAGE_ACQUIRE, elapsed_ns(start));
+        if (error != NO_ERROR) {
+            fprintf(stderr, "Replay read failed at %" PRId64 " us, error:%d\n", record.timestamp_us, error);
+            ok = false;
+            break;
+        }
+        read_time_us[acquired] = (int64_t)s_now_us;
+    }
+
+    std::vector<uint16_t> co2(acquired);
+    std::vector<int32_t> temperature(acquired), humidity(acquired);
+    auto start = std::chrono::steady_clock::now();
+    scd4x_convert_measurements(raw_co2.data(), raw_temperature.data(), raw_humidity.data(), co2.data(),
+                               temperature.data(), humidity.data(), (uint32_t)acquired);
+    uint64_t convert_ns_per_sample = acquired ? elapsed_ns(start) / acquired : 0;
+
+    measurement_pipeline::result_t last = {};
+    bool have_last = false;
+    for (size_t i = 0; i < acquired; i++) {
+        const record_t &record = records[i];
+        measurement_pipeline::result_t result;
+        start = std::chrono::steady_clock::now();
+        measurement_pipeline::process_converted(co2[i], temperature[i], humidity[i], read_time_us[i], &result);
+        account(timings, STAGE_PIPELINE, convert_ns_per_sample + elapsed_ns(start));
+
+        start = std::chrono::steady_clock::now();
+        std::string changed;
+        const struct {
+            const char *name;
+            bool differs;
+        } attributes[] = {
+            {"co2", result.co2_ppm != last.co2_ppm},
+            {"aq", result.air_quality != last.air_quality},
+            {"t", temperature_centi_deg_c(result) != temperature_centi_deg_c(last)},
+            {"rh", humidity_centi_percent(result) != humidity_centi_percent(last)},
+        };
+        for (const auto &attribute : attributes) {
+            if (!have_last || attribute.differs) {
+                changed += changed.empty() ? attribute.name : std::string("|") + attribute.name;
+            }
+        }
+        fprintf(out, "%" PRId64 ",%u,%u,%d,%d,%u,%s\n", record.timestamp_us, result.co2_raw_ppm, result.co2_ppm,
+                result.air_quality, temperature_centi_deg_c(result), humidity_centi_percent(result), changed.c_str());
+        last = result;
+        have_last = true;
+        account(timings, STAGE_PUBLISH, elapsed_ns(start));
+    }
+
+    s_record = nullptr;
+    sensirion_i2c_hal_set_bus(NULL);
+    sensirion_i2c_hal_set_clock(NULL);
+    return ok;
+}
+
+void print_timings(FILE *out, const stage_timing_t timings[STAGE_MAX])
+{
+    fprintf(out, "stage,samples,total_ns,mean_ns,max_ns\n");
+    for (int stage = 0; stage < STAGE_MAX; stage++) {
+        const stage_timing_t &timing = timings[stage];
+        fprintf(out, "%s,%" PRIu32 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 "\n", timing.name, timing.samples,
+                timing.total_ns, timing.samples ? timing.total_ns / timing.samples : 0, timing.max_ns);
+    }
+}
+
+} // namespace trace_replay
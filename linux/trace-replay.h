@@ -0,0 +1,91 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include <measurement-pipeline.h>
+
+/** Recorded SCD4x traces and their replay through the target's measurement path
+ *
+ * A trace is the raw measurement words as the sensor sent them, with the time each one was read. Two formats:
+ * - CSV: `timestamp_us,co2_word,temperature_word,humidity_word`, one record per line, numbers in decimal or 0x hex.
+ *   Empty lines, lines starting with `#` and a header line starting with `timestamp_us` are skipped.
+ * - Binary: the 8-byte magic `SCD4XTR1`, then 14-byte records of a little-endian int64 timestamp and the three words
+ *   as little-endian uint16.
+ *
+ * Replaying reads every record with the same code as the sample callback on target: `scd4x_read_measurement_raw()`
+ * against a bus that answers with the recorded words (CRCs included). The words are then converted in one pass with
+ * `scd4x_convert_measurements()`, bit-exact with the per-sample conversion on target, and run through
+ * `measurement_pipeline::process_converted()`. The HAL runs on a simulated clock set to each record's timestamp, so a
+ * week of samples replays in seconds.
+ */
+namespace trace_replay {
+
+typedef struct {
+    int64_t timestamp_us;
+    scd4x_measurement_raw_t raw;
+} record_t;
+
+/** Replay stages whose time is measured */
+typedef enum {
+    STAGE_ACQUIRE = 0, /* Command frame, bus transfer, CRC check and decode */
+    STAGE_PIPELINE,    /* Bulk conversion, spread evenly over the samples, then filters and classification */
+    STAGE_PUBLISH,     /* Change detection and formatting of the published values */
+    STAGE_MAX,
+} stage_t;
+
+typedef struct {
+    const char *name;
+    uint32_t samples;
+    uint64_t total_ns;
+    uint64_t max_ns;
+} stage_timing_t;
+
+/** Read a trace in either format, telling them apart by the binary magic
+ *
+ * @return false with `*error` set if the file cannot be read or a record does not parse.
+ */
+bool load(const char *path, std::vector<record_t> *records, std::string *error);
+
+/** Write a trace in CSV form, with a header line */
+bool save_csv(FILE *file, const std::vector<record_t> &records);
+
+/** Write a trace in binary form */
+bool save_binary(FILE *file, const std::vector<record_t> &records);
+
+/** Record a trace from the simulated SCD4x in periodic mode, on simulated time
+ *
+ * @param[in] duration_s Simulated time to cover, starting from 0.
+ * @param[in] period_ms Time between two reads, 5000 or more.
+ */
+void capture_sim(uint32_t duration_s, uint32_t period_ms, std::vector<record_t> *records);
+
+/** Replay `records` from a reset pipeline and write the published attribute sequence to `out`
+ *
+ * One CSV line per record, after a header: `timestamp_us,co2_raw_ppm,co2_ppm,air_quality,temperature_centi_deg_c,
+ * humidity_centi_percent,changed`. The values are those the attribute publisher writes: CO2 MeasuredValue in ppm,
+ * the AirQuality enum, and MeasuredValue of the temperature and humidity clusters in hundredths. `changed` lists the
+ * attributes that differ from the previous sample, i.e. the ones subscribers get a report for, as `co2`, `aq`, `t`
+ * and `rh` separated by `|`.
+ *
+ * @param[out] timings Time spent per stage, indexed by stage_t; may be NULL.
+ *
+ * @return false if a record could not be read back through the driver.
+ */
+bool replay(const std::vector<record_t> &records, FILE *out, stage_timing_t timings[STAGE_MAX]);
+
+/** Print `timings` as `stage,samples,total_ns,mean_ns,max_ns` lines */
+void print_timings(FILE *out, const stage_timing_t timings[STAGE_MAX]);
+
+} // namespace trace_replay
@@ -1,5 +1,4 @@
 #include <air-quality-sensor-manager.h>
-#include "esp_log.h"
 using namespace chip;
 using namespace chip::app;
 using namespace chip::app::DataModel;
@@ -146,13 +145,13 @@ AirQualityEnum AirQualitySensorManager::GetAirQuality()
 void AirQualitySensorManager::OnAirQualityChangeHandler(AirQualityEnum newValue)
 {
     mAirQualityInstance.UpdateAirQuality(newValue);
-    ESP_LOGI("NotSpecified", "Updated AirQuality value: %huu", chip::to_underlying(newValue));
+    ChipLogDetail(NotSpecified, "Updated AirQuality value: %u", chip::to_underlying(newValue));
 }
 
 void AirQualitySensorManager::OnCarbonDioxideMeasurementChangeHandler(float newValue)
 {
     mCarbonDioxideConcentrationMeasurementInstance.SetMeasuredValue(MakeNullable(newValue));
-    ESP_LOGI("NotSpecified", "Updated Carbon Dioxide: %f", newValue);
+    ChipLogDetail(NotSpecified, "Updated Carbon Dioxide value: %f", newValue);
 }
 
 void AirQualitySensorManager::OnCarbonMonoxideMeasurementChangeHandler(float newValue)
@@ -8,14 +8,16 @@
 
 #include <esp_err.h>
 #include <esp_log.h>
+#include <esp_timer.h>
 #include <nvs_flash.h>
 
+#include <inttypes.h>
+
 #include <esp_matter.h>
 #include <esp_matter_console.h>
 #include <esp_matter_ota.h>
 
 #include <common_macros.h>
-#include <log_heap_numbers.h>
 
 #include <app_priv.h>
 #include <app_reset.h>
@@ -38,8 +40,28 @@
 using namespace chip::DeviceLayer;
 #endif
 #include <air-quality-sensor-manager.h>
+#include <attribute-publisher.h>
+#include <driver-bench.h>
+#include <heap-telemetry.h>
+#include <icd-schedule.h>
+#include <latency-trace.h>
+#include <measurement-pipeline.h>
+#include <pressure-compensation.h>
+#include <sample-path.h>
+#include <sampling-policy.h>
+#include <sensor-bus.h>
+#include <sensor-config.h>
+#include <sensor-events.h>
+#include <sensor-history.h>
+#include <sensor-maintenance.h>
+#include <sensor-rollup.h>
+#include <sensor-scheduler.h>
+#include <virtual-clock.h>
 
 #include "drivers/scd4x_i2c.h"
+#include "drivers/scd4x_sim.h"
+#include "drivers/sensirion_common.h"
+#include "drivers/sensirion_i2c_cmd.h"
 #include "drivers/sensirion_i2c_hal.h"
 
 static const char *TAG = "app_main";
@@ -52,6 +74,8 @@ using namespace ::chip::app::Clusters;
 using namespace ::chip::app::Clusters::AirQuality;
 
 constexpr auto k_timeout_seconds = 300;
+/* The SCD4x NACKs reads until its first periodic measurement is ready */
+constexpr uint32_t k_first_measurement_ms = 5000;
 
 #ifdef CONFIG_ENABLE_SET_CERT_DECLARATION_API
 extern const uint8_t cd_start[] asm("_binary_certification_declaration_der_start");
@@ -77,7 +101,7 @@ static void app_event_cb(const ChipDeviceEvent *event, intptr_t arg)
 
     case chip::DeviceLayer::DeviceEventType::kCommissioningComplete:
         ESP_LOGI(TAG, "Commissioning complete");
-        MEMORY_PROFILER_DUMP_HEAP_STAT("commissioning complete");
+        heap_telemetry::record("commissioning complete");
         break;
 
     case chip::DeviceLayer::DeviceEventType::kFailSafeTimerExpired:
@@ -94,7 +118,7 @@ static void app_event_cb(const ChipDeviceEvent *event, intptr_t arg)
 
     case chip::DeviceLayer::DeviceEventType::kCommissioningWindowOpened:
         ESP_LOGI(TAG, "Commissioning window opened");
-        MEMORY_PROFILER_DUMP_HEAP_STAT("commissioning window opened");
+        heap_telemetry::record("commissioning window opened");
         break;
 
     case chip::DeviceLayer::DeviceEventType::kCommissioningWindowClosed:
@@ -138,7 +162,7 @@ static void app_event_cb(const ChipDeviceEvent *event, intptr_t arg)
 
     case chip::DeviceLayer::DeviceEventType::kBLEDeinitialized:
         ESP_LOGI(TAG, "BLE deinitialized and memory reclaimed");
-        MEMORY_PROFILER_DUMP_HEAP_STAT("BLE deinitialized");
+        heap_telemetry::record("BLE deinitialized");
         break;
 
     default:
@@ -174,70 +198,106 @@ static esp_err_t app_attribute_update_cb(attribute::callback_type_t type, uint16
     return err;
 }
 
-static void sensor_update_task(void *pvParameters)
+/* Latest sample handed from the sampling timer to the Matter event loop */
+static portMUX_TYPE s_handoff_lock = portMUX_INITIALIZER_UNLOCKED;
+static measurement_pipeline::result_t s_handoff;
+static bool s_handoff_pending = false;
+
+// Runs in the Matter event loop, so the CHIP stack lock is already held. Takes the latest sample only: if the loop
+// fell a whole sample period behind, the one before it is skipped.
+static void sample_consumers_work(intptr_t arg)
 {
-    uint16_t endpoint_id = qual_endpoint;
-    
-    ESP_LOGI(TAG, "Waiting for Matter stack to initialize...");
-    vTaskDelay(5000 / portTICK_PERIOD_MS);
-    
-    while (true) {
-
-        
-        // Update CO2 concentration
-        
-        chip::DeviceLayer::PlatformMgr().LockChipStack();
-
-
-        uint16_t co2_measurement; 
-        int32_t temp_measurement;
-        int32_t humidity_measurement;
-        scd4x_read_measurement(&co2_measurement, &temp_measurement, &humidity_measurement); 
-        uint16_t co2_value = co2_measurement;
-        ESP_LOGI(TAG, "MEASUREMENTS: %d, %lu, %lu", co2_measurement, temp_measurement, humidity_measurement);
-
-        //UNCOMMENT THESE IF USING AAI
-        // AirQualitySensorManager * mInstance = AirQualitySensorManager::GetInstance();
-        // mInstance->OnAirQualityChangeHandler(AirQualityEnum::kGood);
-        ESP_LOGI(TAG, "CO2: %d", co2_value);
-
-        // mInstance->OnCarbonDioxideMeasurementChangeHandler(co2_value);
-        
-        //Note that from what I remember, the feature flags for air quality aren't really set by us. Maybe handled by esp-matter, idk, but 
-        //The only flags that exist are all optional and are for supporting fair, moderate, very poor, and extremely poor air quality. 
-        //value 1 is good, value 2 is fair, 3 is moderate, 4 is poor. Value 0 is unknown.
-
-        int8_t air_quality_value_int = 0;
-        //this is a quick and dirty way of setting this. Consider making it less terrible later. Also, these categories are completely arbitrary.
-        if(co2_value <= 1000)
-        {
-            air_quality_value_int = 1;
-        }
-        else if(co2_value <= 2500)
-        {
-            air_quality_value_int = 2;
+    taskENTER_CRITICAL(&s_handoff_lock);
+    measurement_pipeline::result_t result = s_handoff;
+    s_handoff_pending = false;
+    taskEXIT_CRITICAL(&s_handoff_lock);
+
+    sample_path::on_event_loop(result);
+
+    /* Pressure writes go right after the read, in the idle part of the measurement interval */
+    pressure_compensation::on_sample(result.read_time_us);
+    sampling_policy::on_sample(result);
+}
+
+static void hand_off(const measurement_pipeline::result_t &result)
+{
+    taskENTER_CRITICAL(&s_handoff_lock);
+    bool pending = s_handoff_pending;
+    s_handoff = result;
+    s_handoff_pending = true;
+    taskEXIT_CRITICAL(&s_handoff_lock);
+    if (pending) {
+        ESP_LOGW(TAG, "Matter event loop a sample behind, the previous sample skips events, history and rollup");
+        return;
+    }
+    CHIP_ERROR err = chip::DeviceLayer::PlatformMgr().ScheduleWork(sample_consumers_work, 0);
+    if (err != CHIP_NO_ERROR) {
+        ESP_LOGE(TAG, "Failed to hand the sample to the Matter event loop, err:%" CHIP_ERROR_FORMAT, err.Format());
+        taskENTER_CRITICAL(&s_handoff_lock);
+        s_handoff_pending = false;
+        taskEXIT_CRITICAL(&s_handoff_lock);
+    }
+}
+
+/* The measurement read in flight. Only the esp_timer task touches it: the sampling deadline starts it and
+ * s_read_timer carries it through the execution time, so no task sits blocked on the sensor. */
+static sensirion_i2c_cmd_t s_read_cmd;
+static bool s_read_in_flight = false;
+static bool s_read_holds_bus = false;
+static esp_timer_handle_t s_read_timer = NULL;
+/* Retry period while the console or the barometer holds the bus */
+constexpr uint64_t k_bus_retry_us = 1000;
+
+// Runs in the esp_timer task, without the CHIP stack lock, so a busy Matter event loop never delays the I2C read.
+// Does every bus transaction that is due, then re-arms s_read_timer for the next one instead of sleeping. The bus
+// stays locked from the command write to the response read.
+static void sensor_read_step(void *arg)
+{
+    if (!s_read_holds_bus) {
+        if (!sensor_bus::try_lock()) {
+            esp_timer_start_once(s_read_timer, k_bus_retry_us);
+            return;
         }
-        else if(co2_value <= 5000)
-        {
-            air_quality_value_int = 3;
+        /* A maintenance job owns the sensor; the attributes keep the last good measurement until it is done */
+        if (sensor_maintenance::busy()) {
+            sensor_bus::unlock();
+            s_read_in_flight = false;
+            return;
         }
-        else
-        {
-            air_quality_value_int = 4;
+        s_read_holds_bus = true;
+        scd4x_start(&s_read_cmd, scd4x_cmd_read_measurement_raw, NULL);
+    }
+    while (!sensirion_i2c_cmd_poll(&s_read_cmd, sensirion_i2c_hal_get_time_usec())) {
+        uint64_t now_us = sensirion_i2c_hal_get_time_usec();
+        if (s_read_cmd.state == SENSIRION_I2C_CMD_STATE_WAIT && s_read_cmd.ready_at_us > now_us) {
+            esp_timer_start_once(s_read_timer, s_read_cmd.ready_at_us - now_us);
+            return;
         }
-        esp_matter_attr_val_t air_qual_val = esp_matter_enum8(air_quality_value_int);
-
-        esp_matter::attribute::update(endpoint_id, AirQuality::Id, AirQuality::Attributes::AirQuality::Id, &air_qual_val);
-
-        esp_matter_attr_val_t co2_val = esp_matter_nullable_float(co2_measurement);
-        esp_matter::attribute::update(endpoint_id, 
-                                     CarbonDioxideConcentrationMeasurement::Id,
-                                     CarbonDioxideConcentrationMeasurement::Attributes::MeasuredValue::Id,
-                                     &co2_val);
-        chip::DeviceLayer::PlatformMgr().UnlockChipStack();
+    }
+    sensor_bus::unlock();
+    s_read_holds_bus = false;
+    s_read_in_flight = false;
+
+    scd4x_measurement_raw_t raw;
+    int16_t error = scd4x_decode_measurement_raw(&s_read_cmd, &raw);
+    if (error != NO_ERROR) {
+        ESP_LOGW(TAG, "Failed to read measurement, error:%d", error);
+        return;
+    }
+    measurement_pipeline::result_t result;
+    sample_path::on_read(raw, virtual_clock::now_us(), &result);
+    hand_off(result);
+}
 
-        vTaskDelay(5000 / portTICK_PERIOD_MS);
+// Runs in the esp_timer task once per sampling deadline and only starts the read
+static bool sensor_sample_cb(int64_t deadline_us)
+{
+    if (s_read_in_flight) {
+        return false;
     }
+    s_read_in_flight = true;
+    sensor_read_step(NULL);
+    return true;
 }
 
 extern "C" void app_main()
@@ -247,10 +307,13 @@ extern "C" void app_main()
     /* Initialize the ESP NVS layer */
     nvs_flash_init();
 
-    MEMORY_PROFILER_DUMP_HEAP_STAT("Bootup");
+    heap_telemetry::record("Bootup");
 
     /* Initialize driver */
     sensirion_i2c_hal_init();
+#if CONFIG_SENSOR_SIMULATED
+    sensirion_i2c_hal_set_bus(&scd4x_sim_bus);
+#endif
     scd4x_init(0x62);
 
     /* Create a Matter node and add the mandatory Root Node device type on endpoint 0 */
@@ -260,7 +323,12 @@ extern "C" void app_main()
     node_t *node = node::create(&node_config, app_attribute_update_cb, app_identification_cb);
     ABORT_APP_ON_FAILURE(node != nullptr, ESP_LOGE(TAG, "Failed to create Matter node"));
 
-    MEMORY_PROFILER_DUMP_HEAP_STAT("node created");
+    err = heap_telemetry::add_diagnostics_cluster(node);
+    ABORT_APP_ON_FAILURE(err == ESP_OK, ESP_LOGE(TAG, "Failed to add heap diagnostics, err:%d", err));
+    err = sensor_history::add_diagnostic_logs_cluster(node);
+    ABORT_APP_ON_FAILURE(err == ESP_OK, ESP_LOGE(TAG, "Failed to add the history download, err:%d", err));
+
+    heap_telemetry::record("node created");
 
     air_quality_sensor::config_t air_quality_sensor_config;
 
@@ -294,13 +362,36 @@ extern "C" void app_main()
 
     ABORT_APP_ON_FAILURE(air_qual_ep != nullptr, ESP_LOGE(TAG, "Failed to create air quality sensor endpoint"));
     
-    //UNCOMMENT THIS IF USING AAI.
-    // AirQualitySensorManager::InitInstance(qual_endpoint);
+    attribute_publisher::init(qual_endpoint);
+    err = latency_trace::init(qual_endpoint);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Latency tracing unavailable, err:%d", err);
+    }
 
     //init scd40 here
 
     sensirion_i2c_hal_init();
     vTaskDelay(100 / portTICK_PERIOD_MS);
+    err = sensor_bus::init();
+    ABORT_APP_ON_FAILURE(err == ESP_OK, ESP_LOGE(TAG, "Failed to create the sensor bus lock, err:%d", err));
+    err = sensor_config::init();
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to load the sensor configuration, err:%d", err);
+    }
+    err = sensor_maintenance::init();
+    ABORT_APP_ON_FAILURE(err == ESP_OK, ESP_LOGE(TAG, "Failed to start the maintenance job runner, err:%d", err));
+    err = pressure_compensation::init(air_qual_ep);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Pressure compensation unavailable, err:%d", err);
+    }
+    err = sensor_events::init(air_qual_ep);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Sensor events unavailable, err:%d", err);
+    }
+    err = sensor_rollup::init(air_qual_ep);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Rollup attributes unavailable, err:%d", err);
+    }
     scd4x_start_periodic_measurement();
 
 
@@ -335,7 +426,7 @@ extern "C" void app_main()
     err = esp_matter::start(app_event_cb);
     ABORT_APP_ON_FAILURE(err == ESP_OK, ESP_LOGE(TAG, "Failed to start Matter, err:%d", err));
 
-    MEMORY_PROFILER_DUMP_HEAP_STAT("matter started");
+    heap_telemetry::record("matter started");
 
     /* Starting driver with default values */
 
@@ -349,15 +440,45 @@ extern "C" void app_main()
     esp_matter::console::wifi_register_commands();
     esp_matter::console::factoryreset_register_commands();
     esp_matter::console::attribute_register_commands();
+    heap_telemetry::register_commands();
+    sensor_scheduler::register_commands();
+    icd_schedule::register_commands();
+    sampling_policy::register_commands();
+    pressure_compensation::register_commands();
+    sensor_config::register_commands();
+    sensor_maintenance::register_commands();
+    sensor_events::register_commands();
+    sensor_history::register_commands();
+    sensor_rollup::register_commands();
+    driver_bench::register_commands();
+    attribute_publisher::register_commands();
+    latency_trace::register_commands();
 #if CONFIG_OPENTHREAD_CLI
     esp_matter::console::otcli_register_commands();
 #endif
     esp_matter::console::init();
 #endif
-    xTaskCreate(sensor_update_task, "sensor_update", 4096, NULL, 5, NULL);
 
-    while (true) {
-        MEMORY_PROFILER_DUMP_HEAP_STAT("Idle");
-        vTaskDelay(10000 / portTICK_PERIOD_MS);
-    }
+    /* Sample on an absolute deadline grid; the read runs from esp_timer callbacks, the data model work in the Matter
+     * event loop. On ICD builds the grid is aligned with the poll period so the radio wakes once per publish. */
+    const esp_timer_create_args_t read_timer_args = {
+        .callback = sensor_read_step,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "sensor_read",
+        .skip_unhandled_events = true,
+    };
+    err = esp_timer_create(&read_timer_args, &s_read_timer);
+    ABORT_APP_ON_FAILURE(err == ESP_OK, ESP_LOGE(TAG, "Failed to create the sensor read timer, err:%d", err));
+    uint32_t sample_period_ms = icd_schedule::align_sample_period(CONFIG_SENSOR_SAMPLE_PERIOD_MS);
+    icd_schedule::check_configuration(sample_period_ms);
+    err = sampling_policy::init(qual_endpoint, sample_period_ms, CONFIG_SENSOR_IDLE_SAMPLE_PERIOD_MS);
+    ABORT_APP_ON_FAILURE(err == ESP_OK, ESP_LOGE(TAG, "Failed to initialize the sampling policy, err:%d", err));
+    err = sensor_scheduler::init(sample_period_ms, sensor_sample_cb);
+    ABORT_APP_ON_FAILURE(err == ESP_OK, ESP_LOGE(TAG, "Failed to initialize the sampling scheduler, err:%d", err));
+    err = sensor_scheduler::start(k_first_measurement_ms);
+    ABORT_APP_ON_FAILURE(err == ESP_OK, ESP_LOGE(TAG, "Failed to start the sampling scheduler, err:%d", err));
+
+    /* Heap figures are available on demand through the console and the Software Diagnostics cluster, so there is
+     * nothing left for the main task to do. Returning deletes it and frees its stack. */
 }
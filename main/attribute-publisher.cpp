@@ -0,0 +1,352 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <attribute-publisher.h>
+
+#include <esp_log.h>
+#include <esp_matter.h>
+#include <esp_matter_console.h>
+#include <esp_timer.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <app-common/zap-generated/attribute-type.h>
+#include <app/ConcreteAttributePath.h>
+#include <app/util/attribute-storage.h>
+#include <app/util/attribute-table.h>
+#include <lib/support/CodeUtils.h>
+#include <platform/CHIPDeviceLayer.h>
+
+#include <air-quality-sensor-manager.h>
+#include <sample-snapshot.h>
+
+using namespace esp_matter;
+using namespace chip::app::Clusters;
+using chip::Protocols::InteractionModel::Status;
+
+namespace attribute_publisher {
+
+static const char *TAG = "attribute_publisher";
+
+static const uint32_t k_default_iterations = 1000;
+
+/* The AirQuality and CO2 cluster instances of the bench's scratch endpoint, standing in for AirQualitySensorManager */
+class ScratchClusterInstances {
+public:
+    explicit ScratchClusterInstances(chip::EndpointId endpoint_id)
+        : mEndpointId(endpoint_id),
+          mAirQualityInstance(endpoint_id,
+                              chip::BitMask<AirQuality::Feature, uint32_t>(
+                                  AirQuality::Feature::kModerate, AirQuality::Feature::kFair,
+                                  AirQuality::Feature::kVeryPoor, AirQuality::Feature::kExtremelyPoor)),
+          mCarbonDioxideInstance(endpoint_id, CarbonDioxideConcentrationMeasurement::Id,
+                                 ConcentrationMeasurement::MeasurementMediumEnum::kAir,
+                                 ConcentrationMeasurement::MeasurementUnitEnum::kPpm)
+    {
+    }
+
+    CHIP_ERROR Init()
+    {
+        ReturnErrorOnFailure(mAirQualityInstance.Init());
+        return mCarbonDioxideInstance.Init();
+    }
+
+    chip::EndpointId GetEndpointId() const { return mEndpointId; }
+
+    uint32_t Publish(const measurement_pipeline::result_t &result)
+    {
+        uint32_t failures = 0;
+        if (mAirQualityInstance.UpdateAirQuality(static_cast<AirQuality::AirQualityEnum>(result.air_quality)) !=
+            Status::Success) {
+            failures++;
+        }
+        if (mCarbonDioxideInstance.SetMeasuredValue(chip::app::DataModel::MakeNullable((float)result.co2_ppm)) !=
+            CHIP_NO_ERROR) {
+            failures++;
+        }
+        return failures;
+    }
+
+private:
+    chip::EndpointId mEndpointId;
+    AirQuality::Instance mAirQualityInstance;
+    ConcentrationMeasurement::Instance<true, true, true, true, true, true> mCarbonDioxideInstance;
+};
+
+static uint16_t s_endpoint_id;
+static bool s_initialized;
+
+/* Only set while `bench()` runs, with the CHIP stack lock held */
+static ScratchClusterInstances *s_scratch_instances;
+
+void esp_matter_policy::init(uint16_t endpoint_id)
+{
+}
+
+uint32_t esp_matter_policy::publish(uint16_t endpoint_id, const measurement_pipeline::result_t &result)
+{
+    uint32_t failures = 0;
+    esp_matter_attr_val_t air_quality = esp_matter_enum8(result.air_quality);
+    if (attribute::update(endpoint_id, AirQuality::Id, AirQuality::Attributes::AirQuality::Id, &air_quality) !=
+        ESP_OK) {
+        failures++;
+    }
+    esp_matter_attr_val_t co2 = esp_matter_nullable_float(result.co2_ppm);
+    if (attribute::update(endpoint_id, CarbonDioxideConcentrationMeasurement::Id,
+                          CarbonDioxideConcentrationMeasurement::Attributes::MeasuredValue::Id, &co2) != ESP_OK) {
+        failures++;
+    }
+    return failures;
+}
+
+void cluster_instance_policy::init(uint16_t endpoint_id)
+{
+    AirQualitySensorManager::InitInstance(endpoint_id);
+}
+
+uint32_t cluster_instance_policy::publish(uint16_t endpoint_id, const measurement_pipeline::result_t &result)
+{
+    if (s_scratch_instances != nullptr && endpoint_id == s_scratch_instances->GetEndpointId()) {
+        return s_scratch_instances->Publish(result);
+    }
+    AirQualitySensorManager *manager = AirQualitySensorManager::GetInstance();
+    if (manager == nullptr) {
+        return 2;
+    }
+    manager->OnAirQualityChangeHandler(static_cast<AirQuality::AirQualityEnum>(result.air_quality));
+    manager->OnCarbonDioxideMeasurementChangeHandler(result.co2_ppm);
+    return 0;
+}
+
+void ember_policy::init(uint16_t endpoint_id)
+{
+}
+
+uint32_t ember_policy::publish(uint16_t endpoint_id, const measurement_pipeline::result_t &result)
+{
+    uint32_t failures = 0;
+    uint8_t air_quality = result.air_quality;
+    if (emberAfWriteAttribute(endpoint_id, AirQuality::Id, AirQuality::Attributes::AirQuality::Id, &air_quality,
+                              ZCL_ENUM8_ATTRIBUTE_TYPE) != Status::Success) {
+        failures++;
+    }
+    float co2 = result.co2_ppm;
+    if (emberAfWriteAttribute(endpoint_id, CarbonDioxideConcentrationMeasurement::Id,
+                              CarbonDioxideConcentrationMeasurement::Attributes::MeasuredValue::Id,
+                              reinterpret_cast<uint8_t *>(&co2), ZCL_SINGLE_ATTRIBUTE_TYPE) != Status::Success) {
+        failures++;
+    }
+    return failures;
+}
+
+void snapshot_policy::init(uint16_t endpoint_id)
+{
+    esp_err_t err = sample_snapshot::init(endpoint_id);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Snapshot attribute access unavailable, err:%d", err);
+    }
+}
+
+uint32_t snapshot_policy::publish(uint16_t endpoint_id, const measurement_pipeline::result_t &result)
+{
+    sample_snapshot::write(endpoint_id, result);
+    return 0;
+}
+
+void init(uint16_t endpoint_id)
+{
+    s_endpoint_id = endpoint_id;
+    selected_policy_t::init(endpoint_id);
+    s_initialized = true;
+    ESP_LOGI(TAG, "Publishing through %s", selected_policy_t::k_name);
+}
+
+void publish(const measurement_pipeline::result_t &result)
+{
+    uint32_t failures = selected_policy_t::publish(s_endpoint_id, result);
+    if (failures != 0) {
+        ESP_LOGW(TAG, "%s refused %" PRIu32 " attribute(s)", selected_policy_t::k_name, failures);
+    }
+}
+
+/* An air quality sensor endpoint with the clusters of the sensor endpoint, so the bench never writes the live values.
+ * Controllers see it like any dynamic endpoint until the bench destroys it. */
+static endpoint_t *create_scratch_endpoint()
+{
+    endpoint::air_quality_sensor::config_t air_quality_sensor_config;
+    endpoint_t *scratch_endpoint =
+        endpoint::air_quality_sensor::create(node::get(), &air_quality_sensor_config, ENDPOINT_FLAG_DESTROYABLE, NULL);
+    if (scratch_endpoint == nullptr) {
+        return nullptr;
+    }
+    cluster::concentration_measurement::config_t co2_config;
+    co2_config.measurement_medium = 0x00; /* Air */
+    co2_config.features.numeric_measurement.min_measured_value = 0.0f;
+    co2_config.features.numeric_measurement.max_measured_value = 10000.0f;
+    co2_config.features.numeric_measurement.measured_value = 400.0f;
+    co2_config.features.numeric_measurement.measurement_unit = 0; /* ppm */
+    co2_config.feature_flags = 1;
+    cluster::temperature_measurement::config_t temperature_config;
+    cluster::relative_humidity_measurement::config_t humidity_config;
+    if (cluster::carbon_dioxide_concentration_measurement::create(scratch_endpoint, &co2_config,
+                                                                   CLUSTER_FLAG_SERVER) == nullptr ||
+        cluster::temperature_measurement::create(scratch_endpoint, &temperature_config, CLUSTER_FLAG_SERVER) ==
+            nullptr ||
+        cluster::relative_humidity_measurement::create(scratch_endpoint, &humidity_config, CLUSTER_FLAG_SERVER) ==
+            nullptr ||
+        endpoint::enable(scratch_endpoint) != ESP_OK) {
+        endpoint::destroy(node::get(), scratch_endpoint);
+        return nullptr;
+    }
+    return scratch_endpoint;
+}
+
+/* Every attribute change bumps its cluster's data version once, and marks the attribute dirty for every subscriber */
+static uint32_t data_versions(uint16_t endpoint_id)
+{
+    uint32_t sum = 0;
+    const chip::ClusterId clusters[] = {AirQuality::Id, CarbonDioxideConcentrationMeasurement::Id,
+                                        TemperatureMeasurement::Id, RelativeHumidityMeasurement::Id};
+    for (chip::ClusterId cluster_id : clusters) {
+        chip::DataVersion *version = emberAfDataVersionStorage(chip::app::ConcreteClusterPath(endpoint_id, cluster_id));
+        if (version != nullptr) {
+            sum += *version;
+        }
+    }
+    return sum;
+}
+
+template <typename Policy>
+static void bench_policy(uint16_t endpoint_id, uint32_t iterations, bench_result_t *result)
+{
+    measurement_pipeline::result_t sample = {};
+    sample.temperature_m_deg_c = 21000;
+    sample.humidity_m_percent_rh = 45000;
+    uint32_t failures = 0;
+    uint32_t versions_before = data_versions(endpoint_id);
+    /* Benchmarks measure wall time, so they use esp_timer directly rather than the virtual clock */
+    int64_t start_us = esp_timer_get_time();
+    for (uint32_t i = 0; i < iterations; i++) {
+        sample.air_quality = (i & 1) ? measurement_pipeline::AIR_QUALITY_FAIR : measurement_pipeline::AIR_QUALITY_GOOD;
+        sample.co2_ppm = (uint16_t)(700 + (i & 1));
+        failures += Policy::publish(endpoint_id, sample);
+    }
+    int64_t total_us = esp_timer_get_time() - start_us;
+    *result = {Policy::k_name, iterations, total_us, data_versions(endpoint_id) - versions_before, failures};
+}
+
+esp_err_t bench(uint32_t iterations, bench_result_t results[4])
+{
+    chip::DeviceLayer::PlatformMgr().LockChipStack();
+    endpoint_t *scratch_endpoint = create_scratch_endpoint();
+    if (scratch_endpoint == nullptr) {
+        chip::DeviceLayer::PlatformMgr().UnlockChipStack();
+        ESP_LOGE(TAG, "Failed to create the scratch endpoint");
+        return ESP_FAIL;
+    }
+    uint16_t scratch_endpoint_id = endpoint::get_id(scratch_endpoint);
+    esp_err_t err = ESP_OK;
+
+    /* Storage writes first: the attribute access of the other two takes the attributes away from storage */
+    bench_policy<esp_matter_policy>(scratch_endpoint_id, iterations, &results[0]);
+    bench_policy<ember_policy>(scratch_endpoint_id, iterations, &results[2]);
+
+    s_scratch_instances = new ScratchClusterInstances(scratch_endpoint_id);
+    if (s_scratch_instances->Init() == CHIP_NO_ERROR) {
+        bench_policy<cluster_instance_policy>(scratch_endpoint_id, iterations, &results[1]);
+    } else {
+        ESP_LOGE(TAG, "Failed to create the scratch cluster instances");
+        results[1] = {};
+        err = ESP_FAIL;
+    }
+    /* Their destructors unregister the attribute access */
+    delete s_scratch_instances;
+    s_scratch_instances = nullptr;
+
+    if (sample_snapshot::init(scratch_endpoint_id) == ESP_OK) {
+        bench_policy<snapshot_policy>(scratch_endpoint_id, iterations, &results[3]);
+        sample_snapshot::remove(scratch_endpoint_id);
+    } else {
+        ESP_LOGE(TAG, "Failed to create the scratch snapshot");
+        results[3] = {};
+        err = ESP_FAIL;
+    }
+
+    endpoint::destroy(node::get(), scratch_endpoint);
+    chip::DeviceLayer::PlatformMgr().UnlockChipStack();
+    return err;
+}
+
+static esp_err_t publisher_policy_handler(int argc, char **argv)
+{
+    printf("policy,%s\r\n", selected_policy_t::k_name);
+    return ESP_OK;
+}
+
+static esp_err_t publisher_bench_handler(int argc, char **argv)
+{
+    uint32_t iterations = argc >= 1 ? (uint32_t)strtoul(argv[0], NULL, 0) : k_default_iterations;
+    if (iterations == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    bench_result_t results[4];
+    esp_err_t err = bench(iterations, results);
+    printf("policy,iterations,total_us,ns_per_op,change_reports,failures\r\n");
+    for (const bench_result_t &result : results) {
+        if (result.name == nullptr) {
+            continue;
+        }
+        printf("%s,%" PRIu32 ",%" PRId64 ",%" PRId64 ",%" PRIu32 ",%" PRIu32 "\r\n", result.name, result.iterations,
+               result.total_us, result.total_us * 1000 / result.iterations, result.change_reports, result.failures);
+    }
+    return err;
+}
+
+static console::engine publisher_console;
+
+static esp_err_t publisher_dispatch(int argc, char **argv)
+{
+    if (argc <= 0) {
+        publisher_console.for_each_command(console::print_description, NULL);
+        return ESP_OK;
+    }
+    return publisher_console.exec_command(argc, argv);
+}
+
+esp_err_t register_commands()
+{
+    static const console::command_t command = {
+        .name = "publisher",
+        .description = "Attribute update path. Usage: matter esp publisher <policy|bench> [iterations].",
+        .handler = publisher_dispatch,
+    };
+
+    static const console::command_t publisher_commands[] = {
+        {
+            .name = "policy",
+            .description = "Print the update path selected by CONFIG_SENSOR_PUBLISHER",
+            .handler = publisher_policy_handler,
+        },
+        {
+            .name = "bench",
+            .description = "Time each update path and count the change reports it causes, one CSV line per path",
+            .handler = publisher_bench_handler,
+        },
+    };
+    publisher_console.register_commands(publisher_commands,
+                                        sizeof(publisher_commands) / sizeof(console::command_t));
+
+    return console::add_commands(&command, 1);
+}
+
+} // namespace attribute_publisher
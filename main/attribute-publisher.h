@@ -0,0 +1,122 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <esp_err.h>
+
+#include <stdint.h>
+
+#include <measurement-pipeline.h>
+
+#include <sdkconfig.h>
+
+/** Publishing of the AirQuality and CO2 MeasuredValue attributes
+ *
+ * The values can reach the data model four ways, and which one works depends on the esp-matter version (see the
+ * README on `MANAGED_INTERNALLY`):
+ * - `esp_matter_policy`: `esp_matter::attribute::update()`, i.e. esp_matter storage plus the attribute callbacks.
+ * - `cluster_instance_policy`: the cluster server instances of `AirQualitySensorManager`, i.e. the values live in the
+ *   AttributeAccessInterface of each cluster.
+ * - `ember_policy`: `emberAfWriteAttribute()`, the write behind the generated `Attributes::<name>::Set()` accessors
+ *   such as the one `TemperatureSensorManager` uses.
+ * - `snapshot_policy`: `sample_snapshot::write()`, i.e. nothing is written to the data model; AttributeAccessInterfaces
+ *   read the latest sample when a report or read is encoded. This one also serves temperature and humidity.
+ *
+ * `CONFIG_SENSOR_PUBLISHER` selects one of them at compile time; `publish()` calls it directly. The others are still
+ * built so `publisher bench` can compare them. Each policy publishes to the endpoint it is given. The Linux build has
+ * `cluster_instance_policy` only, in `linux/attribute-publisher-linux.cpp`.
+ */
+namespace attribute_publisher {
+
+struct esp_matter_policy {
+    static constexpr const char *k_name = "esp_matter";
+    static constexpr bool k_needs_stack_lock = true;
+    static void init(uint16_t endpoint_id);
+    /** @return Number of attributes the data model refused */
+    static uint32_t publish(uint16_t endpoint_id, const measurement_pipeline::result_t &result);
+};
+
+struct cluster_instance_policy {
+    static constexpr const char *k_name = "cluster_instance";
+    static constexpr bool k_needs_stack_lock = true;
+    /** Creates the AirQualitySensorManager, which takes the clusters over from esp_matter storage */
+    static void init(uint16_t endpoint_id);
+    static uint32_t publish(uint16_t endpoint_id, const measurement_pipeline::result_t &result);
+};
+
+struct ember_policy {
+    static constexpr const char *k_name = "ember";
+    static constexpr bool k_needs_stack_lock = true;
+    static void init(uint16_t endpoint_id);
+    static uint32_t publish(uint16_t endpoint_id, const measurement_pipeline::result_t &result);
+};
+
+struct snapshot_policy {
+    static constexpr const char *k_name = "snapshot";
+    static constexpr bool k_needs_stack_lock = false;
+    /** Registers the snapshot's attribute access, adding the temperature and humidity clusters */
+    static void init(uint16_t endpoint_id);
+    /** Takes no CHIP stack lock; change reports follow from a job on the Matter event loop */
+    static uint32_t publish(uint16_t endpoint_id, const measurement_pipeline::result_t &result);
+};
+
+#if CONFIG_SENSOR_PUBLISHER_CLUSTER_INSTANCE
+using selected_policy_t = cluster_instance_policy;
+#elif CONFIG_SENSOR_PUBLISHER_EMBER
+using selected_policy_t = ember_policy;
+#elif CONFIG_SENSOR_PUBLISHER_SNAPSHOT
+using selected_policy_t = snapshot_policy;
+#else
+using selected_policy_t = esp_matter_policy;
+#endif
+
+/** Result of benchmarking one policy */
+typedef struct {
+    const char *name;
+    uint32_t iterations;
+    int64_t total_us;
+    uint32_t change_reports; /* Data version bumps of the sensor clusters, each one a report to every subscriber */
+    uint32_t failures;       /* Attribute writes the data model refused */
+} bench_result_t;
+
+/** Prepare the selected policy for the sensor endpoint; must be called once the endpoint exists */
+void init(uint16_t endpoint_id);
+
+/** Publish a sample through the selected policy
+ *
+ * Must be called from the Matter event loop when `selected_policy_t::k_needs_stack_lock` is set; otherwise from any
+ * single task, without the CHIP stack lock.
+ */
+void publish(const measurement_pipeline::result_t &result);
+
+#ifdef ESP_PLATFORM
+/** Time each policy publishing alternating values to a scratch endpoint
+ *
+ * Holds the CHIP stack lock while it runs. Creates an air quality sensor endpoint with the clusters of the sensor
+ * endpoint, runs every policy against it and destroys it, so the live attributes and their subscribers see nothing;
+ * esp_matter takes a new endpoint id for it each time. The change reports of `snapshot_policy` are marked by a job
+ * that runs once the lock is released, by which time the endpoint is gone, so it shows none.
+ *
+ * @param[in] iterations Publishes per policy, each one changing both attributes.
+ * @param[out] results One entry per policy, `name` NULL for a policy whose attribute access could not be set up.
+ *
+ * @return ESP_OK on success.
+ * @return ESP_FAIL if the scratch endpoint or the attribute access of a policy could not be set up.
+ */
+esp_err_t bench(uint32_t iterations, bench_result_t results[4]);
+
+/** Register the `publisher` console commands
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t register_commands();
+#endif
+
+} // namespace attribute_publisher
@@ -0,0 +1,62 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <deadline-grid.h>
+
+namespace deadline_grid {
+
+const int64_t k_bucket_limits_us[DEADLINE_GRID_JITTER_BUCKETS - 1] = {
+    1000, 2000, 5000, 10000, 20000, 50000, 100000,
+};
+
+int64_t start(grid_t *grid, int64_t now_us, uint32_t warm_up_ms)
+{
+    int64_t first_delay_us = (int64_t)(warm_up_ms > grid->period_ms ? warm_up_ms : grid->period_ms) * 1000;
+    grid->next_deadline_us = now_us + first_delay_us;
+    return first_delay_us;
+}
+
+int64_t advance(grid_t *grid, int64_t now_us, int64_t *deadline_us)
+{
+    int64_t period_us = (int64_t)grid->period_ms * 1000;
+    *deadline_us = grid->next_deadline_us;
+    int64_t next_deadline_us = grid->next_deadline_us + period_us;
+    if (next_deadline_us <= now_us) {
+        int64_t missed = (now_us - next_deadline_us) / period_us + 1;
+        next_deadline_us += missed * period_us;
+        grid->stats.missed_deadlines += missed;
+    }
+    grid->next_deadline_us = next_deadline_us;
+    return next_deadline_us;
+}
+
+void record_jitter(grid_t *grid, int64_t jitter_us)
+{
+    int bucket = 0;
+    while (bucket < DEADLINE_GRID_JITTER_BUCKETS - 1 && jitter_us >= k_bucket_limits_us[bucket]) {
+        bucket++;
+    }
+
+    jitter_stats_t *stats = &grid->stats;
+    if (stats->samples == 0 || jitter_us < stats->min_us) {
+        stats->min_us = jitter_us;
+    }
+    if (stats->samples == 0 || jitter_us > stats->max_us) {
+        stats->max_us = jitter_us;
+    }
+    stats->samples++;
+    stats->total_us += jitter_us;
+    stats->buckets[bucket]++;
+}
+
+void record_missed(grid_t *grid)
+{
+    grid->stats.missed_deadlines++;
+}
+
+} // namespace deadline_grid
@@ -0,0 +1,71 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+/** Sampling deadline grid and jitter statistics
+ *
+ * Pure computation with no ESP-IDF dependency and no locking: `sensor_scheduler` drives it from an esp_timer under
+ * its own lock on the device, and `sampling-days-test` from the simulated clock on the host.
+ */
+namespace deadline_grid {
+
+/** Upper bounds (in microseconds) of the jitter histogram buckets; the last bucket is open ended */
+#define DEADLINE_GRID_JITTER_BUCKETS 8
+
+extern const int64_t k_bucket_limits_us[DEADLINE_GRID_JITTER_BUCKETS - 1];
+
+/** Sampling jitter statistics
+ *
+ * Jitter is the delay between a sampling deadline and the moment the sample starts. Only started samples are counted
+ * in it.
+ */
+typedef struct {
+    uint32_t samples;
+    uint32_t missed_deadlines;
+    int64_t min_us;
+    int64_t max_us;
+    int64_t total_us;
+    uint32_t buckets[DEADLINE_GRID_JITTER_BUCKETS];
+} jitter_stats_t;
+
+/** Deadline grid state */
+typedef struct {
+    uint32_t period_ms;
+    int64_t next_deadline_us; /* Deadline the timer is currently armed for */
+    jitter_stats_t stats;
+} grid_t;
+
+/** Place the first deadline one period or `warm_up_ms` after `now_us`, whichever is later
+ *
+ * @return Delay from `now_us` to the first deadline, in microseconds.
+ */
+int64_t start(grid_t *grid, int64_t now_us, uint32_t warm_up_ms);
+
+/** Move the grid on from the deadline that just came up
+ *
+ * The next deadline is one period after the one that came up. If `now_us` is already past it by a whole period or
+ * more, the deadlines in between are counted as missed and skipped instead of bursting to catch up; the grid stays
+ * anchored to the original deadlines, so the cadence never drifts. A period change takes effect here.
+ *
+ * @param[in] now_us Current time.
+ * @param[out] deadline_us Deadline that came up.
+ *
+ * @return Next deadline.
+ */
+int64_t advance(grid_t *grid, int64_t now_us, int64_t *deadline_us);
+
+/** Count a started sample in the jitter statistics */
+void record_jitter(grid_t *grid, int64_t jitter_us);
+
+/** Count a deadline whose sample was not started */
+void record_missed(grid_t *grid);
+
+} // namespace deadline_grid
@@ -0,0 +1,197 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <driver-bench.h>
+
+#ifdef ESP_PLATFORM
+#include <esp_matter_console.h>
+#include <esp_timer.h>
+#endif
+
+#include <inttypes.h>
+#include <stdlib.h>
+#ifndef ESP_PLATFORM
+#include <chrono>
+#endif
+
+#include "drivers/scd4x_i2c.h"
+#include "drivers/sensirion_common.h"
+#include "drivers/sensirion_i2c.h"
+
+#ifdef ESP_PLATFORM
+using namespace esp_matter;
+#endif
+
+namespace driver_bench {
+
+static const uint32_t k_batch_samples = 64;
+
+/* Every benchmark folds its output in here so the compiler cannot drop the call */
+static volatile uint32_t s_sink;
+
+/* Benchmarks measure wall time, never the virtual or simulated clock */
+static int64_t now_ns()
+{
+#ifdef ESP_PLATFORM
+    return esp_timer_get_time() * 1000;
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#endif
+}
+
+/* `body` gets the loop index, which its input depends on to keep the call inside the loop */
+template <typename Body>
+static void bench(const char *name, uint32_t iterations, result_cb_t callback, void *ctx, Body body)
+{
+    int64_t start_ns = now_ns();
+    for (uint32_t i = 0; i < iterations; i++) {
+        s_sink = s_sink + (uint32_t)body(i);
+    }
+    result_t result = {name, iterations, now_ns() - start_ns};
+    callback(&result, ctx);
+}
+
+void run(uint32_t iterations, result_cb_t callback, void *ctx)
+{
+    uint8_t buffer[SENSIRION_MAX_BUFFER_WORDS * (SENSIRION_WORD_SIZE + CRC8_LEN)];
+    uint16_t words[3];
+    const uint8_t bytes[4] = {0x01, 0x9a, 0x66, 0x5c};
+
+    /* A read_measurement frame: 3 words, each followed by its CRC */
+    uint8_t frame[3 * (SENSIRION_WORD_SIZE + CRC8_LEN)];
+    uint16_t offset = 0;
+    offset = sensirion_i2c_add_uint16_t_to_buffer(frame, offset, 0x01f4);
+    offset = sensirion_i2c_add_uint16_t_to_buffer(frame, offset, 0x6667);
+    offset = sensirion_i2c_add_uint16_t_to_buffer(frame, offset, 0x5eb9);
+
+    bench("generate_crc", iterations, callback, ctx, [&](uint32_t i) {
+        uint8_t word[2] = {(uint8_t)(i >> 8), (uint8_t)i};
+        return sensirion_i2c_generate_crc(word, sizeof(word));
+    });
+    bench("fill_cmd_send_buf", iterations, callback, ctx, [&](uint32_t i) {
+        const uint16_t args[2] = {(uint16_t)i, (uint16_t)~i};
+        return sensirion_i2c_fill_cmd_send_buf(buffer, SCD4X_SET_SENSOR_ALTITUDE_CMD_ID, args, 2);
+    });
+    bench("add_command16_to_buffer", iterations, callback, ctx,
+          [&](uint32_t i) { return sensirion_i2c_add_command16_to_buffer(buffer, 0, (uint16_t)i); });
+    bench("add_uint16_t_to_buffer", iterations, callback, ctx,
+          [&](uint32_t i) { return sensirion_i2c_add_uint16_t_to_buffer(buffer, 0, (uint16_t)i); });
+    bench("add_uint32_t_to_buffer", iterations, callback, ctx,
+          [&](uint32_t i) { return sensirion_i2c_add_uint32_t_to_buffer(buffer, 0, i); });
+    bench("add_float_to_buffer", iterations, callback, ctx,
+          [&](uint32_t i) { return sensirion_i2c_add_float_to_buffer(buffer, 0, (float)i); });
+    bench("add_bytes_to_buffer", iterations, callback, ctx, [&](uint32_t i) {
+        buffer[0] = (uint8_t)i;
+        return sensirion_i2c_add_bytes_to_buffer(buffer, 4, bytes, sizeof(bytes));
+    });
+    bench("bytes_to_uint16_t", iterations, callback, ctx, [&](uint32_t i) {
+        buffer[0] = (uint8_t)i;
+        return sensirion_common_bytes_to_uint16_t(buffer);
+    });
+    bench("bytes_to_uint32_t", iterations, callback, ctx, [&](uint32_t i) {
+        buffer[0] = (uint8_t)i;
+        return sensirion_common_bytes_to_uint32_t(buffer);
+    });
+    bench("bytes_to_int32_t", iterations, callback, ctx, [&](uint32_t i) {
+        buffer[0] = (uint8_t)i;
+        return sensirion_common_bytes_to_int32_t(buffer);
+    });
+    bench("bytes_to_float", iterations, callback, ctx, [&](uint32_t i) {
+        buffer[3] = (uint8_t)i;
+        return (uint32_t)sensirion_common_bytes_to_float(buffer);
+    });
+    bench("decode_words_3", iterations, callback, ctx, [&](uint32_t i) {
+        frame[offset - 1] ^= (uint8_t)(i & 0x80);
+        return sensirion_i2c_decode_words(frame, words, 3) + words[0];
+    });
+    bench("signal_co2_concentration", iterations, callback, ctx,
+          [&](uint32_t i) { return scd4x_signal_co2_concentration((uint16_t)i); });
+    bench("signal_temperature", iterations, callback, ctx,
+          [&](uint32_t i) { return scd4x_signal_temperature((uint16_t)i); });
+    bench("signal_relative_humidity", iterations, callback, ctx,
+          [&](uint32_t i) { return scd4x_signal_relative_humidity((uint16_t)i); });
+
+    /* One iteration converts a whole batch; divide ns_per_op by k_batch_samples for the per-sample cost */
+    static uint16_t raw[3][k_batch_samples];
+    static uint16_t co2[k_batch_samples];
+    static int32_t temperature[k_batch_samples];
+    static int32_t humidity[k_batch_samples];
+    for (uint32_t i = 0; i < k_batch_samples; i++) {
+        raw[0][i] = (uint16_t)(400 + i);
+        raw[1][i] = (uint16_t)(0x6667 + i);
+        raw[2][i] = (uint16_t)(0x5eb9 + i);
+    }
+    bench("convert_measurements_batch", iterations, callback, ctx, [&](uint32_t i) {
+        raw[0][i % k_batch_samples] = (uint16_t)i;
+        scd4x_convert_measurements(raw[0], raw[1], raw[2], co2, temperature, humidity, k_batch_samples);
+        return temperature[i % k_batch_samples];
+    });
+}
+
+void print_header(FILE *out, const char *line_end)
+{
+    fprintf(out, "name,iterations,total_ns,ns_per_op%s", line_end);
+}
+
+void print_result(FILE *out, const result_t *result, const char *line_end)
+{
+    fprintf(out, "%s,%" PRIu32 ",%" PRId64 ",%" PRId64 "%s", result->name, result->iterations, result->total_ns,
+            result->iterations ? result->total_ns / result->iterations : 0, line_end);
+}
+
+#ifdef ESP_PLATFORM
+static void print_console_result(const result_t *result, void *ctx)
+{
+    print_result(stdout, result, "\r\n");
+}
+
+static esp_err_t bench_drivers_handler(int argc, char **argv)
+{
+    uint32_t iterations = argc >= 1 ? (uint32_t)strtoul(argv[0], NULL, 0) : k_default_iterations;
+    if (iterations == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    print_header(stdout, "\r\n");
+    run(iterations, print_console_result, NULL);
+    return ESP_OK;
+}
+
+static console::engine bench_console;
+
+static esp_err_t bench_dispatch(int argc, char **argv)
+{
+    if (argc <= 0) {
+        bench_console.for_each_command(console::print_description, NULL);
+        return ESP_OK;
+    }
+    return bench_console.exec_command(argc, argv);
+}
+
+esp_err_t register_commands()
+{
+    static const console::command_t command = {
+        .name = "bench",
+        .description = "Driver microbenchmarks. Usage: matter esp bench drivers [iterations].",
+        .handler = bench_dispatch,
+    };
+
+    static const console::command_t bench_commands[] = {
+        {
+            .name = "drivers",
+            .description = "Time the Sensirion driver helpers and print one CSV line per benchmark",
+            .handler = bench_drivers_handler,
+        },
+    };
+    bench_console.register_commands(bench_commands, sizeof(bench_commands) / sizeof(console::command_t));
+
+    return console::add_commands(&command, 1);
+}
+#endif
+
+} // namespace driver_bench
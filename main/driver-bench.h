@@ -0,0 +1,63 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <esp_err.h>
+
+#include <stdint.h>
+#include <stdio.h>
+
+/** Microbenchmarks of the Sensirion driver helpers
+ *
+ * The same benchmarks run on the device, as `matter esp bench drivers [iterations]`, and on the host, as
+ * `sensirion-driver-bench [iterations]`, and print the same CSV: `name,iterations,total_ns,ns_per_op`.
+ */
+namespace driver_bench {
+
+/** Iterations per benchmark when none are given */
+static constexpr uint32_t k_default_iterations = 10000;
+
+/** Result of one benchmark */
+typedef struct {
+    const char *name;
+    uint32_t iterations;
+    int64_t total_ns; /* Wall time; microsecond resolution on the device */
+} result_t;
+
+/** Callback receiving each result as soon as its benchmark finishes */
+typedef void (*result_cb_t)(const result_t *result, void *ctx);
+
+/** Run the Sensirion driver benchmarks
+ *
+ * Covers the CRC, the command and argument buffer builders, the byte decoders, the single-pass frame decode and the
+ * raw-to-physical conversions of read_measurement, one sample at a time and in batches. None of them touches the
+ * bus, so this is safe while sampling runs.
+ *
+ * @param[in] iterations Calls per benchmark.
+ * @param[in] callback Receives each result.
+ * @param[in] ctx Passed to the callback.
+ */
+void run(uint32_t iterations, result_cb_t callback, void *ctx);
+
+/** Print the CSV header line */
+void print_header(FILE *out, const char *line_end);
+
+/** Print one result as a CSV line */
+void print_result(FILE *out, const result_t *result, const char *line_end);
+
+#ifdef ESP_PLATFORM
+/** Register the `bench` console commands
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t register_commands();
+#endif
+
+} // namespace driver_bench
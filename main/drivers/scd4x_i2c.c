@@ -39,14 +39,11 @@
 #include "scd4x_i2c.h"
 #include "sensirion_common.h"
 #include "sensirion_i2c.h"
+#include "sensirion_i2c_cmd.h"
 #include "sensirion_i2c_hal.h"
 
-#define sensirion_hal_sleep_us sensirion_i2c_hal_sleep_usec
-
 #define ROUND(x) ((int32_t)((x) + 0.5))
 
-static uint8_t communication_buffer[9] = {0};
-
 static uint8_t _i2c_address;
 
 void scd4x_init(uint8_t i2c_address) {
@@ -59,6 +56,39 @@ uint16_t scd4x_signal_co2_concentration(uint16_t raw_co2_concentration) {
     return co2_concentration;
 }
 
+/* Shared by the scalar and the batch conversions so they stay bit-exact */
+#define SCD4X_TEMPERATURE_M_DEG_C(raw) \
+    (((21875 * (int32_t)(raw)) >> 13) - 45000)
+#define SCD4X_RELATIVE_HUMIDITY_M_PERCENT_RH(raw) \
+    ((12500 * (int32_t)(raw)) >> 13)
+
+int32_t scd4x_signal_temperature(uint16_t raw_temperature) {
+    return SCD4X_TEMPERATURE_M_DEG_C(raw_temperature);
+}
+
+int32_t scd4x_signal_relative_humidity(uint16_t raw_relative_humidity) {
+    return SCD4X_RELATIVE_HUMIDITY_M_PERCENT_RH(raw_relative_humidity);
+}
+
+void scd4x_convert_measurements(const uint16_t* restrict raw_co2,
+                                const uint16_t* restrict raw_temperature,
+                                const uint16_t* restrict raw_humidity,
+                                uint16_t* restrict co2,
+                                int32_t* restrict temperature_m_deg_c,
+                                int32_t* restrict humidity_m_percent_rh,
+                                uint32_t count) {
+    uint32_t i;
+
+    /* Branch-free and free of calls, so the loop vectorizes where the
+     * target supports it */
+    for (i = 0; i < count; i++) {
+        co2[i] = raw_co2[i];
+        temperature_m_deg_c[i] = SCD4X_TEMPERATURE_M_DEG_C(raw_temperature[i]);
+        humidity_m_percent_rh[i] =
+            SCD4X_RELATIVE_HUMIDITY_M_PERCENT_RH(raw_humidity[i]);
+    }
+}
+
 uint32_t scd4x_signal_ambient_pressure(uint16_t raw_ambient_pressure) {
     uint32_t ambient_pressure = 0;
     ambient_pressure = (uint32_t)raw_ambient_pressure * 100;
@@ -124,552 +154,152 @@ int16_t scd4x_get_sensor_variant(scd4x_sensor_variant* a_sensor_variant) {
     return local_error;
 }
 
-int16_t scd4x_start_periodic_measurement() {
-    int16_t local_error = NO_ERROR;
-    uint8_t* buffer_ptr = communication_buffer;
-    uint16_t local_offset = 0;
-    local_offset =
-        sensirion_i2c_add_command16_to_buffer(buffer_ptr, local_offset, 0x21b1);
-    local_error =
-        sensirion_i2c_write_data(_i2c_address, buffer_ptr, local_offset);
-    if (local_error != NO_ERROR) {
-        return local_error;
-    }
-    return local_error;
-}
+const sensirion_i2c_cmd_desc_t scd4x_commands[SCD4X_COMMAND_COUNT] = {
+#define SCD4X_COMMAND(name, code, shape, args, response_words, exec_time_us, \
+                      flags)                                                 \
+    [scd4x_cmd_##name] = {code, args, response_words, exec_time_us, flags},
+#include "scd4x_commands.def"
+};
 
-int16_t scd4x_read_measurement_raw(uint16_t* co2_concentration,
-                                   uint16_t* temperature,
-                                   uint16_t* relative_humidity) {
-    int16_t local_error = NO_ERROR;
-    uint8_t* buffer_ptr = communication_buffer;
-    uint16_t local_offset = 0;
-    local_offset =
-        sensirion_i2c_add_command16_to_buffer(buffer_ptr, local_offset, 0xec05);
-    local_error =
-        sensirion_i2c_write_data(_i2c_address, buffer_ptr, local_offset);
-    if (local_error != NO_ERROR) {
-        return local_error;
-    }
-    sensirion_i2c_hal_sleep_usec(1 * 1000);
-    local_error = sensirion_i2c_read_data_inplace(_i2c_address, buffer_ptr, 6);
-    if (local_error != NO_ERROR) {
-        return local_error;
-    }
-    *co2_concentration = sensirion_common_bytes_to_uint16_t(&buffer_ptr[0]);
-    *temperature = sensirion_common_bytes_to_uint16_t(&buffer_ptr[2]);
-    *relative_humidity = sensirion_common_bytes_to_uint16_t(&buffer_ptr[4]);
-    return local_error;
-}
+const char* const scd4x_command_names[SCD4X_COMMAND_COUNT] = {
+#define SCD4X_COMMAND(name, code, shape, args, response_words, exec_time_us, \
+                      flags)                                                 \
+    [scd4x_cmd_##name] = #name,
+#include "scd4x_commands.def"
+};
 
-int16_t scd4x_read_measurement(uint16_t* co2, int32_t* temperature_m_deg_c,
-                               int32_t* humidity_m_percent_rh) {
-    int16_t error;
-    uint16_t temperature;
-    uint16_t humidity;
-    error = scd4x_read_measurement_raw(co2, &temperature, &humidity);
-    if (error) {
-        return error;
+int16_t scd4x_start(sensirion_i2c_cmd_t* cmd, scd4x_command_t command,
+                    const uint16_t* args) {
+    if ((unsigned)command >= SCD4X_COMMAND_COUNT) {
+        return NOT_IMPLEMENTED_ERROR;
     }
-    *temperature_m_deg_c = ((21875 * (int32_t)temperature) >> 13) - 45000;
-    *humidity_m_percent_rh = ((12500 * (int32_t)humidity) >> 13);
-    return NO_ERROR;
-}
-
-int16_t scd4x_stop_periodic_measurement() {
-    int16_t local_error = NO_ERROR;
-    uint8_t* buffer_ptr = communication_buffer;
-    uint16_t local_offset = 0;
-    local_offset =
-        sensirion_i2c_add_command16_to_buffer(buffer_ptr, local_offset, 0x3f86);
-    local_error =
-        sensirion_i2c_write_data(_i2c_address, buffer_ptr, local_offset);
-    if (local_error != NO_ERROR) {
-        return local_error;
-    }
-    sensirion_i2c_hal_sleep_usec(500 * 1000);
-    return local_error;
+    return sensirion_i2c_cmd_start(cmd, _i2c_address, &scd4x_commands[command],
+                                   args);
 }
 
-int16_t scd4x_set_temperature_offset_raw(uint16_t offset_temperature) {
-    int16_t local_error = NO_ERROR;
-    uint8_t* buffer_ptr = communication_buffer;
-    uint16_t local_offset = 0;
-    local_offset =
-        sensirion_i2c_add_command16_to_buffer(buffer_ptr, local_offset, 0x241d);
-    local_offset = sensirion_i2c_add_uint16_t_to_buffer(
-        buffer_ptr, local_offset, offset_temperature);
-    local_error =
-        sensirion_i2c_write_data(_i2c_address, buffer_ptr, local_offset);
-    if (local_error != NO_ERROR) {
-        return local_error;
-    }
-    sensirion_i2c_hal_sleep_usec(1 * 1000);
-    return local_error;
-}
-
-int16_t scd4x_get_temperature_offset_raw(uint16_t* offset_temperature) {
-    int16_t local_error = NO_ERROR;
-    uint8_t* buffer_ptr = communication_buffer;
-    uint16_t local_offset = 0;
-    local_offset =
-        sensirion_i2c_add_command16_to_buffer(buffer_ptr, local_offset, 0x2318);
-    local_error =
-        sensirion_i2c_write_data(_i2c_address, buffer_ptr, local_offset);
-    if (local_error != NO_ERROR) {
-        return local_error;
-    }
-    sensirion_i2c_hal_sleep_usec(1 * 1000);
-    local_error = sensirion_i2c_read_data_inplace(_i2c_address, buffer_ptr, 2);
-    if (local_error != NO_ERROR) {
-        return local_error;
-    }
-    *offset_temperature = sensirion_common_bytes_to_uint16_t(&buffer_ptr[0]);
-    return local_error;
-}
+int16_t scd4x_execute(scd4x_command_t command, const uint16_t* args,
+                      uint16_t* response) {
+    sensirion_i2c_cmd_t cmd;
+    int16_t local_error;
+    uint8_t i;
 
-int16_t scd4x_set_sensor_altitude(uint16_t sensor_altitude) {
-    int16_t local_error = NO_ERROR;
-    uint8_t* buffer_ptr = communication_buffer;
-    uint16_t local_offset = 0;
-    local_offset =
-        sensirion_i2c_add_command16_to_buffer(buffer_ptr, local_offset, 0x2427);
-    local_offset = sensirion_i2c_add_uint16_t_to_buffer(
-        buffer_ptr, local_offset, sensor_altitude);
-    local_error =
-        sensirion_i2c_write_data(_i2c_address, buffer_ptr, local_offset);
-    if (local_error != NO_ERROR) {
-        return local_error;
+    if ((unsigned)command >= SCD4X_COMMAND_COUNT) {
+        return NOT_IMPLEMENTED_ERROR;
     }
-    sensirion_i2c_hal_sleep_usec(1 * 1000);
-    return local_error;
-}
-
-int16_t scd4x_get_sensor_altitude(uint16_t* sensor_altitude) {
-    int16_t local_error = NO_ERROR;
-    uint8_t* buffer_ptr = communication_buffer;
-    uint16_t local_offset = 0;
-    local_offset =
-        sensirion_i2c_add_command16_to_buffer(buffer_ptr, local_offset, 0x2322);
-    local_error =
-        sensirion_i2c_write_data(_i2c_address, buffer_ptr, local_offset);
+    local_error = sensirion_i2c_cmd_start(&cmd, _i2c_address,
+                                          &scd4x_commands[command], args);
     if (local_error != NO_ERROR) {
         return local_error;
     }
-    sensirion_i2c_hal_sleep_usec(1 * 1000);
-    local_error = sensirion_i2c_read_data_inplace(_i2c_address, buffer_ptr, 2);
+    local_error = sensirion_i2c_cmd_run(&cmd);
     if (local_error != NO_ERROR) {
         return local_error;
     }
-    *sensor_altitude = sensirion_common_bytes_to_uint16_t(&buffer_ptr[0]);
-    return local_error;
-}
-
-int16_t scd4x_set_ambient_pressure_raw(uint16_t ambient_pressure) {
-    int16_t local_error = NO_ERROR;
-    uint8_t* buffer_ptr = communication_buffer;
-    uint16_t local_offset = 0;
-    local_offset =
-        sensirion_i2c_add_command16_to_buffer(buffer_ptr, local_offset, 0xe000);
-    local_offset = sensirion_i2c_add_uint16_t_to_buffer(
-        buffer_ptr, local_offset, ambient_pressure);
-    local_error =
-        sensirion_i2c_write_data(_i2c_address, buffer_ptr, local_offset);
-    if (local_error != NO_ERROR) {
-        return local_error;
+    for (i = 0; i < cmd.desc->num_response_words; i++) {
+        response[i] = sensirion_i2c_cmd_response_word(&cmd, i);
     }
-    sensirion_i2c_hal_sleep_usec(1 * 1000);
-    return local_error;
+    return NO_ERROR;
 }
 
-int16_t scd4x_get_ambient_pressure_raw(uint16_t* ambient_pressure) {
-    int16_t local_error = NO_ERROR;
-    uint8_t* buffer_ptr = communication_buffer;
-    uint16_t local_offset = 0;
-    local_offset =
-        sensirion_i2c_add_command16_to_buffer(buffer_ptr, local_offset, 0xe000);
-    local_error =
-        sensirion_i2c_write_data(_i2c_address, buffer_ptr, local_offset);
-    if (local_error != NO_ERROR) {
-        return local_error;
-    }
-    sensirion_i2c_hal_sleep_usec(1 * 1000);
-    local_error = sensirion_i2c_read_data_inplace(_i2c_address, buffer_ptr, 2);
-    if (local_error != NO_ERROR) {
-        return local_error;
+/* Blocking wrappers for the commands that need no hand-written code. The
+ * static assertions keep the shape and the word counts of the spec in sync. */
+#define SCD4X_WRAPPER_SEND(name, args, response_words)                     \
+    _Static_assert(args == 0 && response_words == 0, #name " is not SEND"); \
+    int16_t scd4x_##name() {                                               \
+        return scd4x_execute(scd4x_cmd_##name, NULL, NULL);                \
     }
-    *ambient_pressure = sensirion_common_bytes_to_uint16_t(&buffer_ptr[0]);
-    return local_error;
-}
-
-int16_t scd4x_perform_forced_recalibration(uint16_t target_co2_concentration,
-                                           uint16_t* frc_correction) {
-    int16_t local_error = NO_ERROR;
-    uint8_t* buffer_ptr = communication_buffer;
-    uint16_t local_offset = 0;
-    local_offset =
-        sensirion_i2c_add_command16_to_buffer(buffer_ptr, local_offset, 0x362f);
-    local_offset = sensirion_i2c_add_uint16_t_to_buffer(
-        buffer_ptr, local_offset, target_co2_concentration);
-    local_error =
-        sensirion_i2c_write_data(_i2c_address, buffer_ptr, local_offset);
-    if (local_error != NO_ERROR) {
-        return local_error;
+#define SCD4X_WRAPPER_SET(name, args, response_words)                     \
+    _Static_assert(args == 1 && response_words == 0, #name " is not SET"); \
+    int16_t scd4x_##name(uint16_t value) {                                \
+        return scd4x_execute(scd4x_cmd_##name, &value, NULL);             \
     }
-    sensirion_i2c_hal_sleep_usec(400 * 1000);
-    local_error = sensirion_i2c_read_data_inplace(_i2c_address, buffer_ptr, 2);
-    if (local_error != NO_ERROR) {
-        return local_error;
+#define SCD4X_WRAPPER_GET(name, args, response_words)                     \
+    _Static_assert(args == 0 && response_words == 1, #name " is not GET"); \
+    int16_t scd4x_##name(uint16_t* value) {                               \
+        return scd4x_execute(scd4x_cmd_##name, NULL, value);              \
     }
-    *frc_correction = sensirion_common_bytes_to_uint16_t(&buffer_ptr[0]);
-    return local_error;
-}
+#define SCD4X_WRAPPER_CUSTOM(name, args, response_words)
 
-int16_t scd4x_set_automatic_self_calibration_enabled(uint16_t asc_enabled) {
-    int16_t local_error = NO_ERROR;
-    uint8_t* buffer_ptr = communication_buffer;
-    uint16_t local_offset = 0;
-    local_offset =
-        sensirion_i2c_add_command16_to_buffer(buffer_ptr, local_offset, 0x2416);
-    local_offset = sensirion_i2c_add_uint16_t_to_buffer(
-        buffer_ptr, local_offset, asc_enabled);
-    local_error =
-        sensirion_i2c_write_data(_i2c_address, buffer_ptr, local_offset);
-    if (local_error != NO_ERROR) {
-        return local_error;
-    }
-    sensirion_i2c_hal_sleep_usec(1 * 1000);
-    return local_error;
-}
+#define SCD4X_COMMAND(name, code, shape, args, response_words, exec_time_us, \
+                      flags)                                                 \
+    SCD4X_WRAPPER_##shape(name, args, response_words)
+#include "scd4x_commands.def"
 
-int16_t scd4x_get_automatic_self_calibration_enabled(uint16_t* asc_enabled) {
-    int16_t local_error = NO_ERROR;
-    uint8_t* buffer_ptr = communication_buffer;
-    uint16_t local_offset = 0;
-    local_offset =
-        sensirion_i2c_add_command16_to_buffer(buffer_ptr, local_offset, 0x2313);
-    local_error =
-        sensirion_i2c_write_data(_i2c_address, buffer_ptr, local_offset);
-    if (local_error != NO_ERROR) {
-        return local_error;
+int16_t scd4x_decode_measurement_raw(const sensirion_i2c_cmd_t* cmd,
+                                     scd4x_measurement_raw_t* measurement) {
+    if (cmd->error != NO_ERROR) {
+        return cmd->error;
     }
-    sensirion_i2c_hal_sleep_usec(1 * 1000);
-    local_error = sensirion_i2c_read_data_inplace(_i2c_address, buffer_ptr, 2);
-    if (local_error != NO_ERROR) {
-        return local_error;
+    if (cmd->desc != &scd4x_commands[scd4x_cmd_read_measurement_raw] ||
+        cmd->state != SENSIRION_I2C_CMD_STATE_DONE) {
+        return BYTE_NUM_ERROR;
     }
-    *asc_enabled = sensirion_common_bytes_to_uint16_t(&buffer_ptr[0]);
-    return local_error;
-}
-
-int16_t scd4x_set_automatic_self_calibration_target(uint16_t asc_target) {
-    int16_t local_error = NO_ERROR;
-    uint8_t* buffer_ptr = communication_buffer;
-    uint16_t local_offset = 0;
-    local_offset =
-        sensirion_i2c_add_command16_to_buffer(buffer_ptr, local_offset, 0x243a);
-    local_offset = sensirion_i2c_add_uint16_t_to_buffer(
-        buffer_ptr, local_offset, asc_target);
-    local_error =
-        sensirion_i2c_write_data(_i2c_address, buffer_ptr, local_offset);
-    if (local_error != NO_ERROR) {
-        return local_error;
-    }
-    sensirion_i2c_hal_sleep_usec(1 * 1000);
-    return local_error;
+    measurement->co2_concentration = sensirion_i2c_cmd_response_word(cmd, 0);
+    measurement->temperature = sensirion_i2c_cmd_response_word(cmd, 1);
+    measurement->relative_humidity = sensirion_i2c_cmd_response_word(cmd, 2);
+    return NO_ERROR;
 }
 
-int16_t scd4x_get_automatic_self_calibration_target(uint16_t* asc_target) {
-    int16_t local_error = NO_ERROR;
-    uint8_t* buffer_ptr = communication_buffer;
-    uint16_t local_offset = 0;
-    local_offset =
-        sensirion_i2c_add_command16_to_buffer(buffer_ptr, local_offset, 0x233f);
-    local_error =
-        sensirion_i2c_write_data(_i2c_address, buffer_ptr, local_offset);
-    if (local_error != NO_ERROR) {
-        return local_error;
+int16_t scd4x_read_measurement_raw(uint16_t* co2_concentration,
+                                   uint16_t* temperature,
+                                   uint16_t* relative_humidity) {
+    sensirion_i2c_cmd_t cmd;
+    scd4x_measurement_raw_t measurement;
+    int16_t local_error = sensirion_i2c_cmd_start(
+        &cmd, _i2c_address, &scd4x_commands[scd4x_cmd_read_measurement_raw],
+        NULL);
+    if (local_error == NO_ERROR) {
+        local_error = sensirion_i2c_cmd_run(&cmd);
     }
-    sensirion_i2c_hal_sleep_usec(1 * 1000);
-    local_error = sensirion_i2c_read_data_inplace(_i2c_address, buffer_ptr, 2);
-    if (local_error != NO_ERROR) {
-        return local_error;
+    if (local_error == NO_ERROR) {
+        local_error = scd4x_decode_measurement_raw(&cmd, &measurement);
     }
-    *asc_target = sensirion_common_bytes_to_uint16_t(&buffer_ptr[0]);
-    return local_error;
-}
-
-int16_t scd4x_start_low_power_periodic_measurement() {
-    int16_t local_error = NO_ERROR;
-    uint8_t* buffer_ptr = communication_buffer;
-    uint16_t local_offset = 0;
-    local_offset =
-        sensirion_i2c_add_command16_to_buffer(buffer_ptr, local_offset, 0x21ac);
-    local_error =
-        sensirion_i2c_write_data(_i2c_address, buffer_ptr, local_offset);
     if (local_error != NO_ERROR) {
         return local_error;
     }
-    return local_error;
+    *co2_concentration = measurement.co2_concentration;
+    *temperature = measurement.temperature;
+    *relative_humidity = measurement.relative_humidity;
+    return NO_ERROR;
 }
 
-int16_t scd4x_get_data_ready_status_raw(uint16_t* data_ready_status) {
-    int16_t local_error = NO_ERROR;
-    uint8_t* buffer_ptr = communication_buffer;
-    uint16_t local_offset = 0;
-    local_offset =
-        sensirion_i2c_add_command16_to_buffer(buffer_ptr, local_offset, 0xe4b8);
-    local_error =
-        sensirion_i2c_write_data(_i2c_address, buffer_ptr, local_offset);
-    if (local_error != NO_ERROR) {
-        return local_error;
-    }
-    sensirion_i2c_hal_sleep_usec(1 * 1000);
-    local_error = sensirion_i2c_read_data_inplace(_i2c_address, buffer_ptr, 2);
-    if (local_error != NO_ERROR) {
-        return local_error;
+int16_t scd4x_read_measurement(uint16_t* co2, int32_t* temperature_m_deg_c,
+                               int32_t* humidity_m_percent_rh) {
+    int16_t error;
+    uint16_t temperature;
+    uint16_t humidity;
+    error = scd4x_read_measurement_raw(co2, &temperature, &humidity);
+    if (error) {
+        return error;
     }
-    *data_ready_status = sensirion_common_bytes_to_uint16_t(&buffer_ptr[0]);
-    return local_error;
+    *temperature_m_deg_c = scd4x_signal_temperature(temperature);
+    *humidity_m_percent_rh = scd4x_signal_relative_humidity(humidity);
+    return NO_ERROR;
 }
 
-int16_t scd4x_persist_settings() {
-    int16_t local_error = NO_ERROR;
-    uint8_t* buffer_ptr = communication_buffer;
-    uint16_t local_offset = 0;
-    local_offset =
-        sensirion_i2c_add_command16_to_buffer(buffer_ptr, local_offset, 0x3615);
-    local_error =
-        sensirion_i2c_write_data(_i2c_address, buffer_ptr, local_offset);
-    if (local_error != NO_ERROR) {
-        return local_error;
-    }
-    sensirion_i2c_hal_sleep_usec(800 * 1000);
-    return local_error;
+int16_t scd4x_perform_forced_recalibration(uint16_t target_co2_concentration,
+                                           uint16_t* frc_correction) {
+    return scd4x_execute(scd4x_cmd_perform_forced_recalibration,
+                         &target_co2_concentration, frc_correction);
 }
 
 int16_t scd4x_get_serial_number(uint16_t* serial_number,
                                 uint16_t serial_number_size) {
-    int16_t local_error = NO_ERROR;
-    uint8_t* buffer_ptr = communication_buffer;
-    uint16_t local_offset = 0;
-    local_offset =
-        sensirion_i2c_add_command16_to_buffer(buffer_ptr, local_offset, 0x3682);
-    local_error =
-        sensirion_i2c_write_data(_i2c_address, buffer_ptr, local_offset);
-    if (local_error != NO_ERROR) {
-        return local_error;
-    }
-    sensirion_i2c_hal_sleep_usec(1 * 1000);
-    local_error = sensirion_i2c_read_data_inplace(_i2c_address, buffer_ptr, 6);
-    if (local_error != NO_ERROR) {
-        return local_error;
-    }
-    sensirion_common_copy_bytes(&buffer_ptr[0], (uint8_t*)serial_number,
-                                (serial_number_size * 2));
-    return local_error;
-}
-
-int16_t scd4x_perform_self_test(uint16_t* sensor_status) {
-    int16_t local_error = NO_ERROR;
-    uint8_t* buffer_ptr = communication_buffer;
-    uint16_t local_offset = 0;
-    local_offset =
-        sensirion_i2c_add_command16_to_buffer(buffer_ptr, local_offset, 0x3639);
-    local_error =
-        sensirion_i2c_write_data(_i2c_address, buffer_ptr, local_offset);
-    if (local_error != NO_ERROR) {
-        return local_error;
-    }
-    sensirion_i2c_hal_sleep_usec(10000 * 1000);
-    local_error = sensirion_i2c_read_data_inplace(_i2c_address, buffer_ptr, 2);
-    if (local_error != NO_ERROR) {
-        return local_error;
-    }
-    *sensor_status = sensirion_common_bytes_to_uint16_t(&buffer_ptr[0]);
-    return local_error;
-}
-
-int16_t scd4x_perform_factory_reset() {
-    int16_t local_error = NO_ERROR;
-    uint8_t* buffer_ptr = communication_buffer;
-    uint16_t local_offset = 0;
-    local_offset =
-        sensirion_i2c_add_command16_to_buffer(buffer_ptr, local_offset, 0x3632);
-    local_error =
-        sensirion_i2c_write_data(_i2c_address, buffer_ptr, local_offset);
-    if (local_error != NO_ERROR) {
-        return local_error;
-    }
-    sensirion_i2c_hal_sleep_usec(1200 * 1000);
-    return local_error;
-}
-
-int16_t scd4x_reinit() {
-    int16_t local_error = NO_ERROR;
-    uint8_t* buffer_ptr = communication_buffer;
-    uint16_t local_offset = 0;
-    local_offset =
-        sensirion_i2c_add_command16_to_buffer(buffer_ptr, local_offset, 0x3646);
-    local_error =
-        sensirion_i2c_write_data(_i2c_address, buffer_ptr, local_offset);
-    if (local_error != NO_ERROR) {
-        return local_error;
-    }
-    sensirion_i2c_hal_sleep_usec(30 * 1000);
-    return local_error;
-}
-
-int16_t scd4x_get_sensor_variant_raw(uint16_t* sensor_variant) {
-    int16_t local_error = NO_ERROR;
-    uint8_t* buffer_ptr = communication_buffer;
-    uint16_t local_offset = 0;
-    local_offset =
-        sensirion_i2c_add_command16_to_buffer(buffer_ptr, local_offset, 0x202f);
-    local_error =
-        sensirion_i2c_write_data(_i2c_address, buffer_ptr, local_offset);
-    if (local_error != NO_ERROR) {
-        return local_error;
-    }
-    sensirion_i2c_hal_sleep_usec(1 * 1000);
-    local_error = sensirion_i2c_read_data_inplace(_i2c_address, buffer_ptr, 2);
-    if (local_error != NO_ERROR) {
-        return local_error;
-    }
-    *sensor_variant = sensirion_common_bytes_to_uint16_t(&buffer_ptr[0]);
-    return local_error;
-}
-
-int16_t scd4x_measure_single_shot() {
-    int16_t local_error = NO_ERROR;
-    uint8_t* buffer_ptr = communication_buffer;
-    uint16_t local_offset = 0;
-    local_offset =
-        sensirion_i2c_add_command16_to_buffer(buffer_ptr, local_offset, 0x219d);
-    local_error =
-        sensirion_i2c_write_data(_i2c_address, buffer_ptr, local_offset);
-    if (local_error != NO_ERROR) {
-        return local_error;
-    }
-    sensirion_i2c_hal_sleep_usec(5000 * 1000);
-    return local_error;
-}
-
-int16_t scd4x_measure_single_shot_rht_only() {
-    int16_t local_error = NO_ERROR;
-    uint8_t* buffer_ptr = communication_buffer;
-    uint16_t local_offset = 0;
-    local_offset =
-        sensirion_i2c_add_command16_to_buffer(buffer_ptr, local_offset, 0x2196);
-    local_error =
-        sensirion_i2c_write_data(_i2c_address, buffer_ptr, local_offset);
-    if (local_error != NO_ERROR) {
-        return local_error;
+    sensirion_i2c_cmd_t cmd;
+    int16_t local_error = sensirion_i2c_cmd_start(
+        &cmd, _i2c_address, &scd4x_commands[scd4x_cmd_get_serial_number],
+        NULL);
+    if (local_error == NO_ERROR) {
+        local_error = sensirion_i2c_cmd_run(&cmd);
     }
-    sensirion_i2c_hal_sleep_usec(50 * 1000);
-    return local_error;
-}
-
-int16_t scd4x_power_down() {
-    int16_t local_error = NO_ERROR;
-    uint8_t* buffer_ptr = communication_buffer;
-    uint16_t local_offset = 0;
-    local_offset =
-        sensirion_i2c_add_command16_to_buffer(buffer_ptr, local_offset, 0x36e0);
-    local_error =
-        sensirion_i2c_write_data(_i2c_address, buffer_ptr, local_offset);
     if (local_error != NO_ERROR) {
         return local_error;
     }
-    sensirion_i2c_hal_sleep_usec(1 * 1000);
-    return local_error;
-}
-
-int16_t scd4x_wake_up() {
-    int16_t local_error = NO_ERROR;
-    uint8_t* buffer_ptr = communication_buffer;
-    uint16_t local_offset = 0;
-    local_offset =
-        sensirion_i2c_add_command16_to_buffer(buffer_ptr, local_offset, 0x36f6);
-    sensirion_i2c_write_data(_i2c_address, buffer_ptr, local_offset);
-    sensirion_i2c_hal_sleep_usec(30 * 1000);
-    return local_error;
-}
-
-int16_t scd4x_set_automatic_self_calibration_initial_period(
-    uint16_t asc_initial_period) {
-    int16_t local_error = NO_ERROR;
-    uint8_t* buffer_ptr = communication_buffer;
-    uint16_t local_offset = 0;
-    local_offset =
-        sensirion_i2c_add_command16_to_buffer(buffer_ptr, local_offset, 0x2445);
-    local_offset = sensirion_i2c_add_uint16_t_to_buffer(
-        buffer_ptr, local_offset, asc_initial_period);
-    local_error =
-        sensirion_i2c_write_data(_i2c_address, buffer_ptr, local_offset);
-    if (local_error != NO_ERROR) {
-        return local_error;
+    if (serial_number_size > 3) {
+        serial_number_size = 3;
     }
-    sensirion_i2c_hal_sleep_usec(1 * 1000);
-    return local_error;
-}
-
-int16_t scd4x_get_automatic_self_calibration_initial_period(
-    uint16_t* asc_initial_period) {
-    int16_t local_error = NO_ERROR;
-    uint8_t* buffer_ptr = communication_buffer;
-    uint16_t local_offset = 0;
-    local_offset =
-        sensirion_i2c_add_command16_to_buffer(buffer_ptr, local_offset, 0x2340);
-    local_error =
-        sensirion_i2c_write_data(_i2c_address, buffer_ptr, local_offset);
-    if (local_error != NO_ERROR) {
-        return local_error;
-    }
-    sensirion_i2c_hal_sleep_usec(1 * 1000);
-    local_error = sensirion_i2c_read_data_inplace(_i2c_address, buffer_ptr, 2);
-    if (local_error != NO_ERROR) {
-        return local_error;
-    }
-    *asc_initial_period = sensirion_common_bytes_to_uint16_t(&buffer_ptr[0]);
-    return local_error;
-}
-
-int16_t scd4x_set_automatic_self_calibration_standard_period(
-    uint16_t asc_standard_period) {
-    int16_t local_error = NO_ERROR;
-    uint8_t* buffer_ptr = communication_buffer;
-    uint16_t local_offset = 0;
-    local_offset =
-        sensirion_i2c_add_command16_to_buffer(buffer_ptr, local_offset, 0x244e);
-    local_offset = sensirion_i2c_add_uint16_t_to_buffer(
-        buffer_ptr, local_offset, asc_standard_period);
-    local_error =
-        sensirion_i2c_write_data(_i2c_address, buffer_ptr, local_offset);
-    if (local_error != NO_ERROR) {
-        return local_error;
-    }
-    sensirion_i2c_hal_sleep_usec(1 * 1000);
-    return local_error;
-}
-
-int16_t scd4x_get_automatic_self_calibration_standard_period(
-    uint16_t* asc_standard_period) {
-    int16_t local_error = NO_ERROR;
-    uint8_t* buffer_ptr = communication_buffer;
-    uint16_t local_offset = 0;
-    local_offset =
-        sensirion_i2c_add_command16_to_buffer(buffer_ptr, local_offset, 0x234b);
-    local_error =
-        sensirion_i2c_write_data(_i2c_address, buffer_ptr, local_offset);
-    if (local_error != NO_ERROR) {
-        return local_error;
-    }
-    sensirion_i2c_hal_sleep_usec(1 * 1000);
-    local_error = sensirion_i2c_read_data_inplace(_i2c_address, buffer_ptr, 2);
-    if (local_error != NO_ERROR) {
-        return local_error;
-    }
-    *asc_standard_period = sensirion_common_bytes_to_uint16_t(&buffer_ptr[0]);
-    return local_error;
+    sensirion_common_copy_bytes(sensirion_i2c_cmd_response_bytes(&cmd),
+                                (uint8_t*)serial_number,
+                                (serial_number_size * 2));
+    return NO_ERROR;
 }
@@ -44,6 +44,7 @@ extern "C" {
 #endif
 
 #include "sensirion_config.h"
+#include "sensirion_i2c_cmd.h"
 #define SCD40_I2C_ADDR_62 0x62
 #define SCD41_I2C_ADDR_62 0x62
 
@@ -88,6 +89,58 @@ typedef enum {
     SCD4X_SENSOR_VARIANT_SCD43 = 0x5000,
 } scd4x_sensor_variant;
 
+/*
+ * Index of every command in scd4x_commands[], generated from
+ * scd4x_commands.def.
+ */
+typedef enum {
+#define SCD4X_COMMAND(name, code, shape, args, response_words, exec_time_us, \
+                      flags)                                                 \
+    scd4x_cmd_##name,
+#include "scd4x_commands.def"
+    SCD4X_COMMAND_COUNT
+} scd4x_command_t;
+
+/*
+ * Command descriptors for the non-blocking engine in sensirion_i2c_cmd.h,
+ * indexed by scd4x_command_t. Responses are raw words.
+ */
+extern const sensirion_i2c_cmd_desc_t scd4x_commands[SCD4X_COMMAND_COUNT];
+
+/* Command names, indexed by scd4x_command_t */
+extern const char* const scd4x_command_names[SCD4X_COMMAND_COUNT];
+
+/**
+ * @brief Start any command from the table without waiting for it.
+ *
+ * Nothing is sent until the command is advanced with sensirion_i2c_cmd_poll()
+ * or sensirion_i2c_cmd_poll_all(), so the caller decides when to touch the
+ * bus and never sleeps through the execution time.
+ *
+ * @param[out] cmd Command storage, owned by the caller until it is done
+ * @param[in] command Command to start
+ * @param[in] args Argument words, may be NULL for commands without arguments
+ *
+ * @return error_code 0 on success, an error code otherwise.
+ */
+int16_t scd4x_start(sensirion_i2c_cmd_t* cmd, scd4x_command_t command,
+                    const uint16_t* args);
+
+/**
+ * @brief Run any command from the table to completion.
+ *
+ * This is the executor behind every blocking scd4x_* function.
+ *
+ * @param[in] command Command to run
+ * @param[in] args Argument words, may be NULL for commands without arguments
+ * @param[out] response Raw response words, may be NULL for commands without
+ * response
+ *
+ * @return error_code 0 on success, an error code otherwise.
+ */
+int16_t scd4x_execute(scd4x_command_t command, const uint16_t* args,
+                      uint16_t* response);
+
 /**
  * @brief Initialize i2c address of driver
  *
@@ -105,6 +158,47 @@ void scd4x_init(uint8_t i2c_address);
  */
 uint16_t scd4x_signal_co2_concentration(uint16_t raw_co2_concentration);
 
+/**
+ * @brief scd4x_signal_temperature
+ *
+ * @param[in] raw_temperature
+ *
+ * @return Temperature in milli degrees celsius (°C * 1000)
+ */
+int32_t scd4x_signal_temperature(uint16_t raw_temperature);
+
+/**
+ * @brief scd4x_signal_relative_humidity
+ *
+ * @param[in] raw_relative_humidity
+ *
+ * @return Relative humidity in milli percent RH (%RH * 1000)
+ */
+int32_t scd4x_signal_relative_humidity(uint16_t raw_relative_humidity);
+
+/**
+ * @brief Convert raw measurement words to physical units in bulk.
+ *
+ * Structure-of-arrays counterpart of scd4x_signal_co2_concentration(),
+ * scd4x_signal_temperature() and scd4x_signal_relative_humidity(), bit-exact
+ * with them, for decoding history buffers and traces in one pass. The arrays
+ * must not overlap.
+ *
+ * @param[in] raw_co2 Raw CO₂ words
+ * @param[in] raw_temperature Raw temperature words
+ * @param[in] raw_humidity Raw relative humidity words
+ * @param[out] co2 CO₂ concentration in ppm
+ * @param[out] temperature_m_deg_c Temperature in milli degrees celsius
+ * @param[out] humidity_m_percent_rh Relative humidity in milli percent RH
+ * @param[in] count Number of samples in every array
+ */
+void scd4x_convert_measurements(const uint16_t* raw_co2,
+                                const uint16_t* raw_temperature,
+                                const uint16_t* raw_humidity, uint16_t* co2,
+                                int32_t* temperature_m_deg_c,
+                                int32_t* humidity_m_percent_rh,
+                                uint32_t count);
+
 /**
  * @brief scd4x_signal_ambient_pressure
  *
@@ -197,6 +291,27 @@ int16_t scd4x_read_measurement_raw(uint16_t* co2_concentration,
                                    uint16_t* temperature,
                                    uint16_t* relative_humidity);
 
+/* Raw measurement words, as returned by read_measurement_raw */
+typedef struct {
+    uint16_t co2_concentration;
+    uint16_t temperature;
+    uint16_t relative_humidity;
+} scd4x_measurement_raw_t;
+
+/**
+ * @brief Decode a finished read_measurement_raw command.
+ *
+ * Decodes straight from the command buffer, so non-blocking callers of
+ * scd4x_commands[scd4x_cmd_read_measurement_raw] need no intermediate copy.
+ *
+ * @param[in] cmd Finished read_measurement_raw command
+ * @param[out] measurement Raw measurement words
+ *
+ * @return error_code 0 on success, the command's error code otherwise.
+ */
+int16_t scd4x_decode_measurement_raw(const sensirion_i2c_cmd_t* cmd,
+                                     scd4x_measurement_raw_t* measurement);
+
 /**
  * @brief Read sensor output and convert to pyhsical unit.
  *
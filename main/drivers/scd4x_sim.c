@@ -0,0 +1,436 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include "scd4x_sim.h"
+#include "scd4x_i2c.h"
+#include "sensirion_common.h"
+#include "sensirion_i2c.h"
+#include "sensirion_i2c_cmd.h"
+#include "sensirion_i2c_hal.h"
+
+#define SCD4X_SIM_PERIODIC_INTERVAL_US 5000000ULL
+#define SCD4X_SIM_LOW_POWER_INTERVAL_US 30000000ULL
+#define SCD4X_SIM_SINGLE_SHOT_US 5000000ULL
+#define SCD4X_SIM_RAMP_PERIOD_US 2400000000ULL
+#define SCD4X_SIM_RAMP_LOW_PPM 450
+#define SCD4X_SIM_RAMP_HIGH_PPM 3050
+#define SCD4X_SIM_HOUR_US 3600000000ULL
+
+/* get_data_ready_status: the low 11 bits are non-zero when data is ready */
+#define SCD4X_SIM_DATA_READY 0x8006
+#define SCD4X_SIM_DATA_NOT_READY 0x8000
+
+typedef enum {
+    SCD4X_SIM_IDLE = 0,
+    SCD4X_SIM_PERIODIC,
+    SCD4X_SIM_LOW_POWER,
+    SCD4X_SIM_SINGLE_SHOT,
+    SCD4X_SIM_SLEEP,
+} scd4x_sim_mode_t;
+
+typedef struct {
+    uint16_t temperature_offset_raw;
+    uint16_t sensor_altitude;
+    uint16_t ambient_pressure_raw;
+    uint16_t asc_enabled;
+    uint16_t asc_target;
+    uint16_t asc_initial_period;
+    uint16_t asc_standard_period;
+} scd4x_sim_settings_t;
+
+/* Datasheet defaults; the temperature offset is 4 °C */
+static const scd4x_sim_settings_t default_settings = {
+    .temperature_offset_raw = 1498,
+    .sensor_altitude = 0,
+    .ambient_pressure_raw = 1013,
+    .asc_enabled = 1,
+    .asc_target = 400,
+    .asc_initial_period = 44,
+    .asc_standard_period = 156,
+};
+
+static struct {
+    uint8_t mode;
+    uint64_t started_us;
+    uint32_t consumed;
+    scd4x_sim_settings_t settings;
+    scd4x_sim_settings_t persisted;
+    bool ramp;
+    uint16_t co2_ppm;
+    int32_t temperature_m_deg_c;
+    int32_t humidity_m_percent_rh;
+    uint32_t noise;
+    /* Reported CO2 is the signal plus drift minus correction; FRC and ASC
+     * both move the correction */
+    int16_t drift_ppm;
+    int32_t correction_ppm;
+    /* ASC: measuring time with ASC enabled since the last period ended, up
+     * to asc_updated_us, and the lowest CO2 reported in that time */
+    uint64_t asc_updated_us;
+    uint64_t asc_elapsed_us;
+    uint16_t asc_lowest_ppm;
+    bool asc_initial_done;
+    uint8_t response[SENSIRION_I2C_CMD_BUFFER_SIZE];
+    uint8_t response_len;
+} sim = {
+    /* default_settings, which cannot initialise a static in C */
+    .settings = {1498, 0, 1013, 1, 400, 44, 156},
+    .persisted = {1498, 0, 1013, 1, 400, 44, 156},
+    .ramp = true,
+    .co2_ppm = SCD4X_SIM_RAMP_LOW_PPM,
+    .temperature_m_deg_c = 22500,
+    .humidity_m_percent_rh = 45000,
+    .noise = 1,
+    .asc_lowest_ppm = 0xFFFF,
+};
+
+static void asc_restart(void) {
+    sim.asc_elapsed_us = 0;
+    sim.asc_lowest_ppm = 0xFFFF;
+    sim.asc_initial_done = false;
+}
+
+void scd4x_sim_reset(void) {
+    sim.mode = SCD4X_SIM_IDLE;
+    sim.consumed = 0;
+    sim.settings = sim.persisted;
+    sim.response_len = 0;
+    sim.drift_ppm = 0;
+    sim.correction_ppm = 0;
+    asc_restart();
+    scd4x_sim_set_ramp();
+}
+
+void scd4x_sim_set_signal(uint16_t co2_ppm, int32_t temperature_m_deg_c,
+                          int32_t humidity_m_percent_rh) {
+    sim.ramp = false;
+    sim.co2_ppm = co2_ppm;
+    sim.temperature_m_deg_c = temperature_m_deg_c;
+    sim.humidity_m_percent_rh = humidity_m_percent_rh;
+}
+
+void scd4x_sim_set_ramp(void) {
+    sim.ramp = true;
+    sim.temperature_m_deg_c = 22500;
+    sim.humidity_m_percent_rh = 45000;
+}
+
+void scd4x_sim_set_drift(int16_t drift_ppm) {
+    sim.drift_ppm = drift_ppm;
+}
+
+static uint16_t clamp_raw(int64_t raw) {
+    if (raw < 0) {
+        return 0;
+    }
+    return raw > 0xFFFF ? 0xFFFF : (uint16_t)raw;
+}
+
+static uint16_t ramp_co2(uint64_t now_us) {
+    uint64_t half = SCD4X_SIM_RAMP_PERIOD_US / 2;
+    uint64_t phase = now_us % SCD4X_SIM_RAMP_PERIOD_US;
+    uint64_t rise = phase < half ? phase : SCD4X_SIM_RAMP_PERIOD_US - phase;
+    uint32_t span = SCD4X_SIM_RAMP_HIGH_PPM - SCD4X_SIM_RAMP_LOW_PPM;
+    int32_t noise;
+
+    /* LCG, only the top bits are used: -4 to +3 ppm */
+    sim.noise = sim.noise * 1103515245u + 12345u;
+    noise = (int32_t)(sim.noise >> 29) - 4;
+    return (uint16_t)(SCD4X_SIM_RAMP_LOW_PPM + span * rise / half + noise);
+}
+
+/* CO2 as the sensor reports it */
+static uint16_t reported_co2(uint64_t now_us) {
+    uint16_t co2_ppm = sim.ramp ? ramp_co2(now_us) : sim.co2_ppm;
+    return clamp_raw((int64_t)co2_ppm + sim.drift_ppm - sim.correction_ppm);
+}
+
+static void respond(const uint16_t* words, uint8_t num_words) {
+    uint8_t i;
+    for (i = 0; i < num_words; i++) {
+        sim.response[i * 3] = (uint8_t)(words[i] >> 8);
+        sim.response[i * 3 + 1] = (uint8_t)words[i];
+        sim.response[i * 3 + 2] =
+            sensirion_i2c_generate_crc(&sim.response[i * 3], 2);
+    }
+    sim.response_len = num_words * 3;
+}
+
+static void respond_word(uint16_t word) {
+    respond(&word, 1);
+}
+
+static uint32_t measurements_available(uint64_t now_us) {
+    uint64_t elapsed = now_us - sim.started_us;
+    switch (sim.mode) {
+        case SCD4X_SIM_PERIODIC:
+            return (uint32_t)(elapsed / SCD4X_SIM_PERIODIC_INTERVAL_US);
+        case SCD4X_SIM_LOW_POWER:
+            return (uint32_t)(elapsed / SCD4X_SIM_LOW_POWER_INTERVAL_US);
+        case SCD4X_SIM_SINGLE_SHOT:
+            return elapsed >= SCD4X_SIM_SINGLE_SHOT_US ? 1 : 0;
+        default:
+            return 0;
+    }
+}
+
+static void respond_measurement(uint64_t now_us) {
+    uint16_t words[3];
+    uint16_t co2_ppm = reported_co2(now_us);
+
+    if (sim.settings.asc_enabled && co2_ppm < sim.asc_lowest_ppm) {
+        sim.asc_lowest_ppm = co2_ppm;
+    }
+    /* Inverse of the driver conversions, rounded up so they give the value
+     * back */
+    words[0] = co2_ppm;
+    words[1] = clamp_raw(
+        ((int64_t)(sim.temperature_m_deg_c + 45000) * 8192 + 21874) / 21875);
+    words[2] =
+        clamp_raw(((int64_t)sim.humidity_m_percent_rh * 8192 + 12499) / 12500);
+    respond(words, 3);
+    sim.consumed = measurements_available(now_us);
+    if (sim.mode == SCD4X_SIM_SINGLE_SHOT) {
+        sim.mode = SCD4X_SIM_IDLE;
+    }
+}
+
+static bool measuring(void) {
+    return sim.mode == SCD4X_SIM_PERIODIC || sim.mode == SCD4X_SIM_LOW_POWER;
+}
+
+/* Commands the sensor accepts while measuring periodically */
+static bool allowed_while_measuring(scd4x_command_t command) {
+    switch (command) {
+        case scd4x_cmd_read_measurement_raw:
+        case scd4x_cmd_get_data_ready_status_raw:
+        case scd4x_cmd_stop_periodic_measurement:
+        case scd4x_cmd_set_ambient_pressure_raw:
+        case scd4x_cmd_get_ambient_pressure_raw:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/* ASC takes the lowest CO2 reported during each period to be the ASC target
+ * and corrects by the difference. The first period after a factory reset is
+ * the initial period, the following ones the standard period; only time spent
+ * measuring periodically with ASC enabled counts. Called before every command,
+ * so a period ending between two commands is applied by the second one. */
+static void asc_update(uint64_t now_us) {
+    scd4x_sim_settings_t* settings = &sim.settings;
+    uint64_t period_us;
+
+    if (measuring() && settings->asc_enabled) {
+        sim.asc_elapsed_us += now_us - sim.asc_updated_us;
+    }
+    sim.asc_updated_us = now_us;
+
+    period_us = (sim.asc_initial_done ? settings->asc_standard_period
+                                      : settings->asc_initial_period) *
+                SCD4X_SIM_HOUR_US;
+    if (period_us == 0 || sim.asc_elapsed_us < period_us) {
+        return;
+    }
+    if (sim.asc_lowest_ppm != 0xFFFF) {
+        sim.correction_ppm += sim.asc_lowest_ppm - settings->asc_target;
+    }
+    sim.asc_elapsed_us -= period_us;
+    sim.asc_lowest_ppm = 0xFFFF;
+    sim.asc_initial_done = true;
+}
+
+static int16_t execute(scd4x_command_t command, const uint16_t* args,
+                       uint64_t now_us) {
+    scd4x_sim_settings_t* settings = &sim.settings;
+
+    asc_update(now_us);
+    if (sim.mode == SCD4X_SIM_SLEEP) {
+        if (command != scd4x_cmd_wake_up) {
+            return -1;
+        }
+        sim.mode = SCD4X_SIM_IDLE;
+        /* The sensor does not acknowledge wake_up */
+        return -1;
+    }
+    if (measuring() && !allowed_while_measuring(command)) {
+        return -1;
+    }
+
+    switch (command) {
+        case scd4x_cmd_start_periodic_measurement:
+        case scd4x_cmd_start_low_power_periodic_measurement:
+        case scd4x_cmd_measure_single_shot:
+            sim.mode = command == scd4x_cmd_start_periodic_measurement
+                           ? SCD4X_SIM_PERIODIC
+                       : command == scd4x_cmd_measure_single_shot
+                           ? SCD4X_SIM_SINGLE_SHOT
+                           : SCD4X_SIM_LOW_POWER;
+            sim.started_us = now_us;
+            sim.consumed = 0;
+            break;
+        case scd4x_cmd_stop_periodic_measurement:
+            sim.mode = SCD4X_SIM_IDLE;
+            break;
+        case scd4x_cmd_read_measurement_raw:
+            if (measurements_available(now_us) > sim.consumed) {
+                respond_measurement(now_us);
+            }
+            break;
+        case scd4x_cmd_get_data_ready_status_raw:
+            respond_word(measurements_available(now_us) > sim.consumed
+                             ? SCD4X_SIM_DATA_READY
+                             : SCD4X_SIM_DATA_NOT_READY);
+            break;
+        case scd4x_cmd_set_temperature_offset_raw:
+            settings->temperature_offset_raw = args[0];
+            break;
+        case scd4x_cmd_get_temperature_offset_raw:
+            respond_word(settings->temperature_offset_raw);
+            break;
+        case scd4x_cmd_set_sensor_altitude:
+            settings->sensor_altitude = args[0];
+            break;
+        case scd4x_cmd_get_sensor_altitude:
+            respond_word(settings->sensor_altitude);
+            break;
+        case scd4x_cmd_set_ambient_pressure_raw:
+            settings->ambient_pressure_raw = args[0];
+            break;
+        case scd4x_cmd_get_ambient_pressure_raw:
+            respond_word(settings->ambient_pressure_raw);
+            break;
+        case scd4x_cmd_set_automatic_self_calibration_enabled:
+            settings->asc_enabled = args[0];
+            break;
+        case scd4x_cmd_get_automatic_self_calibration_enabled:
+            respond_word(settings->asc_enabled);
+            break;
+        case scd4x_cmd_set_automatic_self_calibration_target:
+            settings->asc_target = args[0];
+            break;
+        case scd4x_cmd_get_automatic_self_calibration_target:
+            respond_word(settings->asc_target);
+            break;
+        case scd4x_cmd_set_automatic_self_calibration_initial_period:
+            settings->asc_initial_period = args[0];
+            break;
+        case scd4x_cmd_get_automatic_self_calibration_initial_period:
+            respond_word(settings->asc_initial_period);
+            break;
+        case scd4x_cmd_set_automatic_self_calibration_standard_period:
+            settings->asc_standard_period = args[0];
+            break;
+        case scd4x_cmd_get_automatic_self_calibration_standard_period:
+            respond_word(settings->asc_standard_period);
+            break;
+        case scd4x_cmd_perform_forced_recalibration: {
+            uint16_t co2_ppm = reported_co2(now_us);
+            respond_word((uint16_t)(args[0] - co2_ppm + 0x8000));
+            sim.correction_ppm += co2_ppm - args[0];
+            break;
+        }
+        case scd4x_cmd_persist_settings:
+            sim.persisted = sim.settings;
+            break;
+        case scd4x_cmd_get_serial_number: {
+            static const uint16_t serial[3] = {0x5349, 0x4d53, 0x4344};
+            respond(serial, 3);
+            break;
+        }
+        case scd4x_cmd_perform_self_test:
+            respond_word(0);
+            break;
+        case scd4x_cmd_perform_factory_reset:
+            sim.persisted = default_settings;
+            sim.settings = default_settings;
+            sim.correction_ppm = 0;
+            asc_restart();
+            break;
+        case scd4x_cmd_reinit:
+            sim.settings = sim.persisted;
+            break;
+        case scd4x_cmd_get_sensor_variant_raw:
+            respond_word(SCD4X_SENSOR_VARIANT_SCD41);
+            break;
+        case scd4x_cmd_power_down:
+            sim.mode = SCD4X_SIM_SLEEP;
+            break;
+        case scd4x_cmd_measure_single_shot_rht_only:
+        case scd4x_cmd_wake_up:
+        default:
+            break;
+    }
+    return NO_ERROR;
+}
+
+static int8_t scd4x_sim_write(uint8_t address, const uint8_t* data,
+                              uint8_t count) {
+    uint16_t args[SENSIRION_I2C_CMD_MAX_ARGS];
+    uint16_t code;
+    uint8_t num_args;
+    uint8_t i;
+    int command;
+
+    if (address != SCD40_I2C_ADDR_62 || count < SENSIRION_COMMAND_SIZE ||
+        (count - SENSIRION_COMMAND_SIZE) % 3 != 0) {
+        return -1;
+    }
+    code = (uint16_t)(data[0] << 8 | data[1]);
+    num_args = (count - SENSIRION_COMMAND_SIZE) / 3;
+    if (num_args > SENSIRION_I2C_CMD_MAX_ARGS) {
+        return -1;
+    }
+    for (i = 0; i < num_args; i++) {
+        const uint8_t* word = &data[SENSIRION_COMMAND_SIZE + i * 3];
+        if (sensirion_i2c_generate_crc(word, 2) != word[2]) {
+            return -1;
+        }
+        args[i] = (uint16_t)(word[0] << 8 | word[1]);
+    }
+
+    /* Set and get ambient pressure share a code; the argument count tells
+     * them apart */
+    command = -1;
+    for (i = 0; i < SCD4X_COMMAND_COUNT; i++) {
+        if (scd4x_commands[i].code == code &&
+            scd4x_commands[i].num_args == num_args) {
+            command = i;
+            break;
+        }
+    }
+    if (command < 0) {
+        return -1;
+    }
+
+    sim.response_len = 0;
+    return execute((scd4x_command_t)command, args,
+                   sensirion_i2c_hal_get_time_usec()) == NO_ERROR
+               ? 0
+               : -1;
+}
+
+static int8_t scd4x_sim_read(uint8_t address, uint8_t* data, uint8_t count) {
+    uint8_t i;
+
+    if (address != SCD40_I2C_ADDR_62 || sim.response_len == 0 ||
+        count > sim.response_len) {
+        return -1;
+    }
+    for (i = 0; i < count; i++) {
+        data[i] = sim.response[i];
+    }
+    sim.response_len = 0;
+    return 0;
+}
+
+const sensirion_i2c_hal_bus_t scd4x_sim_bus = {
+    .read = scd4x_sim_read,
+    .write = scd4x_sim_write,
+};
@@ -0,0 +1,79 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#ifndef SCD4X_SIM_H
+#define SCD4X_SIM_H
+
+#include "sensirion_config.h"
+#include "sensirion_i2c_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Simulated SCD4x on the device side of the I2C bus.
+ *
+ * Answers the same frames as the sensor at SCD40_I2C_ADDR_62: commands are
+ * looked up in scd4x_commands[], arguments are CRC-checked and responses
+ * carry CRCs, so the unmodified driver runs against it. Measurements become
+ * ready on the sensor's schedule (5 s periodic, 30 s low power, 5 s single
+ * shot) according to sensirion_i2c_hal_get_time_usec(), which makes it work
+ * in real and in simulated time. Commands the sensor refuses in its current
+ * mode, bad CRCs and reads without a pending response are not acknowledged.
+ *
+ * Forced recalibration and automatic self-calibration are modelled: both
+ * correct the reported CO2, FRC to the given reference and ASC at the end of
+ * every initial and standard period (in hours of periodic measurement, as set
+ * with the scd4x_*_automatic_self_calibration_* commands) so that the lowest
+ * CO2 reported during the period reads as the ASC target. A factory reset
+ * clears the correction and restarts the initial period.
+ *
+ * Not thread safe; the driver serialises all accesses anyway.
+ */
+
+/**
+ * Bus to pass to sensirion_i2c_hal_set_bus(). Any other address is not
+ * acknowledged.
+ */
+extern const sensirion_i2c_hal_bus_t scd4x_sim_bus;
+
+/**
+ * Power-cycle the simulated sensor: idle, persisted settings, ramp signal,
+ * no drift, no correction and ASC back at the start of its initial period.
+ */
+void scd4x_sim_reset(void);
+
+/**
+ * Report fixed values from the next measurement on.
+ *
+ * @param co2_ppm CO2 concentration
+ * @param temperature_m_deg_c temperature in m°C, -45000 to 130000
+ * @param humidity_m_percent_rh relative humidity in m%RH, 0 to 100000
+ */
+void scd4x_sim_set_signal(uint16_t co2_ppm, int32_t temperature_m_deg_c,
+                          int32_t humidity_m_percent_rh);
+
+/**
+ * Go back to the default signal: CO2 ramps between 450 and 3050 ppm and
+ * back every 40 minutes with a few ppm of noise, at 22.5 °C and 45 %RH.
+ * The ramp goes through the good, fair and moderate AirQuality levels.
+ */
+void scd4x_sim_set_ramp(void);
+
+/**
+ * Make the sensor read high by `drift_ppm` (low if negative), as an ageing
+ * sensor does, from the next measurement on. FRC and ASC correct it.
+ */
+void scd4x_sim_set_drift(int16_t drift_ppm);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SCD4X_SIM_H */
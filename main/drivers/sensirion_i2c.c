@@ -84,49 +84,81 @@ uint16_t sensirion_i2c_fill_cmd_send_buf(uint8_t* buf, uint16_t cmd,
     return idx;
 }
 
+int16_t sensirion_i2c_compact_words_inplace(uint8_t* buffer,
+                                            uint16_t num_words) {
+    const uint8_t* src = buffer;
+    uint8_t* dst = buffer;
+    uint16_t i;
+
+    /* dst never overtakes src, so each word is checked before it is moved */
+    for (i = 0; i < num_words; ++i) {
+        if (sensirion_i2c_generate_crc(src, SENSIRION_WORD_SIZE) !=
+            src[SENSIRION_WORD_SIZE])
+            return CRC_ERROR;
+        dst[0] = src[0];
+        dst[1] = src[1];
+        src += SENSIRION_WORD_SIZE + CRC8_LEN;
+        dst += SENSIRION_WORD_SIZE;
+    }
+    return NO_ERROR;
+}
+
+int16_t sensirion_i2c_decode_words(const uint8_t* frame, uint16_t* data_words,
+                                   uint16_t num_words) {
+    uint16_t i;
+
+    for (i = 0; i < num_words; ++i) {
+        if (sensirion_i2c_generate_crc(frame, SENSIRION_WORD_SIZE) !=
+            frame[SENSIRION_WORD_SIZE])
+            return CRC_ERROR;
+        data_words[i] = ((uint16_t)frame[0] << 8) | frame[1];
+        frame += SENSIRION_WORD_SIZE + CRC8_LEN;
+    }
+    return NO_ERROR;
+}
+
 int16_t sensirion_i2c_read_words_as_bytes(uint8_t address, uint8_t* data,
                                           uint16_t num_words) {
     int16_t ret;
-    uint16_t i, j;
-    uint16_t size = num_words * (SENSIRION_WORD_SIZE + CRC8_LEN);
-    uint16_t word_buf[SENSIRION_MAX_BUFFER_WORDS];
-    uint8_t* const buf8 = (uint8_t*)word_buf;
+    uint16_t i;
+    uint8_t
+        frame[SENSIRION_MAX_BUFFER_WORDS * (SENSIRION_WORD_SIZE + CRC8_LEN)];
+    const uint8_t* src = frame;
 
-    ret = sensirion_i2c_hal_read(address, buf8, size);
+    if (num_words > SENSIRION_MAX_BUFFER_WORDS)
+        return BYTE_NUM_ERROR;
+
+    ret = sensirion_i2c_hal_read(address, frame,
+                                 num_words * (SENSIRION_WORD_SIZE + CRC8_LEN));
     if (ret != NO_ERROR)
         return ret;
 
-    /* check the CRC for each word */
-    for (i = 0, j = 0; i < size; i += SENSIRION_WORD_SIZE + CRC8_LEN) {
-
-        ret = sensirion_i2c_check_crc(&buf8[i], SENSIRION_WORD_SIZE,
-                                      buf8[i + SENSIRION_WORD_SIZE]);
-        if (ret != NO_ERROR)
-            return ret;
-
-        data[j++] = buf8[i];
-        data[j++] = buf8[i + 1];
+    for (i = 0; i < num_words; ++i) {
+        if (sensirion_i2c_generate_crc(src, SENSIRION_WORD_SIZE) !=
+            src[SENSIRION_WORD_SIZE])
+            return CRC_ERROR;
+        *data++ = src[0];
+        *data++ = src[1];
+        src += SENSIRION_WORD_SIZE + CRC8_LEN;
     }
-
     return NO_ERROR;
 }
 
 int16_t sensirion_i2c_read_words(uint8_t address, uint16_t* data_words,
                                  uint16_t num_words) {
     int16_t ret;
-    uint8_t i;
+    uint8_t
+        frame[SENSIRION_MAX_BUFFER_WORDS * (SENSIRION_WORD_SIZE + CRC8_LEN)];
+
+    if (num_words > SENSIRION_MAX_BUFFER_WORDS)
+        return BYTE_NUM_ERROR;
 
-    ret = sensirion_i2c_read_words_as_bytes(address, (uint8_t*)data_words,
-                                            num_words);
+    ret = sensirion_i2c_hal_read(address, frame,
+                                 num_words * (SENSIRION_WORD_SIZE + CRC8_LEN));
     if (ret != NO_ERROR)
         return ret;
 
-    for (i = 0; i < num_words; ++i) {
-        const uint8_t* word_bytes = (uint8_t*)&data_words[i];
-        data_words[i] = ((uint16_t)word_bytes[0] << 8) | word_bytes[1];
-    }
-
-    return NO_ERROR;
+    return sensirion_i2c_decode_words(frame, data_words, num_words);
 }
 
 int16_t sensirion_i2c_write_cmd(uint8_t address, uint16_t command) {
@@ -139,9 +171,15 @@ int16_t sensirion_i2c_write_cmd(uint8_t address, uint16_t command) {
 int16_t sensirion_i2c_write_cmd_with_args(uint8_t address, uint16_t command,
                                           const uint16_t* data_words,
                                           uint16_t num_words) {
-    uint8_t buf[SENSIRION_MAX_BUFFER_WORDS];
+    /* Sized in bytes: the command plus up to SENSIRION_MAX_BUFFER_WORDS
+     * CRC-protected argument words */
+    uint8_t buf[SENSIRION_COMMAND_SIZE + SENSIRION_MAX_BUFFER_WORDS *
+                                             (SENSIRION_WORD_SIZE + CRC8_LEN)];
     uint16_t buf_size;
 
+    if (num_words > SENSIRION_MAX_BUFFER_WORDS)
+        return BYTE_NUM_ERROR;
+
     buf_size =
         sensirion_i2c_fill_cmd_send_buf(buf, command, data_words, num_words);
     return sensirion_i2c_hal_write(address, buf, buf_size);
@@ -273,35 +311,29 @@ uint16_t sensirion_i2c_add_bytes_to_buffer(uint8_t* buffer, uint16_t offset,
 
 int16_t sensirion_i2c_write_data(uint8_t address, const uint8_t* data,
                                  uint16_t data_length) {
+    if (data_length > UINT8_MAX) {
+        return BYTE_NUM_ERROR;
+    }
     return sensirion_i2c_hal_write(address, data, data_length);
 }
 
 int16_t sensirion_i2c_read_data_inplace(uint8_t address, uint8_t* buffer,
                                         uint16_t expected_data_length) {
     int16_t error;
-    uint16_t i, j;
-    uint16_t size = (expected_data_length / SENSIRION_WORD_SIZE) *
-                    (SENSIRION_WORD_SIZE + CRC8_LEN);
+    uint16_t num_words = expected_data_length / SENSIRION_WORD_SIZE;
 
-    if (expected_data_length % SENSIRION_WORD_SIZE != 0) {
+    /* The HAL transfers at most UINT8_MAX bytes; a longer frame would be
+     * truncated and the CRC loop would run past what was read */
+    if (expected_data_length % SENSIRION_WORD_SIZE != 0 ||
+        num_words * (SENSIRION_WORD_SIZE + CRC8_LEN) > UINT8_MAX) {
         return BYTE_NUM_ERROR;
     }
 
-    error = sensirion_i2c_hal_read(address, buffer, size);
+    error = sensirion_i2c_hal_read(
+        address, buffer, num_words * (SENSIRION_WORD_SIZE + CRC8_LEN));
     if (error) {
         return error;
     }
 
-    for (i = 0, j = 0; i < size; i += SENSIRION_WORD_SIZE + CRC8_LEN) {
-
-        error = sensirion_i2c_check_crc(&buffer[i], SENSIRION_WORD_SIZE,
-                                        buffer[i + SENSIRION_WORD_SIZE]);
-        if (error) {
-            return error;
-        }
-        buffer[j++] = buffer[i];
-        buffer[j++] = buffer[i + 1];
-    }
-
-    return NO_ERROR;
+    return sensirion_i2c_compact_words_inplace(buffer, num_words);
 }
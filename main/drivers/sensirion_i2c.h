@@ -84,13 +84,45 @@ uint16_t sensirion_i2c_fill_cmd_send_buf(uint8_t* buf, uint16_t cmd,
                                          const uint16_t* args,
                                          uint8_t num_args);
 
+/**
+ * sensirion_i2c_compact_words_inplace() - check the CRCs of a received frame
+ *                                         and strip them in a single pass
+ *
+ * @buffer:     Received frame of num_words * (SENSIRION_WORD_SIZE + CRC8_LEN)
+ *              bytes. On success the first num_words * SENSIRION_WORD_SIZE
+ *              bytes hold the payload in sensor (big-endian) byte order.
+ *              The buffer may also have been modified in case of an error.
+ * @num_words:  Number of data words in the frame
+ *
+ * @return      NO_ERROR on success, CRC_ERROR otherwise
+ */
+int16_t sensirion_i2c_compact_words_inplace(uint8_t* buffer,
+                                            uint16_t num_words);
+
+/**
+ * sensirion_i2c_decode_words() - check the CRCs of a received frame and
+ *                                decode it to host-order words in a single
+ *                                pass
+ *
+ * @frame:      Received frame of num_words * (SENSIRION_WORD_SIZE + CRC8_LEN)
+ *              bytes
+ * @data_words: Allocated buffer to store the decoded words.
+ *              The buffer may also have been modified in case of an error.
+ * @num_words:  Number of data words in the frame
+ *
+ * @return      NO_ERROR on success, CRC_ERROR otherwise
+ */
+int16_t sensirion_i2c_decode_words(const uint8_t* frame, uint16_t* data_words,
+                                   uint16_t num_words);
+
 /**
  * sensirion_i2c_read_words() - read data words from sensor
  *
  * @address:    Sensor i2c address
  * @data_words: Allocated buffer to store the read words.
  *              The buffer may also have been modified in case of an error.
- * @num_words:  Number of data words to read (without CRC bytes)
+ * @num_words:  Number of data words to read (without CRC bytes), at most
+ *              SENSIRION_MAX_BUFFER_WORDS
  *
  * @return      NO_ERROR on success, an error code otherwise
  */
@@ -0,0 +1,135 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include "sensirion_i2c_cmd.h"
+#include "sensirion_common.h"
+#include "sensirion_i2c.h"
+#include "sensirion_i2c_hal.h"
+
+int16_t sensirion_i2c_cmd_start(sensirion_i2c_cmd_t* cmd, uint8_t address,
+                                const sensirion_i2c_cmd_desc_t* desc,
+                                const uint16_t* args) {
+    uint16_t offset = 0;
+    uint8_t i;
+
+    cmd->desc = desc;
+    cmd->address = address;
+    cmd->ready_at_us = 0;
+    if (desc->num_args > SENSIRION_I2C_CMD_MAX_ARGS ||
+        desc->num_response_words > SENSIRION_I2C_CMD_MAX_RESPONSE_WORDS ||
+        (desc->num_args > 0 && args == NULL)) {
+        cmd->state = SENSIRION_I2C_CMD_STATE_DONE;
+        cmd->error = BYTE_NUM_ERROR;
+        return BYTE_NUM_ERROR;
+    }
+
+    offset = sensirion_i2c_add_command16_to_buffer(cmd->buffer, offset,
+                                                   desc->code);
+    for (i = 0; i < desc->num_args; i++) {
+        offset =
+            sensirion_i2c_add_uint16_t_to_buffer(cmd->buffer, offset, args[i]);
+    }
+    cmd->state = SENSIRION_I2C_CMD_STATE_WRITE;
+    cmd->error = NO_ERROR;
+    return NO_ERROR;
+}
+
+static void sensirion_i2c_cmd_finish(sensirion_i2c_cmd_t* cmd, int16_t error) {
+    cmd->error = error;
+    cmd->state = SENSIRION_I2C_CMD_STATE_DONE;
+}
+
+bool sensirion_i2c_cmd_poll(sensirion_i2c_cmd_t* cmd, uint64_t now_us) {
+    const sensirion_i2c_cmd_desc_t* desc = cmd->desc;
+    int16_t error;
+
+    switch (cmd->state) {
+        case SENSIRION_I2C_CMD_STATE_WRITE:
+            error = sensirion_i2c_write_data(
+                cmd->address, cmd->buffer,
+                SENSIRION_COMMAND_SIZE + desc->num_args * 3);
+            if (error != NO_ERROR &&
+                !(desc->flags & SENSIRION_I2C_CMD_FLAG_NO_ACK)) {
+                sensirion_i2c_cmd_finish(cmd, error);
+                break;
+            }
+            /* The sensor starts executing once the write is over, which may
+             * be well after `now_us`: the frame takes ~0.5 ms at 100 kHz and
+             * poll_all() may have spent bus time on earlier commands */
+            cmd->ready_at_us =
+                sensirion_i2c_hal_get_time_usec() + desc->exec_time_us;
+            cmd->state = SENSIRION_I2C_CMD_STATE_WAIT;
+            break;
+
+        case SENSIRION_I2C_CMD_STATE_WAIT:
+            if (now_us < cmd->ready_at_us) {
+                break;
+            }
+            error = NO_ERROR;
+            if (desc->num_response_words > 0) {
+                error = sensirion_i2c_read_data_inplace(
+                    cmd->address, cmd->buffer,
+                    desc->num_response_words * SENSIRION_WORD_SIZE);
+            }
+            sensirion_i2c_cmd_finish(cmd, error);
+            break;
+
+        default:
+            break;
+    }
+    return cmd->state != SENSIRION_I2C_CMD_STATE_WRITE &&
+           cmd->state != SENSIRION_I2C_CMD_STATE_WAIT;
+}
+
+uint64_t sensirion_i2c_cmd_poll_all(sensirion_i2c_cmd_t* const* cmds,
+                                    uint8_t count, uint64_t now_us) {
+    uint64_t next_us = UINT64_MAX;
+    uint8_t i;
+
+    for (i = 0; i < count; i++) {
+        sensirion_i2c_cmd_t* cmd = cmds[i];
+        if (sensirion_i2c_cmd_poll(cmd, now_us)) {
+            continue;
+        }
+        /* A command that was just written can progress at ready_at_us; one
+         * still waiting to be written can progress right away */
+        uint64_t ready_us = cmd->state == SENSIRION_I2C_CMD_STATE_WAIT
+                                ? cmd->ready_at_us
+                                : now_us;
+        if (ready_us < next_us) {
+            next_us = ready_us;
+        }
+    }
+    return next_us;
+}
+
+int16_t sensirion_i2c_cmd_run(sensirion_i2c_cmd_t* cmd) {
+    while (!sensirion_i2c_cmd_poll(cmd, sensirion_i2c_hal_get_time_usec())) {
+        uint64_t now_us = sensirion_i2c_hal_get_time_usec();
+        if (cmd->state == SENSIRION_I2C_CMD_STATE_WAIT &&
+            cmd->ready_at_us > now_us) {
+            sensirion_i2c_hal_sleep_usec(
+                (uint32_t)(cmd->ready_at_us - now_us));
+        }
+    }
+    return cmd->error;
+}
+
+uint16_t sensirion_i2c_cmd_response_word(const sensirion_i2c_cmd_t* cmd,
+                                         uint8_t index) {
+    if (cmd->desc == NULL || index >= cmd->desc->num_response_words) {
+        return 0;
+    }
+    return sensirion_common_bytes_to_uint16_t(
+        &cmd->buffer[index * SENSIRION_WORD_SIZE]);
+}
+
+const uint8_t* sensirion_i2c_cmd_response_bytes(
+    const sensirion_i2c_cmd_t* cmd) {
+    return cmd->buffer;
+}
@@ -0,0 +1,125 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#ifndef SENSIRION_I2C_CMD_H
+#define SENSIRION_I2C_CMD_H
+
+#include "sensirion_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SENSIRION_I2C_CMD_MAX_ARGS 2
+#define SENSIRION_I2C_CMD_MAX_RESPONSE_WORDS 9
+/* Large enough for the command frame and for the CRC-protected response */
+#define SENSIRION_I2C_CMD_BUFFER_SIZE (SENSIRION_I2C_CMD_MAX_RESPONSE_WORDS * 3)
+
+/* The device does not acknowledge the command (e.g. wake_up), write errors
+ * are ignored */
+#define SENSIRION_I2C_CMD_FLAG_NO_ACK 0x01
+
+/**
+ * Static description of one sensor command: what is sent, how long the sensor
+ * needs to execute it, and how many words it answers with.
+ */
+typedef struct {
+    uint16_t code;
+    uint8_t num_args;
+    uint8_t num_response_words;
+    uint32_t exec_time_us;
+    uint8_t flags;
+} sensirion_i2c_cmd_desc_t;
+
+typedef enum {
+    SENSIRION_I2C_CMD_STATE_IDLE = 0,
+    SENSIRION_I2C_CMD_STATE_WRITE, /* command frame ready, not sent yet */
+    SENSIRION_I2C_CMD_STATE_WAIT,  /* sent, waiting for the execution time */
+    SENSIRION_I2C_CMD_STATE_DONE,  /* finished, `error` holds the outcome */
+} sensirion_i2c_cmd_state_t;
+
+/**
+ * One command in flight. The caller owns the storage; nothing is allocated.
+ * Only one command per device may be in flight at a time.
+ */
+typedef struct {
+    const sensirion_i2c_cmd_desc_t* desc;
+    uint8_t address;
+    uint8_t state;
+    int16_t error;
+    uint64_t ready_at_us;
+    uint8_t buffer[SENSIRION_I2C_CMD_BUFFER_SIZE];
+} sensirion_i2c_cmd_t;
+
+/**
+ * Prepare a command. No bus access happens until the first poll.
+ *
+ * @param cmd     command storage
+ * @param address 7-bit I2C address of the device
+ * @param desc    command description, must outlive the command
+ * @param args    `desc->num_args` argument words, may be NULL if none
+ * @returns 0 on success, an error code otherwise
+ */
+int16_t sensirion_i2c_cmd_start(sensirion_i2c_cmd_t* cmd, uint8_t address,
+                                const sensirion_i2c_cmd_desc_t* desc,
+                                const uint16_t* args);
+
+/**
+ * Advance a command by at most one bus transaction. Never sleeps.
+ *
+ * The execution time is counted from the end of the command write, read from
+ * the HAL clock when the write returns, so a `now_us` taken earlier only
+ * delays the response read and never makes it early.
+ *
+ * @param cmd    command started with sensirion_i2c_cmd_start()
+ * @param now_us current time from sensirion_i2c_hal_get_time_usec(), at or
+ *               before the call
+ * @returns true once the command is done (or was never started)
+ */
+bool sensirion_i2c_cmd_poll(sensirion_i2c_cmd_t* cmd, uint64_t now_us);
+
+/**
+ * Advance several commands, typically on different devices, in one pass.
+ *
+ * @param cmds   commands to advance; done ones are skipped
+ * @param count  number of commands
+ * @param now_us current time from sensirion_i2c_hal_get_time_usec()
+ * @returns the earliest time a pending command can progress, or UINT64_MAX
+ *          when all of them are done
+ */
+uint64_t sensirion_i2c_cmd_poll_all(sensirion_i2c_cmd_t* const* cmds,
+                                    uint8_t count, uint64_t now_us);
+
+/**
+ * Run a command to completion, sleeping through its execution time. This is
+ * what the blocking driver API is built on.
+ *
+ * @returns 0 on success, an error code otherwise
+ */
+int16_t sensirion_i2c_cmd_run(sensirion_i2c_cmd_t* cmd);
+
+/**
+ * Response word of a finished command.
+ *
+ * @param cmd   finished command
+ * @param index word index, below `desc->num_response_words`
+ * @returns the word in host byte order, 0 for an index out of range
+ */
+uint16_t sensirion_i2c_cmd_response_word(const sensirion_i2c_cmd_t* cmd,
+                                         uint8_t index);
+
+/**
+ * Response of a finished command as raw big-endian bytes, CRCs removed.
+ */
+const uint8_t* sensirion_i2c_cmd_response_bytes(const sensirion_i2c_cmd_t* cmd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SENSIRION_I2C_CMD_H */
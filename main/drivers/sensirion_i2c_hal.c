@@ -35,6 +35,7 @@
 
 #include "driver/i2c_master.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
@@ -112,7 +113,8 @@ void sensirion_i2c_hal_free(void) {
  * @param count   number of bytes to read from I2C and store in the buffer
  * @returns 0 on success, error code otherwise
  */
-int8_t sensirion_i2c_hal_read(uint8_t address, uint8_t* data, uint8_t count) {
+static int8_t sensirion_i2c_hal_real_read(uint8_t address, uint8_t* data,
+                                          uint8_t count) {
     if (i2c_bus_handle == NULL) {
         ESP_LOGE(TAG, "I2C not initialized");
         return -1;
@@ -157,8 +159,9 @@ int8_t sensirion_i2c_hal_read(uint8_t address, uint8_t* data, uint8_t count) {
  * @param count   number of bytes to read from the buffer and send over I2C
  * @returns 0 on success, error code otherwise
  */
-int8_t sensirion_i2c_hal_write(uint8_t address, const uint8_t* data,
-                               uint8_t count) {
+static int8_t sensirion_i2c_hal_real_write(uint8_t address,
+                                           const uint8_t* data,
+                                           uint8_t count) {
     if (i2c_bus_handle == NULL) {
         ESP_LOGE(TAG, "I2C not initialized");
         return -1;
@@ -192,6 +195,26 @@ int8_t sensirion_i2c_hal_write(uint8_t address, const uint8_t* data,
     return 0;
 }
 
+static const sensirion_i2c_hal_bus_t real_bus = {
+    .read = sensirion_i2c_hal_real_read,
+    .write = sensirion_i2c_hal_real_write,
+};
+
+static const sensirion_i2c_hal_bus_t* volatile hal_bus = &real_bus;
+
+void sensirion_i2c_hal_set_bus(const sensirion_i2c_hal_bus_t* bus) {
+    hal_bus = bus ? bus : &real_bus;
+}
+
+int8_t sensirion_i2c_hal_read(uint8_t address, uint8_t* data, uint8_t count) {
+    return hal_bus->read(address, data, count);
+}
+
+int8_t sensirion_i2c_hal_write(uint8_t address, const uint8_t* data,
+                               uint8_t count) {
+    return hal_bus->write(address, data, count);
+}
+
 /**
  * Sleep for a given number of microseconds. The function should delay the
  * execution for at least the given time, but may also sleep longer.
@@ -200,11 +223,39 @@ int8_t sensirion_i2c_hal_write(uint8_t address, const uint8_t* data,
  *
  * @param useconds the sleep time in microseconds
  */
-void sensirion_i2c_hal_sleep_usec(uint32_t useconds) {
+static void sensirion_i2c_hal_real_sleep_usec(uint32_t useconds) {
     // Convert microseconds to ticks (minimum 1 tick)
     uint32_t ticks = useconds / (1000 * portTICK_PERIOD_MS);
     if (ticks == 0) {
         ticks = 1;
     }
     vTaskDelay(ticks);
-}
\ No newline at end of file
+}
+
+static uint64_t sensirion_i2c_hal_real_get_time_usec(void) {
+    return (uint64_t)esp_timer_get_time();
+}
+
+static const sensirion_i2c_hal_clock_t real_clock = {
+    .get_time_usec = sensirion_i2c_hal_real_get_time_usec,
+    .sleep_usec = sensirion_i2c_hal_real_sleep_usec,
+};
+
+static const sensirion_i2c_hal_clock_t* volatile hal_clock = &real_clock;
+
+void sensirion_i2c_hal_set_clock(const sensirion_i2c_hal_clock_t* clock) {
+    hal_clock = clock ? clock : &real_clock;
+}
+
+void sensirion_i2c_hal_sleep_usec(uint32_t useconds) {
+    hal_clock->sleep_usec(useconds);
+}
+
+/**
+ * Return a monotonic timestamp in microseconds.
+ *
+ * @returns microseconds since boot, or simulated time
+ */
+uint64_t sensirion_i2c_hal_get_time_usec(void) {
+    return hal_clock->get_time_usec();
+}
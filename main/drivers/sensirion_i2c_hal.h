@@ -105,6 +105,48 @@ int8_t sensirion_i2c_hal_write(uint8_t address, const uint8_t* data,
  */
 void sensirion_i2c_hal_sleep_usec(uint32_t useconds);
 
+/**
+ * Return a monotonic timestamp in microseconds. Used by the non-blocking
+ * command engine to decide when a command's execution time has elapsed.
+ *
+ * @returns microseconds since an arbitrary, fixed origin
+ */
+uint64_t sensirion_i2c_hal_get_time_usec(void);
+
+/**
+ * Time source and sleep used by the HAL, replaceable for simulation.
+ */
+typedef struct {
+    uint64_t (*get_time_usec)(void);
+    void (*sleep_usec)(uint32_t useconds);
+} sensirion_i2c_hal_clock_t;
+
+/**
+ * Route sensirion_i2c_hal_get_time_usec() and sensirion_i2c_hal_sleep_usec()
+ * through another clock, e.g. a simulated one that advances instantly.
+ *
+ * @param clock the clock to use, must outlive its use; NULL restores the
+ *              real-time clock
+ */
+void sensirion_i2c_hal_set_clock(const sensirion_i2c_hal_clock_t* clock);
+
+/**
+ * Bus transactions used by the HAL, replaceable for simulation.
+ */
+typedef struct {
+    int8_t (*read)(uint8_t address, uint8_t* data, uint8_t count);
+    int8_t (*write)(uint8_t address, const uint8_t* data, uint8_t count);
+} sensirion_i2c_hal_bus_t;
+
+/**
+ * Route sensirion_i2c_hal_read() and sensirion_i2c_hal_write() to another
+ * bus, e.g. a simulated sensor.
+ *
+ * @param bus the bus to use, must outlive its use; NULL restores the
+ *            hardware bus
+ */
+void sensirion_i2c_hal_set_bus(const sensirion_i2c_hal_bus_t* bus);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
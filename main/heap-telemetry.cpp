@@ -0,0 +1,171 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <heap-telemetry.h>
+
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <esp_matter_console.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+
+static const char *TAG = "heap_telemetry";
+
+using namespace esp_matter;
+
+namespace heap_telemetry {
+
+static const uint32_t s_region_caps[HEAP_REGION_MAX] = {
+    MALLOC_CAP_DEFAULT,
+    MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT,
+    MALLOC_CAP_DMA,
+};
+
+static const char *s_region_names[HEAP_REGION_MAX] = {
+    "default",
+    "internal",
+    "dma",
+};
+
+/* Ring of lifecycle watermarks, written from the Matter task and read from the console task */
+static watermark_t s_watermarks[HEAP_TELEMETRY_MAX_WATERMARKS];
+static size_t s_watermark_count = 0;
+static size_t s_watermark_next = 0;
+static portMUX_TYPE s_watermark_lock = portMUX_INITIALIZER_UNLOCKED;
+
+void sample(heap_stat_t *stats)
+{
+    for (int i = 0; i < HEAP_REGION_MAX; i++) {
+        stats[i].free_bytes = heap_caps_get_free_size(s_region_caps[i]);
+        stats[i].min_free_bytes = heap_caps_get_minimum_free_size(s_region_caps[i]);
+        stats[i].largest_free_block = heap_caps_get_largest_free_block(s_region_caps[i]);
+    }
+}
+
+void record(const char *label)
+{
+    watermark_t mark;
+    mark.label = label;
+    mark.timestamp_us = esp_timer_get_time();
+    sample(mark.regions);
+
+    taskENTER_CRITICAL(&s_watermark_lock);
+    s_watermarks[s_watermark_next] = mark;
+    s_watermark_next = (s_watermark_next + 1) % HEAP_TELEMETRY_MAX_WATERMARKS;
+    if (s_watermark_count < HEAP_TELEMETRY_MAX_WATERMARKS) {
+        s_watermark_count++;
+    }
+    taskEXIT_CRITICAL(&s_watermark_lock);
+
+#if CONFIG_ENABLE_MEMORY_PROFILING
+    ESP_LOGI(TAG, "%s: free %" PRIu32 ", min free %" PRIu32 ", largest block %" PRIu32, label,
+             mark.regions[HEAP_REGION_INTERNAL].free_bytes, mark.regions[HEAP_REGION_INTERNAL].min_free_bytes,
+             mark.regions[HEAP_REGION_INTERNAL].largest_free_block);
+#endif
+}
+
+size_t get_watermarks(watermark_t *out, size_t max_count)
+{
+    size_t copied = 0;
+
+    taskENTER_CRITICAL(&s_watermark_lock);
+    size_t first = (s_watermark_next + HEAP_TELEMETRY_MAX_WATERMARKS - s_watermark_count) %
+                   HEAP_TELEMETRY_MAX_WATERMARKS;
+    for (; copied < s_watermark_count && copied < max_count; copied++) {
+        out[copied] = s_watermarks[(first + copied) % HEAP_TELEMETRY_MAX_WATERMARKS];
+    }
+    taskEXIT_CRITICAL(&s_watermark_lock);
+
+    return copied;
+}
+
+esp_err_t add_diagnostics_cluster(node_t *node)
+{
+    endpoint_t *root_endpoint = endpoint::get(node, 0);
+    if (!root_endpoint) {
+        ESP_LOGE(TAG, "Root endpoint not found");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    cluster::software_diagnostics::config_t software_diagnostics_config;
+    cluster_t *cluster = cluster::software_diagnostics::create(root_endpoint, &software_diagnostics_config,
+                                                               CLUSTER_FLAG_SERVER);
+    if (!cluster) {
+        ESP_LOGE(TAG, "Failed to create software diagnostics cluster");
+        return ESP_FAIL;
+    }
+    return cluster::software_diagnostics::feature::watermarks::add(cluster);
+}
+
+/* Output is CSV so it can be scraped from the serial log: label,time_ms,region,free,min_free,largest_block */
+static void print_stats(const char *label, int64_t timestamp_us, const heap_stat_t *stats)
+{
+    for (int i = 0; i < HEAP_REGION_MAX; i++) {
+        printf("%s,%" PRId64 ",%s,%" PRIu32 ",%" PRIu32 ",%" PRIu32 "\r\n", label, timestamp_us / 1000,
+               s_region_names[i], stats[i].free_bytes, stats[i].min_free_bytes, stats[i].largest_free_block);
+    }
+}
+
+static esp_err_t heap_now_handler(int argc, char **argv)
+{
+    heap_stat_t stats[HEAP_REGION_MAX];
+    sample(stats);
+    print_stats("now", esp_timer_get_time(), stats);
+    return ESP_OK;
+}
+
+static esp_err_t heap_watermarks_handler(int argc, char **argv)
+{
+    watermark_t marks[HEAP_TELEMETRY_MAX_WATERMARKS];
+    size_t count = get_watermarks(marks, HEAP_TELEMETRY_MAX_WATERMARKS);
+    for (size_t i = 0; i < count; i++) {
+        print_stats(marks[i].label, marks[i].timestamp_us, marks[i].regions);
+    }
+    return ESP_OK;
+}
+
+static console::engine heap_console;
+
+static esp_err_t heap_dispatch(int argc, char **argv)
+{
+    if (argc <= 0) {
+        heap_console.for_each_command(console::print_description, NULL);
+        return ESP_OK;
+    }
+    return heap_console.exec_command(argc, argv);
+}
+
+esp_err_t register_commands()
+{
+    static const console::command_t command = {
+        .name = "heap",
+        .description = "Heap telemetry. Usage: matter esp heap <now|watermarks>.",
+        .handler = heap_dispatch,
+    };
+
+    static const console::command_t heap_commands[] = {
+        {
+            .name = "now",
+            .description = "Print free, min-ever-free and largest free block per heap region",
+            .handler = heap_now_handler,
+        },
+        {
+            .name = "watermarks",
+            .description = "Print the heap snapshots recorded at lifecycle points",
+            .handler = heap_watermarks_handler,
+        },
+    };
+    heap_console.register_commands(heap_commands, sizeof(heap_commands) / sizeof(console::command_t));
+
+    return console::add_commands(&command, 1);
+}
+
+} // namespace heap_telemetry
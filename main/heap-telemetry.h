@@ -0,0 +1,88 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <esp_err.h>
+#include <esp_matter.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace heap_telemetry {
+
+/** Heap regions tracked by the telemetry module, one per heap capability */
+typedef enum {
+    HEAP_REGION_DEFAULT = 0, /* MALLOC_CAP_DEFAULT */
+    HEAP_REGION_INTERNAL,    /* MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT */
+    HEAP_REGION_DMA,         /* MALLOC_CAP_DMA */
+    HEAP_REGION_MAX,
+} heap_region_t;
+
+/** Free space figures of a single heap region */
+typedef struct {
+    uint32_t free_bytes;
+    uint32_t min_free_bytes;
+    uint32_t largest_free_block;
+} heap_stat_t;
+
+/** Heap snapshot taken at a named lifecycle point */
+typedef struct {
+    const char *label;
+    int64_t timestamp_us;
+    heap_stat_t regions[HEAP_REGION_MAX];
+} watermark_t;
+
+/** Maximum number of lifecycle watermarks kept in RAM; older ones are overwritten */
+#define HEAP_TELEMETRY_MAX_WATERMARKS 8
+
+/** Sample the heap
+ *
+ * Read the current free, minimum-ever-free and largest-free-block size of every tracked region.
+ *
+ * @param[out] stats Array of `HEAP_REGION_MAX` entries to fill.
+ */
+void sample(heap_stat_t *stats);
+
+/** Record a lifecycle watermark
+ *
+ * Take a heap snapshot and keep it under the given label. Safe to call from any task.
+ *
+ * @param[in] label Name of the lifecycle point. Must point to a string with static storage.
+ */
+void record(const char *label);
+
+/** Copy the recorded watermarks
+ *
+ * @param[out] out Array receiving the watermarks, oldest first.
+ * @param[in] max_count Capacity of `out`.
+ *
+ * @return Number of watermarks copied.
+ */
+size_t get_watermarks(watermark_t *out, size_t max_count);
+
+/** Add heap diagnostics to the data model
+ *
+ * Add the Software Diagnostics cluster with the watermarks feature to the root endpoint so that controllers can
+ * read the current free heap and the heap high watermark.
+ *
+ * @param[in] node Matter node created by the application.
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t add_diagnostics_cluster(esp_matter::node_t *node);
+
+/** Register the `heap` console commands
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t register_commands();
+
+} // namespace heap_telemetry
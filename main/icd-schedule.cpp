@@ -0,0 +1,122 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <icd-schedule.h>
+#include <icd-timeline.h>
+
+#include <esp_log.h>
+#include <esp_matter_console.h>
+#include <sdkconfig.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static const char *TAG = "icd_schedule";
+
+using namespace esp_matter;
+
+/* ICD timing. Without the ICD server the CHIP defaults are used, so the simulation still shows what a sleepy build
+ * would cost. */
+#if CONFIG_ENABLE_ICD_SERVER
+#define ICD_SLOW_POLL_MS CONFIG_ICD_SLOW_POLL_INTERVAL_MS
+#define ICD_FAST_POLL_MS CONFIG_ICD_FAST_POLL_INTERVAL_MS
+#define ICD_IDLE_MODE_MS (CONFIG_ICD_IDLE_MODE_INTERVAL_SEC * 1000)
+#define ICD_ACTIVE_THRESHOLD_MS CONFIG_ICD_ACTIVE_MODE_THRESHOLD_MS
+#else
+#define ICD_SLOW_POLL_MS 5000
+#define ICD_FAST_POLL_MS 200
+#define ICD_IDLE_MODE_MS (300 * 1000)
+#define ICD_ACTIVE_THRESHOLD_MS 1000
+#endif
+
+namespace icd_schedule {
+
+static const icd_timeline::icd_timing_t k_timing = {
+    .slow_poll_ms = ICD_SLOW_POLL_MS,
+    .fast_poll_ms = ICD_FAST_POLL_MS,
+    .idle_mode_ms = ICD_IDLE_MODE_MS,
+    .active_threshold_ms = ICD_ACTIVE_THRESHOLD_MS,
+};
+
+uint32_t align_sample_period(uint32_t requested_ms)
+{
+#if CONFIG_ENABLE_ICD_SERVER
+    uint32_t aligned_ms = icd_timeline::align_period(requested_ms, ICD_SLOW_POLL_MS);
+    if (aligned_ms != requested_ms) {
+        ESP_LOGI(TAG, "Sample period %" PRIu32 " ms rounded to %" PRIu32 " ms (%" PRIu32 " slow polls)", requested_ms,
+                 aligned_ms, aligned_ms / ICD_SLOW_POLL_MS);
+    }
+    return aligned_ms;
+#else
+    return requested_ms;
+#endif
+}
+
+void check_configuration(uint32_t sample_period_ms)
+{
+#if CONFIG_ENABLE_ICD_SERVER
+    if (ICD_IDLE_MODE_MS % sample_period_ms != 0) {
+        ESP_LOGW(TAG, "Idle mode interval (%d ms) is not a multiple of the sample period (%" PRIu32
+                      " ms); check-ins will wake the radio on their own",
+                 ICD_IDLE_MODE_MS, sample_period_ms);
+    }
+    if (ICD_ACTIVE_THRESHOLD_MS >= sample_period_ms) {
+        ESP_LOGW(TAG, "Active mode threshold (%d ms) covers the whole sample period; the device never idles",
+                 ICD_ACTIVE_THRESHOLD_MS);
+    }
+#else
+    ESP_LOGD(TAG, "ICD server disabled, sample period %" PRIu32 " ms not checked", sample_period_ms);
+#endif
+}
+
+static esp_err_t icd_timeline_handler(int argc, char **argv)
+{
+    uint32_t publish_period_ms = argc > 0 ? strtoul(argv[0], NULL, 0) : CONFIG_SENSOR_SAMPLE_PERIOD_MS;
+    if (publish_period_ms == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    icd_timeline::profile_t profiles[icd_timeline::k_profile_count];
+    icd_timeline::build_profiles(publish_period_ms, k_timing, profiles);
+    icd_timeline::print_hour(stdout, profiles, icd_timeline::k_profile_count, "\r\n");
+    return ESP_OK;
+}
+
+static console::engine icd_console;
+
+static esp_err_t icd_dispatch(int argc, char **argv)
+{
+    if (argc <= 0) {
+        icd_console.for_each_command(console::print_description, NULL);
+        return ESP_OK;
+    }
+    return icd_console.exec_command(argc, argv);
+}
+
+esp_err_t register_commands()
+{
+    static const console::command_t command = {
+        .name = "icd",
+        .description = "Radio schedule. Usage: matter esp icd timeline [publish_period_ms].",
+        .handler = icd_dispatch,
+    };
+
+    static const console::command_t icd_commands[] = {
+        {
+            .name = "timeline",
+            .description = "Simulate one hour and print the radio-on time of each power profile",
+            .handler = icd_timeline_handler,
+        },
+    };
+    icd_console.register_commands(icd_commands, sizeof(icd_commands) / sizeof(console::command_t));
+
+    return console::add_commands(&command, 1);
+}
+
+} // namespace icd_schedule
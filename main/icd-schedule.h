@@ -0,0 +1,43 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <esp_err.h>
+
+#include <stdint.h>
+
+namespace icd_schedule {
+
+/** Align a requested sample period with the ICD polling schedule
+ *
+ * On ICD builds the period is rounded up to a whole number of slow poll intervals so that every publish replaces
+ * a data poll (a transmission restarts the OpenThread keep-alive timer). Other builds return the period unchanged.
+ *
+ * @param[in] requested_ms Desired sample period.
+ *
+ * @return Sample period to use.
+ */
+uint32_t align_sample_period(uint32_t requested_ms);
+
+/** Check the ICD configuration against the sample period
+ *
+ * Warns when check-ins would wake the radio independently of the publishes.
+ *
+ * @param[in] sample_period_ms Sample period returned by `align_sample_period()`.
+ */
+void check_configuration(uint32_t sample_period_ms);
+
+/** Register the `icd` console commands
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t register_commands();
+
+} // namespace icd_schedule
@@ -0,0 +1,143 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <icd-timeline.h>
+
+#include <algorithm>
+#include <inttypes.h>
+
+namespace icd_timeline {
+
+/* Approximate radio-on time of a single operation on an 802.15.4 SED: a data poll is the data request, its ack and
+ * the short receive window for a pending frame; a transmission adds CSMA backoff and the wait for the MAC ack. */
+static const uint32_t k_poll_radio_ms = 4;
+static const uint32_t k_tx_radio_ms = 8;
+
+static const uint64_t k_never = UINT64_MAX;
+
+uint32_t align_period(uint32_t requested_ms, uint32_t slow_poll_ms)
+{
+    uint32_t polls = (requested_ms + slow_poll_ms - 1) / slow_poll_ms;
+    return std::max<uint32_t>(polls, 1) * slow_poll_ms;
+}
+
+void build_profiles(uint32_t publish_period_ms, const icd_timing_t &timing, profile_t *profiles)
+{
+    uint32_t aligned_period_ms = align_period(publish_period_ms, timing.slow_poll_ms);
+    uint32_t aligned_check_in_ms = std::max<uint32_t>(timing.idle_mode_ms / aligned_period_ms, 1) * aligned_period_ms;
+
+    profiles[0] = {
+        .name = "router",
+        .rx_always_on = true,
+        .publish_period_ms = publish_period_ms,
+        .publish_phase_ms = 0,
+        .slow_poll_ms = 0,
+        .fast_poll_ms = 0,
+        .active_threshold_ms = 0,
+        .check_in_period_ms = 0,
+        .check_in_phase_ms = 0,
+    };
+
+    profiles[1] = {
+        .name = "sed-independent",
+        .rx_always_on = false,
+        .publish_period_ms = publish_period_ms,
+        .publish_phase_ms = timing.slow_poll_ms / 2,
+        .slow_poll_ms = timing.slow_poll_ms,
+        .fast_poll_ms = timing.fast_poll_ms,
+        .active_threshold_ms = timing.active_threshold_ms,
+        .check_in_period_ms = timing.idle_mode_ms,
+        .check_in_phase_ms = timing.idle_mode_ms / 3,
+    };
+
+    profiles[2] = {
+        .name = "icd-aligned",
+        .rx_always_on = false,
+        .publish_period_ms = aligned_period_ms,
+        .publish_phase_ms = 0,
+        .slow_poll_ms = timing.slow_poll_ms,
+        .fast_poll_ms = timing.fast_poll_ms,
+        .active_threshold_ms = timing.active_threshold_ms,
+        .check_in_period_ms = aligned_check_in_ms,
+        .check_in_phase_ms = 0,
+    };
+}
+
+uint64_t simulate_radio_on_ms(const profile_t &profile, uint64_t horizon_ms)
+{
+    if (profile.rx_always_on) {
+        return horizon_ms;
+    }
+
+    uint64_t next_publish = profile.publish_period_ms ? profile.publish_phase_ms : k_never;
+    uint64_t next_check_in = profile.check_in_period_ms ? profile.check_in_phase_ms : k_never;
+    uint64_t next_poll = profile.slow_poll_ms;
+    uint64_t next_fast_poll = k_never;
+    uint64_t active_until = 0;
+
+    /* Wake windows are merged as they are produced, events come out in time order */
+    uint64_t radio_on_ms = 0;
+    uint64_t window_start = 0;
+    uint64_t window_end = 0;
+
+    auto wake = [&](uint64_t start, uint32_t duration_ms) {
+        if (start > window_end) {
+            radio_on_ms += window_end - window_start;
+            window_start = start;
+        }
+        window_end = std::max(window_end, start + duration_ms);
+    };
+
+    /* Any frame sent by the SED restarts the OpenThread keep-alive (poll) timer and puts the ICD in active mode */
+    auto transmit = [&](uint64_t t) {
+        wake(t, k_tx_radio_ms);
+        next_poll = t + profile.slow_poll_ms;
+        active_until = t + profile.active_threshold_ms;
+        next_fast_poll = profile.fast_poll_ms < profile.active_threshold_ms ? t + profile.fast_poll_ms : k_never;
+    };
+
+    while (true) {
+        uint64_t t = std::min(std::min(next_publish, next_check_in), std::min(next_poll, next_fast_poll));
+        if (t >= horizon_ms) {
+            break;
+        }
+
+        if (t == next_publish) {
+            transmit(t);
+            next_publish += profile.publish_period_ms;
+        } else if (t == next_check_in) {
+            transmit(t);
+            next_check_in += profile.check_in_period_ms;
+        } else if (t == next_fast_poll) {
+            wake(t, k_poll_radio_ms);
+            next_poll = t + profile.slow_poll_ms;
+            next_fast_poll = t + profile.fast_poll_ms < active_until ? t + profile.fast_poll_ms : k_never;
+        } else {
+            wake(t, k_poll_radio_ms);
+            next_poll = t + profile.slow_poll_ms;
+        }
+    }
+    radio_on_ms += std::min(window_end, horizon_ms) - std::min(window_start, horizon_ms);
+
+    return radio_on_ms;
+}
+
+void print_hour(FILE *out, const profile_t *profiles, size_t count, const char *line_end)
+{
+    const uint64_t hour_ms = 3600ULL * 1000;
+    fprintf(out, "profile,publish_ms,slow_poll_ms,check_in_ms,radio_on_ms_per_hour,duty_permille%s", line_end);
+    for (size_t i = 0; i < count; i++) {
+        const profile_t &profile = profiles[i];
+        uint64_t on_ms = simulate_radio_on_ms(profile, hour_ms);
+        fprintf(out, "%s,%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu64 ",%" PRIu64 "%s", profile.name,
+                profile.publish_period_ms, profile.slow_poll_ms, profile.check_in_period_ms, on_ms,
+                on_ms * 1000 / hour_ms, line_end);
+    }
+}
+
+} // namespace icd_timeline
@@ -0,0 +1,78 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/** Radio-on time of the power profiles, simulated
+ *
+ * Pure computation with no ESP-IDF or CHIP dependency: `matter esp icd timeline` runs it on the device with the
+ * configured ICD timing, and `icd-timeline-test` on the host.
+ */
+namespace icd_timeline {
+
+/** Radio timing of one power profile */
+typedef struct {
+    const char *name;
+    bool rx_always_on;              /* Router-capable node: receiver never sleeps */
+    uint32_t publish_period_ms;     /* Sample publish period */
+    uint32_t publish_phase_ms;      /* Offset of the first publish from t = 0 */
+    uint32_t slow_poll_ms;          /* Idle data poll period */
+    uint32_t fast_poll_ms;          /* Data poll period while in active mode */
+    uint32_t active_threshold_ms;   /* Time spent in active mode after any transmission */
+    uint32_t check_in_period_ms;    /* Check-in message period, 0 if none */
+    uint32_t check_in_phase_ms;     /* Offset of the first check-in from t = 0 */
+} profile_t;
+
+/** ICD server timing the profiles are built from */
+typedef struct {
+    uint32_t slow_poll_ms;
+    uint32_t fast_poll_ms;
+    uint32_t idle_mode_ms;
+    uint32_t active_threshold_ms;
+} icd_timing_t;
+
+/** Profiles built by `build_profiles()`, from most to least radio-on time */
+static constexpr size_t k_profile_count = 3;
+
+/** Round a sample period up to a whole number of slow poll intervals, at least one */
+uint32_t align_period(uint32_t requested_ms, uint32_t slow_poll_ms);
+
+/** Build the compared profiles for a publish period
+ *
+ * - router: what the app does today on Thread, a router-capable node with the receiver always on.
+ * - sed-independent: sleepy end device where sampling, polling and check-ins each keep their own timer.
+ * - icd-aligned: ICD with publishes on the poll grid and check-ins on a publish.
+ *
+ * @param[in] publish_period_ms Requested sample period.
+ * @param[in] timing ICD timing.
+ * @param[out] profiles `k_profile_count` profiles.
+ */
+void build_profiles(uint32_t publish_period_ms, const icd_timing_t &timing, profile_t *profiles);
+
+/** Simulate the radio-on time of a profile
+ *
+ * Runs a discrete event simulation of polls, publishes, check-ins and the active-mode fast polling that follows each
+ * transmission. Overlapping wake windows are counted once.
+ *
+ * @param[in] profile Profile to simulate.
+ * @param[in] horizon_ms Simulated time span.
+ *
+ * @return Total radio-on time in milliseconds over the horizon.
+ */
+uint64_t simulate_radio_on_ms(const profile_t &profile, uint64_t horizon_ms);
+
+/** Simulate one hour of each profile and print
+ * `profile,publish_ms,slow_poll_ms,check_in_ms,radio_on_ms_per_hour,duty_permille` lines, after a header
+ */
+void print_hour(FILE *out, const profile_t *profiles, size_t count, const char *line_end);
+
+} // namespace icd_timeline
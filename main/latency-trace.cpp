@@ -0,0 +1,244 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <latency-trace.h>
+
+#include <esp_log.h>
+#ifdef ESP_PLATFORM
+#include <esp_matter_console.h>
+#endif
+#include <freertos/FreeRTOS.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <app-common/zap-generated/ids/Attributes.h>
+#include <app-common/zap-generated/ids/Clusters.h>
+#include <app/AttributeAccessInterface.h>
+#include <app/AttributeAccessInterfaceRegistry.h>
+
+#include <virtual-clock.h>
+
+#ifdef ESP_PLATFORM
+using namespace esp_matter;
+#endif
+using namespace chip::app;
+using namespace chip::app::Clusters;
+
+namespace latency_trace {
+
+static const char *TAG = "latency_trace";
+
+static const char *const k_stage_names[STAGE_MAX] = {"filter", "publish", "report", "total"};
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static stats_t s_stats;
+
+/* Under s_lock too: samples are filtered in the esp_timer task, published there or in the Matter event loop, and
+ * encoded in the event loop */
+static int64_t s_filtered_us;
+static int64_t s_filtered_read_us;     /* Stamp of the sample s_filtered_us belongs to */
+static int64_t s_current_read_us;      /* Stamp of the value in the data model, 0 before the first publish */
+static int64_t s_current_published_us;
+static bool s_current_reported;
+
+static void record_locked(stage_t stage, int64_t duration_us)
+{
+    stage_stats_t *stats = &s_stats.stages[stage];
+    if (stats->count == 0 || duration_us < stats->min_us) {
+        stats->min_us = duration_us;
+    }
+    if (stats->count == 0 || duration_us > stats->max_us) {
+        stats->max_us = duration_us;
+    }
+    stats->count++;
+    stats->sum_us += duration_us;
+    size_t bucket = 0;
+    while (bucket < k_bucket_count - 1 && duration_us > k_bucket_limits_us[bucket]) {
+        bucket++;
+    }
+    stats->buckets[bucket]++;
+}
+
+static void on_encoded()
+{
+    int64_t now_us = virtual_clock::now_us();
+    portENTER_CRITICAL(&s_lock);
+    if (s_current_published_us == 0) {
+        portEXIT_CRITICAL(&s_lock);
+        return;
+    }
+    int64_t age_us = now_us - s_current_read_us;
+    record_locked(STAGE_REPORT, now_us - s_current_published_us);
+    record_locked(STAGE_TOTAL, age_us);
+    if (!s_current_reported) {
+        s_stats.first_reports++;
+    }
+    s_current_reported = true;
+    portEXIT_CRITICAL(&s_lock);
+    ESP_LOGD(TAG, "CO2 encoded %" PRId64 " us after its I2C read", age_us);
+}
+
+/* Sits in front of the cluster's own AttributeAccessInterface, if any, and sees every MeasuredValue the report
+ * engine encodes */
+class TraceAttrAccess : public AttributeAccessInterface {
+public:
+    TraceAttrAccess(chip::EndpointId endpoint_id, AttributeAccessInterface *inner)
+        : AttributeAccessInterface(chip::MakeOptional(endpoint_id), CarbonDioxideConcentrationMeasurement::Id),
+          mInner(inner)
+    {
+    }
+
+    CHIP_ERROR Read(const ConcreteReadAttributePath &aPath, AttributeValueEncoder &aEncoder) override
+    {
+        /* Without an inner interface nothing is encoded here and the value comes from attribute storage */
+        CHIP_ERROR err = mInner ? mInner->Read(aPath, aEncoder) : CHIP_NO_ERROR;
+        if (err == CHIP_NO_ERROR &&
+            aPath.mAttributeId == CarbonDioxideConcentrationMeasurement::Attributes::MeasuredValue::Id) {
+            on_encoded();
+        }
+        return err;
+    }
+
+    CHIP_ERROR Write(const ConcreteDataAttributePath &aPath, AttributeValueDecoder &aDecoder) override
+    {
+        return mInner ? mInner->Write(aPath, aDecoder) : CHIP_NO_ERROR;
+    }
+
+private:
+    AttributeAccessInterface *mInner;
+};
+
+esp_err_t init(uint16_t endpoint_id)
+{
+    AttributeAccessInterfaceRegistry &registry = AttributeAccessInterfaceRegistry::Instance();
+    AttributeAccessInterface *inner = registry.Get(endpoint_id, CarbonDioxideConcentrationMeasurement::Id);
+    if (inner != nullptr) {
+        registry.Unregister(inner);
+    }
+    static TraceAttrAccess s_access(endpoint_id, inner);
+    if (!registry.Register(&s_access)) {
+        if (inner != nullptr) {
+            registry.Register(inner);
+        }
+        ESP_LOGE(TAG, "Failed to register the CO2 attribute access wrapper");
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+void on_filtered(const measurement_pipeline::result_t &result)
+{
+    int64_t now_us = virtual_clock::now_us();
+    portENTER_CRITICAL(&s_lock);
+    s_filtered_us = now_us;
+    s_filtered_read_us = result.read_time_us;
+    record_locked(STAGE_FILTER, now_us - result.read_time_us);
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void on_published(const measurement_pipeline::result_t &result)
+{
+    int64_t now_us = virtual_clock::now_us();
+    portENTER_CRITICAL(&s_lock);
+    /* A newer sample may have been filtered meanwhile; the publish stage is only known for the latest */
+    if (s_filtered_read_us == result.read_time_us) {
+        record_locked(STAGE_PUBLISH, now_us - s_filtered_us);
+    }
+    s_current_read_us = result.read_time_us;
+    s_current_published_us = now_us;
+    s_current_reported = false;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void get_stats(stats_t *stats)
+{
+    portENTER_CRITICAL(&s_lock);
+    *stats = s_stats;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void reset()
+{
+    portENTER_CRITICAL(&s_lock);
+    memset(&s_stats, 0, sizeof(s_stats));
+    portEXIT_CRITICAL(&s_lock);
+}
+
+#ifdef ESP_PLATFORM
+static esp_err_t latency_stats_handler(int argc, char **argv)
+{
+    static stats_t stats;
+    get_stats(&stats);
+    printf("stage,count,min_us,avg_us,max_us\r\n");
+    for (int stage = 0; stage < STAGE_MAX; stage++) {
+        const stage_stats_t *s = &stats.stages[stage];
+        printf("%s,%" PRIu32 ",%" PRId64 ",%" PRId64 ",%" PRId64 "\r\n", k_stage_names[stage], s->count, s->min_us,
+               s->count ? s->sum_us / s->count : 0, s->max_us);
+    }
+    printf("first_reports,%" PRIu32 "\r\n", stats.first_reports);
+    printf("bucket_le_us,%s,%s,%s,%s\r\n", k_stage_names[0], k_stage_names[1], k_stage_names[2], k_stage_names[3]);
+    for (size_t bucket = 0; bucket < k_bucket_count; bucket++) {
+        if (bucket < k_bucket_count - 1) {
+            printf("%" PRId64, k_bucket_limits_us[bucket]);
+        } else {
+            printf("inf");
+        }
+        for (int stage = 0; stage < STAGE_MAX; stage++) {
+            printf(",%" PRIu32, stats.stages[stage].buckets[bucket]);
+        }
+        printf("\r\n");
+    }
+    return ESP_OK;
+}
+
+static esp_err_t latency_reset_handler(int argc, char **argv)
+{
+    reset();
+    return ESP_OK;
+}
+
+static console::engine latency_console;
+
+static esp_err_t latency_dispatch(int argc, char **argv)
+{
+    if (argc <= 0) {
+        latency_console.for_each_command(console::print_description, NULL);
+        return ESP_OK;
+    }
+    return latency_console.exec_command(argc, argv);
+}
+
+esp_err_t register_commands()
+{
+    static const console::command_t command = {
+        .name = "latency",
+        .description = "Sample-to-report latency. Usage: matter esp latency <stats|reset>.",
+        .handler = latency_dispatch,
+    };
+
+    static const console::command_t latency_commands[] = {
+        {
+            .name = "stats",
+            .description = "Print the per-stage latency of CO2 samples and their histograms as CSV",
+            .handler = latency_stats_handler,
+        },
+        {
+            .name = "reset",
+            .description = "Clear the latency figures",
+            .handler = latency_reset_handler,
+        },
+    };
+    latency_console.register_commands(latency_commands, sizeof(latency_commands) / sizeof(console::command_t));
+
+    return console::add_commands(&command, 1);
+}
+#endif
+
+} // namespace latency_trace
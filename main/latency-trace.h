@@ -0,0 +1,88 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <esp_err.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <measurement-pipeline.h>
+
+/** Age of the CO2 value at each stage between the sensor and the subscribers
+ *
+ * Every sample is stamped when its I2C read completes; the stamp travels in `measurement_pipeline::result_t`. The
+ * tracer notes when the filtered value is ready and when it is published, and wraps the AttributeAccessInterface of
+ * the CO2 concentration cluster (forwarding to the cluster instance's own one, if any) so it sees the report engine
+ * encode MeasuredValue. Each encode is a report, or a read, that carries the value published last; its age from the
+ * I2C read goes into a histogram.
+ */
+namespace latency_trace {
+
+/** Stages of a sample, each measured from the previous one */
+typedef enum {
+    STAGE_FILTER = 0, /* I2C read complete to filtered value ready */
+    STAGE_PUBLISH,    /* Filtered to published in the data model */
+    STAGE_REPORT,     /* Published to encoded in a report */
+    STAGE_TOTAL,      /* I2C read complete to encoded in a report */
+    STAGE_MAX,
+} stage_t;
+
+/** Upper bounds of the histogram buckets in microseconds; a last bucket holds everything above */
+static constexpr int64_t k_bucket_limits_us[] = {1000,   2000,    5000,    10000,   20000,   50000,   100000,
+                                                 200000, 500000, 1000000, 2000000, 5000000, 10000000, 60000000};
+static constexpr size_t k_bucket_count = sizeof(k_bucket_limits_us) / sizeof(k_bucket_limits_us[0]) + 1;
+
+/** Figures of one stage */
+typedef struct {
+    uint32_t count;
+    int64_t min_us;
+    int64_t max_us;
+    int64_t sum_us;
+    uint32_t buckets[k_bucket_count];
+} stage_stats_t;
+
+/** Tracer figures */
+typedef struct {
+    stage_stats_t stages[STAGE_MAX];
+    uint32_t first_reports;  /* Encodes that were the first for their sample, i.e. the change reports */
+} stats_t;
+
+/** Wrap the CO2 concentration cluster's attribute access on the sensor endpoint
+ *
+ * Must be called after `attribute_publisher::init()` so the cluster instance's AttributeAccessInterface, if the
+ * policy creates one, is already registered.
+ *
+ * @return ESP_OK on success.
+ * @return ESP_FAIL if the wrapper could not be registered.
+ */
+esp_err_t init(uint16_t endpoint_id);
+
+/** Note that the pipeline produced `result`; call right after `measurement_pipeline::process()`, from any task */
+void on_filtered(const measurement_pipeline::result_t &result);
+
+/** Note that `result` is now in the data model; call right after `attribute_publisher::publish()`, from any task */
+void on_published(const measurement_pipeline::result_t &result);
+
+/** Copy the figures */
+void get_stats(stats_t *stats);
+
+/** Clear the figures */
+void reset();
+
+#ifdef ESP_PLATFORM
+/** Register the `latency` console commands
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t register_commands();
+#endif
+
+} // namespace latency_trace
@@ -0,0 +1,75 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <measurement-pipeline.h>
+#include <sample-filter.h>
+
+#include <sdkconfig.h>
+
+namespace measurement_pipeline {
+
+#if CONFIG_SENSOR_FILTER
+#if CONFIG_SENSOR_FILTER_KALMAN
+using co2_kalman_t = sample_filter::Kalman<CONFIG_SENSOR_FILTER_KALMAN_PROCESS_NOISE,
+                                           CONFIG_SENSOR_FILTER_KALMAN_MEASUREMENT_NOISE>;
+#else
+using co2_kalman_t = sample_filter::Passthrough;
+#endif
+using co2_filter_t = sample_filter::Chain<
+    sample_filter::Optional<(CONFIG_SENSOR_FILTER_OUTLIER_PPM > 0),
+                            sample_filter::OutlierReject<CONFIG_SENSOR_FILTER_OUTLIER_PPM>>,
+    sample_filter::Optional<(CONFIG_SENSOR_FILTER_MEDIAN_WINDOW > 1),
+                            sample_filter::Median<CONFIG_SENSOR_FILTER_MEDIAN_WINDOW>>,
+    co2_kalman_t,
+    sample_filter::Optional<(CONFIG_SENSOR_FILTER_EMA_SHIFT > 0), sample_filter::Ema<CONFIG_SENSOR_FILTER_EMA_SHIFT>>>;
+#else
+using co2_filter_t = sample_filter::Passthrough;
+#endif
+
+static co2_filter_t s_co2_filter;
+
+air_quality_t classify(uint16_t co2_ppm)
+{
+    /* The thresholds are arbitrary; only good to poor are used, the cluster features for the other levels are off */
+    if (co2_ppm <= 1000) {
+        return AIR_QUALITY_GOOD;
+    }
+    if (co2_ppm <= 2500) {
+        return AIR_QUALITY_FAIR;
+    }
+    if (co2_ppm <= 5000) {
+        return AIR_QUALITY_MODERATE;
+    }
+    return AIR_QUALITY_POOR;
+}
+
+void process(const scd4x_measurement_raw_t *raw, int64_t read_time_us, result_t *result)
+{
+    process_converted(scd4x_signal_co2_concentration(raw->co2_concentration),
+                      scd4x_signal_temperature(raw->temperature),
+                      scd4x_signal_relative_humidity(raw->relative_humidity), read_time_us, result);
+}
+
+void process_converted(uint16_t co2_ppm, int32_t temperature_m_deg_c, int32_t humidity_m_percent_rh,
+                       int64_t read_time_us, result_t *result)
+{
+    result->co2_raw_ppm = co2_ppm;
+    /* Every filter stage outputs a value between its inputs, so the result stays in uint16_t range */
+    result->co2_ppm = (uint16_t)s_co2_filter.Process(co2_ppm);
+    result->temperature_m_deg_c = temperature_m_deg_c;
+    result->humidity_m_percent_rh = humidity_m_percent_rh;
+    result->air_quality = classify(result->co2_ppm);
+    result->read_time_us = read_time_us;
+}
+
+void reset()
+{
+    s_co2_filter.Reset();
+}
+
+} // namespace measurement_pipeline
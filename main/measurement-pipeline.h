@@ -0,0 +1,70 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include "drivers/scd4x_i2c.h"
+
+/** Raw SCD4x words to published values
+ *
+ * Conversion, filtering and AirQuality classification, with no bus, timer or Matter access, so the exact code that
+ * runs on target can be fed recorded traces anywhere.
+ */
+namespace measurement_pipeline {
+
+/** AirQuality cluster levels used by the classifier, numerically equal to the cluster enum */
+typedef enum {
+    AIR_QUALITY_UNKNOWN = 0,
+    AIR_QUALITY_GOOD = 1,
+    AIR_QUALITY_FAIR = 2,
+    AIR_QUALITY_MODERATE = 3,
+    AIR_QUALITY_POOR = 4,
+} air_quality_t;
+
+/** Values derived from one sample */
+typedef struct {
+    uint16_t co2_raw_ppm;          /* CO2 before filtering, drives the sampling policy */
+    uint16_t co2_ppm;              /* CO2 after the filter chain, published */
+    int32_t temperature_m_deg_c;
+    int32_t humidity_m_percent_rh;
+    air_quality_t air_quality;     /* Classification of co2_ppm, published */
+    int64_t read_time_us;          /* When the I2C read of the newest sample in co2_ppm completed */
+} result_t;
+
+/** Run one raw sample through the pipeline
+ *
+ * Filter state carries over from call to call, so samples must be passed in acquisition order.
+ *
+ * @param[in] raw Raw measurement words as read from the sensor.
+ * @param[in] read_time_us Time the read completed, carried into the result so later stages can tell its age.
+ * @param[out] result Converted, filtered and classified values.
+ */
+void process(const scd4x_measurement_raw_t *raw, int64_t read_time_us, result_t *result);
+
+/** Run one sample whose words are already converted through the pipeline
+ *
+ * Same as process() for samples converted in bulk with scd4x_convert_measurements(), e.g. a whole trace at once.
+ *
+ * @param[in] co2_ppm Converted CO2 concentration, before filtering.
+ * @param[in] temperature_m_deg_c Converted temperature.
+ * @param[in] humidity_m_percent_rh Converted relative humidity.
+ * @param[in] read_time_us Time the read completed.
+ * @param[out] result Filtered and classified values.
+ */
+void process_converted(uint16_t co2_ppm, int32_t temperature_m_deg_c, int32_t humidity_m_percent_rh,
+                       int64_t read_time_us, result_t *result);
+
+/** AirQuality level for a CO2 concentration */
+air_quality_t classify(uint16_t co2_ppm);
+
+/** Forget the filter history, e.g. before replaying another trace */
+void reset();
+
+} // namespace measurement_pipeline
@@ -0,0 +1,368 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <pressure-compensation.h>
+#include <sensor-bus.h>
+#include <sensor-config.h>
+
+#include <esp_log.h>
+#include <esp_matter_console.h>
+#include <freertos/FreeRTOS.h>
+#include <sdkconfig.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#if CONFIG_SENSOR_PRESSURE_SOURCE_MATTER
+#include <app-common/zap-generated/cluster-objects.h>
+#include <app/ReadClient.h>
+#include <esp_matter_client.h>
+#endif
+
+#include "drivers/sensirion_common.h"
+#include "drivers/sensirion_i2c_hal.h"
+
+static const char *TAG = "pressure_comp";
+
+using namespace esp_matter;
+
+namespace pressure_compensation {
+
+/* Input range of scd4x_set_ambient_pressure() */
+static const uint32_t k_min_pressure_pa = 70000;
+static const uint32_t k_max_pressure_pa = 120000;
+
+static stats_t s_stats;
+static uint32_t s_pending_pa = 0;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+#if CONFIG_SENSOR_PRESSURE_SOURCE_I2C
+/* ST LPS22HB / LPS22HH registers */
+static const uint8_t k_lps22_who_am_i = 0x0f;
+static const uint8_t k_lps22_ctrl_reg1 = 0x10;
+static const uint8_t k_lps22_press_out_xl = 0x28;
+static const uint8_t k_lps22hb_id = 0xb1;
+static const uint8_t k_lps22hh_id = 0xb3;
+/* ODR = 1 Hz, block data update */
+static const uint8_t k_lps22_ctrl_reg1_1hz_bdu = 0x12;
+
+static int16_t lps22_read_registers(uint8_t reg, uint8_t *data, uint8_t count)
+{
+    sensor_bus::lock();
+    int16_t error = sensirion_i2c_hal_write(CONFIG_SENSOR_PRESSURE_I2C_ADDRESS, &reg, 1);
+    if (error == NO_ERROR) {
+        error = sensirion_i2c_hal_read(CONFIG_SENSOR_PRESSURE_I2C_ADDRESS, data, count);
+    }
+    sensor_bus::unlock();
+    return error;
+}
+
+static esp_err_t barometer_init()
+{
+    uint8_t id = 0;
+    if (lps22_read_registers(k_lps22_who_am_i, &id, 1) != NO_ERROR) {
+        ESP_LOGE(TAG, "No barometer at 0x%02x", CONFIG_SENSOR_PRESSURE_I2C_ADDRESS);
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (id != k_lps22hb_id && id != k_lps22hh_id) {
+        ESP_LOGE(TAG, "Unexpected barometer id 0x%02x", id);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    const uint8_t ctrl[] = {k_lps22_ctrl_reg1, k_lps22_ctrl_reg1_1hz_bdu};
+    sensor_bus::lock();
+    int16_t error = sensirion_i2c_hal_write(CONFIG_SENSOR_PRESSURE_I2C_ADDRESS, ctrl, sizeof(ctrl));
+    sensor_bus::unlock();
+    if (error != NO_ERROR) {
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+/* Three bytes of two's complement pressure, 4096 LSB/hPa */
+static void barometer_poll()
+{
+    uint8_t raw[3];
+    if (lps22_read_registers(k_lps22_press_out_xl, raw, sizeof(raw)) != NO_ERROR) {
+        taskENTER_CRITICAL(&s_lock);
+        s_stats.source_errors++;
+        taskEXIT_CRITICAL(&s_lock);
+        return;
+    }
+    int32_t counts = (int32_t)(((uint32_t)raw[2] << 24) | ((uint32_t)raw[1] << 16) | ((uint32_t)raw[0] << 8)) >> 8;
+    set_source_pressure(counts > 0 ? (uint32_t)(((int64_t)counts * 100) >> 12) : 0);
+}
+#endif // CONFIG_SENSOR_PRESSURE_SOURCE_I2C
+
+#if CONFIG_SENSOR_PRESSURE_SOURCE_MATTER
+using namespace chip::app;
+using namespace chip::app::Clusters;
+
+/* Subscription to the MeasuredValue of a bound PressureMeasurement server */
+class PressureSubscription : public ReadClient::Callback
+{
+public:
+    bool IsActive() const { return mActive; }
+
+    void OnAttributeData(const ConcreteDataAttributePath &path, chip::TLV::TLVReader *data,
+                         const StatusIB &status) override
+    {
+        if (data == nullptr || !status.IsSuccess() || path.mClusterId != PressureMeasurement::Id ||
+            path.mAttributeId != PressureMeasurement::Attributes::MeasuredValue::Id) {
+            return;
+        }
+        PressureMeasurement::Attributes::MeasuredValue::TypeInfo::DecodableType value;
+        if (DataModel::Decode(*data, value) != CHIP_NO_ERROR || value.IsNull() || value.Value() <= 0) {
+            set_source_pressure(0);
+            return;
+        }
+        /* MeasuredValue is in units of 0.1 kPa */
+        set_source_pressure((uint32_t)value.Value() * 100);
+    }
+
+    void OnSubscriptionEstablished(chip::SubscriptionId subscription_id) override
+    {
+        ESP_LOGI(TAG, "Subscribed to remote pressure, id 0x%08" PRIx32, subscription_id);
+        mActive = true;
+    }
+
+    void OnError(CHIP_ERROR error) override
+    {
+        ESP_LOGW(TAG, "Remote pressure subscription error: %" CHIP_ERROR_FORMAT, error.Format());
+    }
+
+    void OnDone(ReadClient *client) override
+    {
+        mActive = false;
+        chip::Platform::Delete(client);
+    }
+
+private:
+    bool mActive = false;
+};
+
+/* Interval between attempts to (re)subscribe while no subscription is up */
+static const int64_t k_subscribe_retry_us = 60 * 1000000LL;
+
+static PressureSubscription s_subscription;
+static client::request_handle_t s_subscribe_request;
+static uint16_t s_endpoint_id = chip::kInvalidEndpointId;
+static int64_t s_last_subscribe_us = 0;
+static bool s_subscribe_attempted = false;
+
+static void binding_request_cb(client::peer_device_t *peer_device, client::request_handle_t *req_handle,
+                               void *priv_data)
+{
+    if (req_handle->type != client::SUBSCRIBE_ATTR) {
+        return;
+    }
+    esp_err_t err = client::interaction::subscribe::send_request(
+        peer_device, &req_handle->attribute_path, 1, nullptr, 0, CONFIG_SENSOR_PRESSURE_SUBSCRIBE_MIN_S,
+        CONFIG_SENSOR_PRESSURE_SUBSCRIBE_MAX_S, true, true, s_subscription);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to subscribe to remote pressure, err:%d", err);
+    }
+}
+
+/* Bindings are written by the commissioner some time after commissioning, so keep trying until one takes */
+static void subscribe_poll(int64_t timestamp_us)
+{
+    if (s_subscription.IsActive() ||
+        (s_subscribe_attempted && timestamp_us - s_last_subscribe_us < k_subscribe_retry_us)) {
+        return;
+    }
+    s_subscribe_attempted = true;
+    s_last_subscribe_us = timestamp_us;
+
+    s_subscribe_request.type = client::SUBSCRIBE_ATTR;
+    s_subscribe_request.attribute_path =
+        AttributePathParams(PressureMeasurement::Id, PressureMeasurement::Attributes::MeasuredValue::Id);
+    client::cluster_update(s_endpoint_id, &s_subscribe_request);
+}
+#endif // CONFIG_SENSOR_PRESSURE_SOURCE_MATTER
+
+esp_err_t init(endpoint_t *sensor_endpoint)
+{
+#if CONFIG_SENSOR_PRESSURE_SOURCE_I2C
+    return barometer_init();
+#elif CONFIG_SENSOR_PRESSURE_SOURCE_MATTER
+    cluster::binding::config_t binding_config;
+    if (cluster::binding::create(sensor_endpoint, &binding_config, CLUSTER_FLAG_SERVER) == nullptr ||
+        cluster::pressure_measurement::create(sensor_endpoint, nullptr, CLUSTER_FLAG_CLIENT) == nullptr) {
+        ESP_LOGE(TAG, "Failed to add the pressure binding");
+        return ESP_FAIL;
+    }
+    s_endpoint_id = endpoint::get_id(sensor_endpoint);
+    return client::set_request_callback(binding_request_cb, nullptr, nullptr);
+#else
+    return ESP_OK;
+#endif
+}
+
+void set_source_pressure(uint32_t pressure_pa)
+{
+    taskENTER_CRITICAL(&s_lock);
+    if (pressure_pa < k_min_pressure_pa || pressure_pa > k_max_pressure_pa) {
+        s_stats.source_errors++;
+    } else {
+        s_stats.source_pa = pressure_pa;
+        s_stats.source_updates++;
+        s_pending_pa = pressure_pa;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+void on_sample(int64_t timestamp_us)
+{
+#if CONFIG_SENSOR_PRESSURE_SOURCE_I2C
+    barometer_poll();
+#elif CONFIG_SENSOR_PRESSURE_SOURCE_MATTER
+    subscribe_poll(timestamp_us);
+#endif
+
+    taskENTER_CRITICAL(&s_lock);
+    uint32_t pending_pa = s_pending_pa;
+    uint32_t applied_pa = s_stats.applied_pa;
+    int64_t applied_at_us = s_stats.applied_at_us;
+    s_pending_pa = 0;
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (pending_pa == 0) {
+        return;
+    }
+
+    /* The first value always goes through; after that only changes above the threshold, at a bounded rate. A
+     * deferred value stays pending so the latest reading is applied once the interval has passed. */
+    bool skip_delta = applied_pa != 0 && (uint32_t)abs((int32_t)pending_pa - (int32_t)applied_pa) <
+        (uint32_t)CONFIG_SENSOR_PRESSURE_THRESHOLD_PA;
+    bool skip_rate = !skip_delta && applied_pa != 0 &&
+        timestamp_us - applied_at_us < (int64_t)CONFIG_SENSOR_PRESSURE_MIN_INTERVAL_S * 1000000;
+    if (skip_delta || skip_rate) {
+        taskENTER_CRITICAL(&s_lock);
+        if (skip_delta) {
+            s_stats.skipped_delta++;
+        } else {
+            s_stats.skipped_rate++;
+            if (s_pending_pa == 0) {
+                s_pending_pa = pending_pa;
+            }
+        }
+        taskEXIT_CRITICAL(&s_lock);
+        return;
+    }
+
+    esp_err_t err = sensor_config::set_ambient_pressure(pending_pa);
+    if (err == ESP_ERR_INVALID_STATE) {
+        /* A maintenance job owns the sensor; try again on a later sample */
+        taskENTER_CRITICAL(&s_lock);
+        if (s_pending_pa == 0) {
+            s_pending_pa = pending_pa;
+        }
+        taskEXIT_CRITICAL(&s_lock);
+        return;
+    }
+    if (err != ESP_OK) {
+        return;
+    }
+    ESP_LOGI(TAG, "Ambient pressure set to %" PRIu32 " Pa", pending_pa);
+
+    taskENTER_CRITICAL(&s_lock);
+    s_stats.applied_pa = pending_pa;
+    s_stats.applied_at_us = timestamp_us;
+    s_stats.pushes++;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+void on_sensor_reset()
+{
+    taskENTER_CRITICAL(&s_lock);
+    s_stats.applied_pa = 0;
+    s_stats.applied_at_us = 0;
+    if (s_pending_pa == 0) {
+        s_pending_pa = s_stats.source_pa;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+void get_stats(stats_t *stats)
+{
+    taskENTER_CRITICAL(&s_lock);
+    *stats = s_stats;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+static esp_err_t pressure_stats_handler(int argc, char **argv)
+{
+    stats_t stats;
+    get_stats(&stats);
+
+#if CONFIG_SENSOR_PRESSURE_SOURCE_I2C
+    printf("source,i2c\r\n");
+#elif CONFIG_SENSOR_PRESSURE_SOURCE_MATTER
+    printf("source,matter\r\n");
+#else
+    printf("source,none\r\n");
+#endif
+    printf("source_pa,%" PRIu32 "\r\n", stats.source_pa);
+    printf("applied_pa,%" PRIu32 "\r\n", stats.applied_pa);
+    printf("applied_at_us,%" PRId64 "\r\n", stats.applied_at_us);
+    printf("source_updates,%" PRIu32 "\r\n", stats.source_updates);
+    printf("pushes,%" PRIu32 "\r\n", stats.pushes);
+    printf("skipped_delta,%" PRIu32 "\r\n", stats.skipped_delta);
+    printf("skipped_rate,%" PRIu32 "\r\n", stats.skipped_rate);
+    printf("source_errors,%" PRIu32 "\r\n", stats.source_errors);
+    return ESP_OK;
+}
+
+/* Manual override, e.g. from a weather service; subject to the same threshold and rate limit */
+static esp_err_t pressure_set_handler(int argc, char **argv)
+{
+    if (argc != 1) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    set_source_pressure(strtoul(argv[0], NULL, 0));
+    return ESP_OK;
+}
+
+static console::engine pressure_console;
+
+static esp_err_t pressure_dispatch(int argc, char **argv)
+{
+    if (argc <= 0) {
+        pressure_console.for_each_command(console::print_description, NULL);
+        return ESP_OK;
+    }
+    return pressure_console.exec_command(argc, argv);
+}
+
+esp_err_t register_commands()
+{
+    static const console::command_t command = {
+        .name = "pressure",
+        .description = "Ambient pressure compensation. Usage: matter esp pressure <stats|set>.",
+        .handler = pressure_dispatch,
+    };
+
+    static const console::command_t pressure_commands[] = {
+        {
+            .name = "stats",
+            .description = "Print the source and applied pressure and the compensation counters",
+            .handler = pressure_stats_handler,
+        },
+        {
+            .name = "set",
+            .description = "Feed a pressure value. Usage: matter esp pressure set <pa>",
+            .handler = pressure_set_handler,
+        },
+    };
+    pressure_console.register_commands(pressure_commands, sizeof(pressure_commands) / sizeof(console::command_t));
+
+    return console::add_commands(&command, 1);
+}
+
+} // namespace pressure_compensation
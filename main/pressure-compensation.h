@@ -0,0 +1,78 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <esp_err.h>
+#include <esp_matter.h>
+
+#include <stdint.h>
+
+namespace pressure_compensation {
+
+/** Compensation counters */
+typedef struct {
+    uint32_t source_pa;       /* Last pressure read from the source, 0 if none yet */
+    uint32_t applied_pa;      /* Last pressure written to the SCD4x, 0 if none yet */
+    int64_t applied_at_us;    /* Time of that write, in virtual_clock microseconds */
+    uint32_t source_updates;  /* Pressure values received from the source */
+    uint32_t pushes;          /* Writes to the SCD4x */
+    uint32_t skipped_delta;   /* Updates dropped because the change was under the threshold */
+    uint32_t skipped_rate;    /* Updates deferred by the rate limit */
+    uint32_t source_errors;   /* Failed barometer reads or rejected values */
+} stats_t;
+
+/** Initialize the compensation stage
+ *
+ * Probes the barometer or adds the Binding cluster, depending on the configured pressure source. Until the first
+ * pressure value arrives the sensor compensates for its configured altitude.
+ *
+ * @param[in] sensor_endpoint Endpoint hosting the sensor clusters.
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t init(esp_matter::endpoint_t *sensor_endpoint);
+
+/** Run the compensation step after a measurement read
+ *
+ * Polls the barometer when it is the source, then writes the pressure to the SCD4x if it moved by more than the
+ * threshold and the last write is older than the minimum interval. Called right after a read, so the write lands in
+ * the idle part of the measurement interval and never delays a sample. Must be called from the Matter event loop.
+ *
+ * @param[in] timestamp_us Time of the measurement read, in virtual_clock microseconds.
+ */
+void on_sample(int64_t timestamp_us);
+
+/** Feed a pressure value from an external source
+ *
+ * Values outside the 70000 - 120000 Pa range accepted by the SCD4x are rejected. The value is applied on the next
+ * call to `on_sample()`.
+ *
+ * @param[in] pressure_pa Ambient pressure in Pa.
+ */
+void set_source_pressure(uint32_t pressure_pa);
+
+/** Forget the pressure written to the SCD4x
+ *
+ * Called after a factory reset or a reinit, which restore the sensor's default ambient pressure. Clears `applied_pa`
+ * and queues the last source value again, so the next `on_sample()` writes it whatever the threshold and rate limit.
+ */
+void on_sensor_reset();
+
+/** Copy the compensation counters */
+void get_stats(stats_t *stats);
+
+/** Register the `pressure` console commands
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t register_commands();
+
+} // namespace pressure_compensation
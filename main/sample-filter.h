@@ -0,0 +1,216 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <tuple>
+#include <type_traits>
+
+/** Fixed-point filter stages for raw sensor samples
+ *
+ * Every stage works on int32_t samples in the driver's fixed-point units (ppm, m°C, m%RH) and takes the same time for
+ * every sample: no stage loops over a variable amount of state. Stages are chained at build time with `Chain<...>`,
+ * and `Optional<enabled, Stage>` swaps a disabled stage for `Passthrough`, which the compiler removes entirely.
+ */
+namespace sample_filter {
+
+/** Does nothing; stands in for disabled stages */
+class Passthrough
+{
+public:
+    void Reset() {}
+    int32_t Process(int32_t sample) { return sample; }
+};
+
+/** Median of the last N samples
+ *
+ * The window is sorted with an odd-even transposition network, N rounds of branchless compare-exchange, so the cost
+ * only depends on N. The window is filled with the first sample, which keeps the warm-up constant-time as well.
+ */
+template <uint8_t N>
+class Median
+{
+    static_assert(N % 2 == 1 && N >= 3 && N <= 9, "median window must be odd, 3 to 9 samples");
+
+public:
+    void Reset() { mPrimed = false; }
+
+    int32_t Process(int32_t sample)
+    {
+        if (!mPrimed) {
+            for (uint8_t i = 0; i < N; i++) {
+                mWindow[i] = sample;
+            }
+            mHead = 0;
+            mPrimed = true;
+        }
+        mWindow[mHead] = sample;
+        mHead = mHead + 1 == N ? 0 : mHead + 1;
+
+        int32_t sorted[N];
+        for (uint8_t i = 0; i < N; i++) {
+            sorted[i] = mWindow[i];
+        }
+        for (uint8_t round = 0; round < N; round++) {
+            for (uint8_t i = round & 1; i + 1 < N; i += 2) {
+                CompareExchange(sorted[i], sorted[i + 1]);
+            }
+        }
+        return sorted[N / 2];
+    }
+
+private:
+    static void CompareExchange(int32_t &a, int32_t &b)
+    {
+        int32_t low = a < b ? a : b;
+        int32_t high = a < b ? b : a;
+        a = low;
+        b = high;
+    }
+
+    int32_t mWindow[N];
+    uint8_t mHead = 0;
+    bool mPrimed = false;
+};
+
+/** Exponential moving average with a weight of 1 / 2^kShift for the new sample
+ *
+ * The average is kept with kShift extra fractional bits so small changes are not lost to truncation.
+ */
+template <uint8_t kShift>
+class Ema
+{
+    static_assert(kShift >= 1 && kShift <= 8, "EMA shift must be 1 to 8");
+
+public:
+    void Reset() { mPrimed = false; }
+
+    int32_t Process(int32_t sample)
+    {
+        int64_t scaled = (int64_t)sample << kShift;
+        if (!mPrimed) {
+            mAverage = scaled;
+            mPrimed = true;
+        } else {
+            mAverage += (scaled - mAverage) >> kShift;
+        }
+        return (int32_t)((mAverage + (1 << (kShift - 1))) >> kShift);
+    }
+
+private:
+    int64_t mAverage = 0;
+    bool mPrimed = false;
+};
+
+/** Scalar Kalman filter for a slowly drifting level
+ *
+ * kProcessNoise and kMeasurementNoise are dimensionless: the steady-state gain only depends on their ratio, so the
+ * same pair works for every channel whatever its units. The gain and the error variance are Q16.
+ */
+template <uint16_t kProcessNoise, uint16_t kMeasurementNoise>
+class Kalman
+{
+    static_assert(kProcessNoise > 0, "process noise must be positive, the filter freezes on its first value at 0");
+    static_assert(kMeasurementNoise > 0, "measurement noise must be positive");
+
+public:
+    void Reset() { mPrimed = false; }
+
+    int32_t Process(int32_t sample)
+    {
+        if (!mPrimed) {
+            mEstimate = sample;
+            mVariance = (int64_t)kMeasurementNoise << kFracBits;
+            mPrimed = true;
+            return sample;
+        }
+        /* Predict: the level is constant, only its uncertainty grows */
+        mVariance += (int64_t)kProcessNoise << kFracBits;
+        /* Update: K = P / (P + R), x += K * (z - x), P = (1 - K) * P */
+        int64_t gain = (mVariance << kFracBits) / (mVariance + ((int64_t)kMeasurementNoise << kFracBits));
+        mEstimate += (gain * ((int64_t)sample - mEstimate) + (1 << (kFracBits - 1))) >> kFracBits;
+        mVariance = (((int64_t)1 << kFracBits) - gain) * mVariance >> kFracBits;
+        return (int32_t)mEstimate;
+    }
+
+private:
+    static constexpr uint8_t kFracBits = 16;
+
+    int64_t mEstimate = 0;
+    int64_t mVariance = 0;
+    bool mPrimed = false;
+};
+
+/** Drop isolated spikes
+ *
+ * A sample further than kMaxStep from the last accepted one is replaced by the last accepted one. After kMaxRejects
+ * consecutive rejections the new level is taken as a real step and accepted.
+ */
+template <int32_t kMaxStep, uint8_t kMaxRejects = 2>
+class OutlierReject
+{
+    static_assert(kMaxStep > 0, "outlier step must be positive");
+
+public:
+    void Reset() { mPrimed = false; }
+
+    int32_t Process(int32_t sample)
+    {
+        int64_t delta = (int64_t)sample - mLast;
+        bool outlier = mPrimed && (delta > kMaxStep || delta < -kMaxStep);
+        if (outlier && mRejects < kMaxRejects) {
+            mRejects++;
+            return mLast;
+        }
+        mRejects = 0;
+        mLast = sample;
+        mPrimed = true;
+        return sample;
+    }
+
+    /** Samples rejected in a row so far */
+    uint8_t Rejects() const { return mRejects; }
+
+private:
+    int32_t mLast = 0;
+    uint8_t mRejects = 0;
+    bool mPrimed = false;
+};
+
+/** `Stage` when `kEnabled`, otherwise a `Passthrough` that compiles away */
+template <bool kEnabled, typename Stage>
+using Optional = typename std::conditional<kEnabled, Stage, Passthrough>::type;
+
+/** Stages applied in order, each one's output feeding the next */
+template <typename... Stages>
+class Chain
+{
+public:
+    void Reset() { std::apply([](auto &...stage) { (stage.Reset(), ...); }, mStages); }
+
+    int32_t Process(int32_t sample)
+    {
+        std::apply([&sample](auto &...stage) { ((sample = stage.Process(sample)), ...); }, mStages);
+        return sample;
+    }
+
+    /** Access a stage, e.g. to read its counters */
+    template <size_t I>
+    auto &Stage()
+    {
+        return std::get<I>(mStages);
+    }
+
+private:
+    std::tuple<Stages...> mStages;
+};
+
+} // namespace sample_filter
@@ -0,0 +1,51 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <sample-path.h>
+
+#include <esp_log.h>
+
+#include <inttypes.h>
+
+#include <attribute-publisher.h>
+#include <latency-trace.h>
+#include <sensor-events.h>
+#include <sensor-history.h>
+#include <sensor-rollup.h>
+
+static const char *TAG = "sample_path";
+
+namespace sample_path {
+
+void on_read(const scd4x_measurement_raw_t &raw, int64_t read_time_us, measurement_pipeline::result_t *result)
+{
+    measurement_pipeline::process(&raw, read_time_us, result);
+    latency_trace::on_filtered(*result);
+    ESP_LOGI(TAG, "MEASUREMENTS: %d, %" PRId32 ", %" PRId32, result->co2_raw_ppm, result->temperature_m_deg_c,
+             result->humidity_m_percent_rh);
+
+    ESP_LOGI(TAG, "CO2: %d", result->co2_ppm);
+
+    if (!attribute_publisher::selected_policy_t::k_needs_stack_lock) {
+        attribute_publisher::publish(*result);
+        latency_trace::on_published(*result);
+    }
+}
+
+void on_event_loop(const measurement_pipeline::result_t &result)
+{
+    if (attribute_publisher::selected_policy_t::k_needs_stack_lock) {
+        attribute_publisher::publish(result);
+        latency_trace::on_published(result);
+    }
+    sensor_events::on_sample(result, result.read_time_us);
+    sensor_history::on_sample(result, result.read_time_us);
+    sensor_rollup::on_sample(result, result.read_time_us);
+}
+
+} // namespace sample_path
@@ -0,0 +1,40 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <measurement-pipeline.h>
+
+#include "drivers/scd4x_i2c.h"
+
+/** What a sample goes through once it is read, the same on the ESP32 and in the Linux build
+ *
+ * The target reads the sensor, stamps the read with `virtual_clock::now_us()` and hands the raw words to
+ * `on_read()` in the task that read them. `on_read()` filters the sample and publishes it if the selected publisher
+ * needs no CHIP stack lock. The target then gets the result to the Matter event loop and calls `on_event_loop()`
+ * there, which publishes it otherwise and feeds the events, the history and the rollups, in that order.
+ */
+namespace sample_path {
+
+/** Filter a sample that was just read, and publish it if that can be done without the CHIP stack lock
+ *
+ * @param[in] raw Measurement as read from the sensor.
+ * @param[in] read_time_us Time the read completed, in virtual_clock microseconds.
+ * @param[out] result Values to pass to `on_event_loop()`.
+ */
+void on_read(const scd4x_measurement_raw_t &raw, int64_t read_time_us, measurement_pipeline::result_t *result);
+
+/** Publish a sample if `on_read()` did not, then run the sensor events, history and rollups on it
+ *
+ * Must be called from the Matter event loop, in acquisition order; a sample may be skipped.
+ */
+void on_event_loop(const measurement_pipeline::result_t &result);
+
+} // namespace sample_path
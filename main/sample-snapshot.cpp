@@ -0,0 +1,320 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <sample-snapshot.h>
+
+#include <esp_log.h>
+#include <esp_matter.h>
+
+#include <atomic>
+#include <inttypes.h>
+
+#include <app-common/zap-generated/cluster-objects.h>
+#include <app-common/zap-generated/ids/Attributes.h>
+#include <app-common/zap-generated/ids/Clusters.h>
+#include <app/AttributeAccessInterface.h>
+#include <app/AttributeAccessInterfaceRegistry.h>
+#include <app/data-model/Nullable.h>
+#include <app/reporting/reporting.h>
+#include <platform/CHIPDeviceLayer.h>
+
+#include <seqlock.h>
+
+using namespace esp_matter;
+using namespace chip::app;
+using namespace chip::app::Clusters;
+
+namespace sample_snapshot {
+
+static const char *TAG = "sample_snapshot";
+
+/* The sensor endpoint and the scratch endpoint of `publisher bench` */
+static const size_t k_max_snapshots = 2;
+
+static const chip::ClusterId k_cluster_ids[] = {AirQuality::Id, CarbonDioxideConcentrationMeasurement::Id,
+                                                TemperatureMeasurement::Id, RelativeHumidityMeasurement::Id};
+static const size_t k_cluster_count = sizeof(k_cluster_ids) / sizeof(k_cluster_ids[0]);
+
+static int16_t temperature_centi_deg_c(const measurement_pipeline::result_t &result)
+{
+    return (int16_t)(result.temperature_m_deg_c / 10);
+}
+
+static uint16_t humidity_centi_percent(const measurement_pipeline::result_t &result)
+{
+    int32_t value = result.humidity_m_percent_rh / 10;
+    return (uint16_t)(value < 0 ? 0 : value > 10000 ? 10000 : value);
+}
+
+struct snapshot_t;
+
+static bool read(const snapshot_t &snapshot, measurement_pipeline::result_t *result);
+
+/* Serves the measured attribute of one cluster from the snapshot; every other attribute goes to the cluster's own
+ * AttributeAccessInterface, if any, or to attribute storage */
+class SnapshotAttrAccess : public AttributeAccessInterface {
+public:
+    SnapshotAttrAccess(const snapshot_t &snapshot, chip::EndpointId endpoint_id, chip::ClusterId cluster_id)
+        : AttributeAccessInterface(chip::MakeOptional(endpoint_id), cluster_id), mSnapshot(snapshot),
+          mClusterId(cluster_id)
+    {
+    }
+
+    AttributeAccessInterface *GetInner() const { return mInner; }
+    void SetInner(AttributeAccessInterface *inner) { mInner = inner; }
+
+    CHIP_ERROR Read(const ConcreteReadAttributePath &aPath, AttributeValueEncoder &aEncoder) override
+    {
+        if (aPath.mAttributeId != kMeasuredAttributeId) {
+            return mInner ? mInner->Read(aPath, aEncoder) : CHIP_NO_ERROR;
+        }
+        measurement_pipeline::result_t result;
+        bool have_sample = read(mSnapshot, &result);
+        switch (mClusterId) {
+        case AirQuality::Id:
+            return aEncoder.Encode(have_sample ? static_cast<AirQuality::AirQualityEnum>(result.air_quality)
+                                               : AirQuality::AirQualityEnum::kUnknown);
+        case CarbonDioxideConcentrationMeasurement::Id:
+            return have_sample ? aEncoder.Encode(chip::app::DataModel::MakeNullable((float)result.co2_ppm))
+                               : aEncoder.EncodeNull();
+        case TemperatureMeasurement::Id:
+            return have_sample ? aEncoder.Encode(chip::app::DataModel::MakeNullable(temperature_centi_deg_c(result)))
+                               : aEncoder.EncodeNull();
+        case RelativeHumidityMeasurement::Id:
+            return have_sample ? aEncoder.Encode(chip::app::DataModel::MakeNullable(humidity_centi_percent(result)))
+                               : aEncoder.EncodeNull();
+        default:
+            return CHIP_NO_ERROR;
+        }
+    }
+
+    CHIP_ERROR Write(const ConcreteDataAttributePath &aPath, AttributeValueDecoder &aDecoder) override
+    {
+        return mInner ? mInner->Write(aPath, aDecoder) : CHIP_NO_ERROR;
+    }
+
+private:
+    /* AirQuality and every MeasuredValue are attribute 0 of their cluster */
+    static_assert(AirQuality::Attributes::AirQuality::Id == 0 &&
+                      CarbonDioxideConcentrationMeasurement::Attributes::MeasuredValue::Id == 0 &&
+                      TemperatureMeasurement::Attributes::MeasuredValue::Id == 0 &&
+                      RelativeHumidityMeasurement::Attributes::MeasuredValue::Id == 0,
+                  "Measured attributes moved");
+    static constexpr chip::AttributeId kMeasuredAttributeId = 0;
+
+    const snapshot_t &mSnapshot;
+    chip::ClusterId mClusterId;
+    AttributeAccessInterface *mInner = nullptr;
+};
+
+struct snapshot_t {
+    explicit snapshot_t(uint16_t endpoint_id)
+        : endpoint_id(endpoint_id),
+          access{{*this, endpoint_id, k_cluster_ids[0]},
+                 {*this, endpoint_id, k_cluster_ids[1]},
+                 {*this, endpoint_id, k_cluster_ids[2]},
+                 {*this, endpoint_id, k_cluster_ids[3]}}
+    {
+    }
+
+    const uint16_t endpoint_id;
+    Seqlock<measurement_pipeline::result_t> seqlock;
+    std::atomic<bool> mark_pending{false};
+    SnapshotAttrAccess access[k_cluster_count];
+
+    /* Matter event loop only */
+    measurement_pipeline::result_t marked; /* Values the subscribers were last told about */
+    bool have_marked = false;
+};
+
+/* Set and cleared with the CHIP stack lock held; the writer of an endpoint only looks up its own */
+static std::atomic<snapshot_t *> s_snapshots[k_max_snapshots];
+
+static snapshot_t *find(uint16_t endpoint_id)
+{
+    for (std::atomic<snapshot_t *> &slot : s_snapshots) {
+        snapshot_t *snapshot = slot.load(std::memory_order_acquire);
+        if (snapshot != nullptr && snapshot->endpoint_id == endpoint_id) {
+            return snapshot;
+        }
+    }
+    return nullptr;
+}
+
+static esp_err_t add_missing_clusters(endpoint_t *sensor_endpoint)
+{
+    if (cluster::get(sensor_endpoint, TemperatureMeasurement::Id) == nullptr) {
+        cluster::temperature_measurement::config_t config;
+        config.min_measured_value = -1000; /* SCD4x operating range, in 0.01 °C */
+        config.max_measured_value = 6000;
+        if (cluster::temperature_measurement::create(sensor_endpoint, &config, CLUSTER_FLAG_SERVER) == nullptr) {
+            return ESP_FAIL;
+        }
+    }
+    if (cluster::get(sensor_endpoint, RelativeHumidityMeasurement::Id) == nullptr) {
+        cluster::relative_humidity_measurement::config_t config;
+        config.min_measured_value = 0;
+        config.max_measured_value = 10000;
+        if (cluster::relative_humidity_measurement::create(sensor_endpoint, &config, CLUSTER_FLAG_SERVER) == nullptr) {
+            return ESP_FAIL;
+        }
+    }
+    return ESP_OK;
+}
+
+static bool wrap(SnapshotAttrAccess *access, chip::EndpointId endpoint_id, chip::ClusterId cluster_id)
+{
+    AttributeAccessInterfaceRegistry &registry = AttributeAccessInterfaceRegistry::Instance();
+    AttributeAccessInterface *inner = registry.Get(endpoint_id, cluster_id);
+    if (inner != nullptr) {
+        registry.Unregister(inner);
+    }
+    access->SetInner(inner);
+    if (!registry.Register(access)) {
+        if (inner != nullptr) {
+            registry.Register(inner);
+        }
+        return false;
+    }
+    return true;
+}
+
+/* Undo `wrap()`, putting the cluster's own attribute access back */
+static void unwrap(SnapshotAttrAccess *access)
+{
+    AttributeAccessInterfaceRegistry &registry = AttributeAccessInterfaceRegistry::Instance();
+    registry.Unregister(access);
+    if (access->GetInner() != nullptr) {
+        registry.Register(access->GetInner());
+    }
+}
+
+esp_err_t init(uint16_t endpoint_id)
+{
+    endpoint_t *sensor_endpoint = endpoint::get(node::get(), endpoint_id);
+    if (sensor_endpoint == nullptr) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    std::atomic<snapshot_t *> *free_slot = nullptr;
+    for (std::atomic<snapshot_t *> &slot : s_snapshots) {
+        if (slot.load(std::memory_order_relaxed) == nullptr) {
+            free_slot = &slot;
+            break;
+        }
+    }
+    if (free_slot == nullptr) {
+        return ESP_ERR_NO_MEM;
+    }
+    esp_err_t err = add_missing_clusters(sensor_endpoint);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to add the temperature and humidity clusters");
+        return err;
+    }
+
+    snapshot_t *snapshot = new snapshot_t(endpoint_id);
+    for (size_t i = 0; i < k_cluster_count; i++) {
+        if (!wrap(&snapshot->access[i], endpoint_id, k_cluster_ids[i])) {
+            ESP_LOGE(TAG, "Failed to register the attribute access of cluster 0x%04" PRIx32, k_cluster_ids[i]);
+            while (i-- > 0) {
+                unwrap(&snapshot->access[i]);
+            }
+            delete snapshot;
+            return ESP_FAIL;
+        }
+    }
+    free_slot->store(snapshot, std::memory_order_release);
+    return ESP_OK;
+}
+
+void remove(uint16_t endpoint_id)
+{
+    for (std::atomic<snapshot_t *> &slot : s_snapshots) {
+        snapshot_t *snapshot = slot.load(std::memory_order_relaxed);
+        if (snapshot == nullptr || snapshot->endpoint_id != endpoint_id) {
+            continue;
+        }
+        slot.store(nullptr, std::memory_order_release);
+        for (SnapshotAttrAccess &access : snapshot->access) {
+            unwrap(&access);
+        }
+        /* A pending mark job looks the endpoint up again, and finds nothing */
+        delete snapshot;
+    }
+}
+
+static void mark(uint16_t endpoint_id, chip::ClusterId cluster_id, chip::AttributeId attribute_id)
+{
+    MatterReportingAttributeChangeCallback(endpoint_id, cluster_id, attribute_id);
+}
+
+static void mark_dirty_work(intptr_t arg)
+{
+    snapshot_t *snapshot = find((uint16_t)arg);
+    if (snapshot == nullptr) {
+        return;
+    }
+    /* Cleared before the read, so a write landing after it schedules another job */
+    snapshot->mark_pending.store(false, std::memory_order_relaxed);
+    measurement_pipeline::result_t result;
+    if (!read(*snapshot, &result)) {
+        return;
+    }
+    const measurement_pipeline::result_t &marked = snapshot->marked;
+    bool all = !snapshot->have_marked;
+    if (all || result.air_quality != marked.air_quality) {
+        mark(snapshot->endpoint_id, AirQuality::Id, AirQuality::Attributes::AirQuality::Id);
+    }
+    if (all || result.co2_ppm != marked.co2_ppm) {
+        mark(snapshot->endpoint_id, CarbonDioxideConcentrationMeasurement::Id,
+             CarbonDioxideConcentrationMeasurement::Attributes::MeasuredValue::Id);
+    }
+    if (all || temperature_centi_deg_c(result) != temperature_centi_deg_c(marked)) {
+        mark(snapshot->endpoint_id, TemperatureMeasurement::Id, TemperatureMeasurement::Attributes::MeasuredValue::Id);
+    }
+    if (all || humidity_centi_percent(result) != humidity_centi_percent(marked)) {
+        mark(snapshot->endpoint_id, RelativeHumidityMeasurement::Id,
+             RelativeHumidityMeasurement::Attributes::MeasuredValue::Id);
+    }
+    snapshot->marked = result;
+    snapshot->have_marked = true;
+}
+
+void write(uint16_t endpoint_id, const measurement_pipeline::result_t &result)
+{
+    snapshot_t *snapshot = find(endpoint_id);
+    if (snapshot == nullptr) {
+        return;
+    }
+    snapshot->seqlock.Write(result);
+    if (snapshot->mark_pending.exchange(true, std::memory_order_relaxed)) {
+        return;
+    }
+    if (chip::DeviceLayer::PlatformMgr().ScheduleWork(mark_dirty_work, endpoint_id) != CHIP_NO_ERROR) {
+        snapshot->mark_pending.store(false, std::memory_order_relaxed);
+    }
+}
+
+/* Never sleeps. Readers run in the Matter event loop and the writer in the esp_timer task, above it, so a reader never
+ * preempts a write on its own core, and a write on the other core is over within a few copies. */
+static bool read(const snapshot_t &snapshot, measurement_pipeline::result_t *result)
+{
+    while (!snapshot.seqlock.TryRead(result)) {
+        if (!snapshot.seqlock.Written()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool read(uint16_t endpoint_id, measurement_pipeline::result_t *result)
+{
+    snapshot_t *snapshot = find(endpoint_id);
+    return snapshot != nullptr && read(*snapshot, result);
+}
+
+} // namespace sample_snapshot
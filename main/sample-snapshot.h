@@ -0,0 +1,64 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <esp_err.h>
+
+#include <stdint.h>
+
+#include <measurement-pipeline.h>
+
+/** Latest sample, served to the data model on demand
+ *
+ * `write()` stores the sample in a seqlock and returns without taking the CHIP stack lock. AttributeAccessInterfaces
+ * registered for the AirQuality, CO2 concentration, temperature and relative humidity clusters of the endpoint read
+ * the snapshot whenever the report engine encodes a report or a read, so nothing is copied into attribute storage. To
+ * wake subscribers, each write schedules one job on the Matter event loop, unless one is still pending, which marks
+ * the attributes whose value changed since the last job dirty.
+ *
+ * Each endpoint has its own snapshot: the sensor endpoint, and the scratch endpoint `publisher bench` creates while it
+ * runs.
+ */
+namespace sample_snapshot {
+
+/** Register the attribute access for an endpoint, adding the temperature and humidity clusters if missing
+ *
+ * Clusters can only be added before the endpoint is enabled, i.e. before `esp_matter::start()` for the sensor
+ * endpoint. Must be called with the CHIP stack lock held once Matter runs.
+ *
+ * @return ESP_OK on success.
+ * @return ESP_ERR_NOT_FOUND if the endpoint does not exist.
+ * @return ESP_ERR_NO_MEM if every snapshot is taken.
+ * @return ESP_FAIL if a cluster or an attribute access interface could not be added.
+ */
+esp_err_t init(uint16_t endpoint_id);
+
+/** Unregister the attribute access of an endpoint and free its snapshot
+ *
+ * Must be called with the CHIP stack lock held, before the endpoint is destroyed.
+ */
+void remove(uint16_t endpoint_id);
+
+/** Store `result` as the latest sample of an endpoint
+ *
+ * Never blocks and never takes the CHIP stack lock, so it can be called from any task, but only from one per endpoint.
+ * Readers spin while a write is in flight, so the writer must not be preempted by the Matter task: write from a task
+ * of higher priority, like the esp_timer task the sample is read in, or with the CHIP stack lock held.
+ */
+void write(uint16_t endpoint_id, const measurement_pipeline::result_t &result);
+
+/** Copy the latest sample of an endpoint
+ *
+ * Spins, without sleeping, while a write is in flight.
+ *
+ * @return true if a sample was copied, false if none was written yet or the endpoint has no snapshot.
+ */
+bool read(uint16_t endpoint_id, measurement_pipeline::result_t *result);
+
+} // namespace sample_snapshot
@@ -0,0 +1,274 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <latency-trace.h>
+#include <sampling-policy.h>
+#include <sensor-maintenance.h>
+#include <sensor-scheduler.h>
+#include <slope-estimator.h>
+
+#include <app-common/zap-generated/ids/Clusters.h>
+#include <app/InteractionModelEngine.h>
+#include <app/ReadHandler.h>
+#include <esp_log.h>
+#include <esp_matter_console.h>
+#include <freertos/FreeRTOS.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "drivers/scd4x_i2c.h"
+#include "drivers/sensirion_common.h"
+
+static const char *TAG = "sampling_policy";
+
+using namespace esp_matter;
+using namespace chip::app;
+using namespace chip::app::Clusters;
+
+namespace sampling_policy {
+
+/* Measurement interval of the SCD4x low-power periodic mode */
+static const uint32_t k_low_power_interval_ms = 30000;
+
+static chip::EndpointId s_endpoint_id = chip::kInvalidEndpointId;
+static uint32_t s_fast_period_ms = 0;
+static uint32_t s_idle_period_ms = 0;
+static uint32_t s_low_power_period_ms = 0;
+static bool s_has_last_co2 = false;
+static uint16_t s_last_co2_ppm = 0;
+static SlopeEstimator s_slope(CONFIG_SENSOR_SLOPE_WINDOW);
+static acquisition_profile_t s_profile = ACQUISITION_PERIODIC;
+static int64_t s_last_movement_us = 0;
+/* latency_trace first_reports at the previous sample */
+static uint32_t s_last_first_reports = 0;
+static stats_t s_stats;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static bool is_sensor_cluster(chip::ClusterId cluster_id)
+{
+    return cluster_id == CarbonDioxideConcentrationMeasurement::Id || cluster_id == AirQuality::Id ||
+        cluster_id == TemperatureMeasurement::Id || cluster_id == RelativeHumidityMeasurement::Id;
+}
+
+static bool covers_sensor(const ReadHandler *handler)
+{
+    for (auto *node = handler->GetAttributePathList(); node != nullptr; node = node->mpNext) {
+        const AttributePathParams &path = node->mValue;
+        if (!path.HasWildcardEndpointId() && path.mEndpointId != s_endpoint_id) {
+            continue;
+        }
+        if (path.HasWildcardClusterId() || is_sensor_cluster(path.mClusterId)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Walk the active subscriptions and find the shortest max-interval among those that report sensor attributes */
+static uint16_t scan_subscriptions(uint16_t *min_max_interval_s)
+{
+    InteractionModelEngine *engine = InteractionModelEngine::GetInstance();
+    uint16_t subscribers = 0;
+    *min_max_interval_s = 0;
+
+    for (uint32_t i = 0; i < engine->GetNumActiveReadHandlers(); i++) {
+        ReadHandler *handler = engine->ActiveHandlerAt(i);
+        if (handler == nullptr || !handler->IsType(ReadHandler::InteractionType::Subscribe) ||
+            !covers_sensor(handler)) {
+            continue;
+        }
+        uint16_t min_interval_s = 0;
+        uint16_t max_interval_s = 0;
+        handler->GetReportingIntervals(min_interval_s, max_interval_s);
+        if (subscribers == 0 || max_interval_s < *min_max_interval_s) {
+            *min_max_interval_s = max_interval_s;
+        }
+        subscribers++;
+    }
+    return subscribers;
+}
+
+static uint32_t pick_period(uint16_t subscribers, uint16_t min_max_interval_s)
+{
+    uint32_t period_ms = s_idle_period_ms;
+    if (subscribers > 0) {
+        /* Sampling once per max-interval is enough for every report to carry a fresh value. Stay on the fast grid
+         * so the period remains aligned with the radio schedule. */
+        uint32_t wanted_ms = (uint32_t)min_max_interval_s * 1000;
+        uint32_t multiple = wanted_ms / s_fast_period_ms;
+        period_ms = (multiple > 1 ? multiple : 1) * s_fast_period_ms;
+        period_ms = period_ms < s_idle_period_ms ? period_ms : s_idle_period_ms;
+    }
+    /* In low-power mode the sensor has nothing new to read more often than every 30 s */
+    if (s_profile == ACQUISITION_LOW_POWER && period_ms < s_low_power_period_ms) {
+        period_ms = s_low_power_period_ms;
+    }
+    return period_ms;
+}
+
+#if CONFIG_SENSOR_ADAPTIVE_ACQUISITION
+static void request_profile(acquisition_profile_t profile)
+{
+    /* Switching modes requires stopping periodic measurement first, which takes 500 ms, so the switch runs as a
+     * maintenance job. If another job holds the sensor, the next sample asks again. */
+    esp_err_t err = sensor_maintenance::start(sensor_maintenance::JOB_SWITCH_PROFILE, profile);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+        ESP_LOGE(TAG, "Failed to queue the acquisition profile switch, err:%d", err);
+    }
+}
+
+/* Go periodic as soon as the signal moves: either the windowed slope or a single step between two samples exceeds
+ * its threshold. The step check bounds the reaction latency to one low-power sample period. Go back to low-power
+ * only after the slope stayed under the (lower) idle threshold for the hold time. */
+static void update_profile(uint16_t co2_ppm, int64_t timestamp_us, int32_t slope_ppm_per_min)
+{
+    int32_t step_ppm = s_has_last_co2 ? abs((int32_t)co2_ppm - (int32_t)s_last_co2_ppm) : 0;
+    int32_t magnitude = abs(slope_ppm_per_min);
+    bool moving = magnitude >= CONFIG_SENSOR_SLOPE_ACTIVE_PPM_PER_MIN || step_ppm >= CONFIG_SENSOR_STEP_PPM;
+
+    if (moving || magnitude > CONFIG_SENSOR_SLOPE_IDLE_PPM_PER_MIN) {
+        s_last_movement_us = timestamp_us;
+    }
+
+    if (s_profile == ACQUISITION_LOW_POWER && moving) {
+        request_profile(ACQUISITION_PERIODIC);
+    } else if (s_profile == ACQUISITION_PERIODIC &&
+               timestamp_us - s_last_movement_us >= (int64_t)CONFIG_SENSOR_QUIET_HOLD_S * 1000000) {
+        request_profile(ACQUISITION_LOW_POWER);
+    }
+}
+#endif // CONFIG_SENSOR_ADAPTIVE_ACQUISITION
+
+esp_err_t init(uint16_t endpoint_id, uint32_t fast_period_ms, uint32_t idle_period_ms)
+{
+    if (fast_period_ms == 0 || idle_period_ms < fast_period_ms) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_endpoint_id = endpoint_id;
+    s_fast_period_ms = fast_period_ms;
+    /* Keep the idle and low-power periods on the fast grid as well */
+    s_idle_period_ms = (idle_period_ms / fast_period_ms) * fast_period_ms;
+    s_low_power_period_ms = ((k_low_power_interval_ms + fast_period_ms - 1) / fast_period_ms) * fast_period_ms;
+    s_profile = ACQUISITION_PERIODIC;
+    s_last_movement_us = 0;
+    s_slope.Reset();
+    return ESP_OK;
+}
+
+void on_sample(const measurement_pipeline::result_t &result)
+{
+    uint16_t co2_ppm = result.co2_raw_ppm;
+    int64_t timestamp_us = result.read_time_us;
+    uint16_t min_max_interval_s = 0;
+    uint16_t subscribers = scan_subscriptions(&min_max_interval_s);
+
+    /* A sample is reported at most once as a change, whenever the report engine gets to it; `latency reset`
+     * clears the tracer's count */
+    latency_trace::stats_t trace;
+    latency_trace::get_stats(&trace);
+    uint32_t first_reports = trace.first_reports;
+    uint32_t delivered = first_reports >= s_last_first_reports ? first_reports - s_last_first_reports : first_reports;
+    s_last_first_reports = first_reports;
+
+    s_slope.Push(timestamp_us / 1000, co2_ppm);
+    int32_t slope_ppm_per_min = s_slope.SlopePerMinute();
+#if CONFIG_SENSOR_ADAPTIVE_ACQUISITION
+    update_profile(co2_ppm, timestamp_us, slope_ppm_per_min);
+#endif
+    s_has_last_co2 = true;
+    s_last_co2_ppm = co2_ppm;
+
+    taskENTER_CRITICAL(&s_lock);
+    s_stats.taken++;
+    s_stats.delivered += delivered;
+    s_stats.subscribers = subscribers;
+    s_stats.min_max_interval_s = min_max_interval_s;
+    s_stats.slope_ppm_per_min = slope_ppm_per_min;
+    taskEXIT_CRITICAL(&s_lock);
+
+    uint32_t period_ms = pick_period(subscribers, min_max_interval_s);
+    if (period_ms != sensor_scheduler::get_period()) {
+        ESP_LOGI(TAG, "%u subscriber(s), shortest max-interval %us: sample period now %" PRIu32 " ms", subscribers,
+                 min_max_interval_s, period_ms);
+        sensor_scheduler::set_period(period_ms);
+    }
+}
+
+void set_profile(acquisition_profile_t profile)
+{
+    s_profile = profile;
+    taskENTER_CRITICAL(&s_lock);
+    s_stats.profile = profile;
+    s_stats.profile_switches++;
+    taskEXIT_CRITICAL(&s_lock);
+    ESP_LOGI(TAG, "Acquisition profile now %s", profile == ACQUISITION_PERIODIC ? "periodic" : "low-power");
+}
+
+int16_t start_measurement()
+{
+    return s_profile == ACQUISITION_LOW_POWER ? scd4x_start_low_power_periodic_measurement()
+                                              : scd4x_start_periodic_measurement();
+}
+
+void get_stats(stats_t *stats)
+{
+    taskENTER_CRITICAL(&s_lock);
+    *stats = s_stats;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+static esp_err_t policy_stats_handler(int argc, char **argv)
+{
+    stats_t stats;
+    get_stats(&stats);
+
+    printf("period_ms,%" PRIu32 "\r\n", sensor_scheduler::get_period());
+    printf("subscribers,%u\r\n", stats.subscribers);
+    printf("min_max_interval_s,%u\r\n", stats.min_max_interval_s);
+    printf("samples_taken,%" PRIu32 "\r\n", stats.taken);
+    printf("samples_delivered,%" PRIu32 "\r\n", stats.delivered);
+    printf("profile,%s\r\n", stats.profile == ACQUISITION_PERIODIC ? "periodic" : "low-power");
+    printf("slope_ppm_per_min,%" PRId32 "\r\n", stats.slope_ppm_per_min);
+    printf("profile_switches,%" PRIu32 "\r\n", stats.profile_switches);
+    return ESP_OK;
+}
+
+static console::engine policy_console;
+
+static esp_err_t policy_dispatch(int argc, char **argv)
+{
+    if (argc <= 0) {
+        policy_console.for_each_command(console::print_description, NULL);
+        return ESP_OK;
+    }
+    return policy_console.exec_command(argc, argv);
+}
+
+esp_err_t register_commands()
+{
+    static const console::command_t command = {
+        .name = "policy",
+        .description = "Adaptive sampling policy. Usage: matter esp policy stats.",
+        .handler = policy_dispatch,
+    };
+
+    static const console::command_t policy_commands[] = {
+        {
+            .name = "stats",
+            .description = "Print the current period and profile, subscription demand, CO2 slope and samples taken versus delivered",
+            .handler = policy_stats_handler,
+        },
+    };
+    policy_console.register_commands(policy_commands, sizeof(policy_commands) / sizeof(console::command_t));
+
+    return console::add_commands(&command, 1);
+}
+
+} // namespace sampling_policy
@@ -0,0 +1,93 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <esp_err.h>
+
+#include <stdint.h>
+
+#include <measurement-pipeline.h>
+
+namespace sampling_policy {
+
+/** SCD4x acquisition profile */
+typedef enum {
+    ACQUISITION_PERIODIC = 0, /* 5 s periodic measurement */
+    ACQUISITION_LOW_POWER,    /* 30 s low-power periodic measurement */
+} acquisition_profile_t;
+
+/** Sampling counters */
+typedef struct {
+    uint32_t taken;           /* Samples read from the sensor */
+    uint32_t delivered;       /* Samples whose CO2 value was encoded in a report or read, see latency_trace */
+    uint16_t subscribers;     /* Active subscriptions covering the sensor endpoint at the last evaluation */
+    uint16_t min_max_interval_s; /* Shortest max-interval among those subscriptions, 0 if none */
+    acquisition_profile_t profile; /* Current acquisition profile */
+    int32_t slope_ppm_per_min; /* CO2 slope over the estimator window */
+    uint32_t profile_switches; /* Number of acquisition profile changes */
+} stats_t;
+
+/** Initialize the sampling policy
+ *
+ * The sensor is expected to be running periodic measurement when this is called.
+ *
+ * @param[in] endpoint_id Endpoint hosting the sensor clusters.
+ * @param[in] fast_period_ms Shortest sample period, used while a subscriber needs fresh data.
+ * @param[in] idle_period_ms Low-power sample period, used when nobody is subscribed.
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t init(uint16_t endpoint_id, uint32_t fast_period_ms, uint32_t idle_period_ms);
+
+/** Account for a new sample and adjust the acquisition profile and sample period
+ *
+ * The slope of the unfiltered CO2 over the last few samples selects the acquisition profile: periodic while the
+ * signal moves, low-power once it has been flat for a while. The filter would delay the reaction to a step. The
+ * active subscription set is read from the Interaction Model engine; the shortest max-interval among subscriptions
+ * covering the sensor endpoint, bounded by the fast and idle periods, gives the sample period. The slower of the two
+ * requirements wins.
+ *
+ * Samples delivered are counted from `latency_trace`, which sees the report engine encode CO2: a sample counts once
+ * its value went out in at least one report or read, so values coalesced away by a min-interval or published while
+ * nobody listened do not. AirQuality is classified from the published CO2, so its changes come with a CO2 change.
+ * Must be called from the Matter event loop.
+ *
+ * @param[in] result Sample that was just published; `co2_raw_ppm` and `read_time_us` are used.
+ */
+void on_sample(const measurement_pipeline::result_t &result);
+
+/** Make `profile` the current acquisition profile
+ *
+ * Profile switches requested by `on_sample()` run as `sensor_maintenance` jobs, off the Matter event loop. The job
+ * calls this with the CHIP stack and the sensor bus locked once the sensor is stopped; its `start_measurement()`
+ * then starts the new profile.
+ */
+void set_profile(acquisition_profile_t profile);
+
+/** Start periodic measurement in the current acquisition profile
+ *
+ * Used to resume measuring after the sensor was stopped for configuration or maintenance. Must be called from the
+ * Matter event loop or with the CHIP stack locked, and with the sensor bus locked.
+ *
+ * @return error_code 0 on success, an error code otherwise.
+ */
+int16_t start_measurement();
+
+/** Copy the sampling counters */
+void get_stats(stats_t *stats);
+
+/** Register the `policy` console commands
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t register_commands();
+
+} // namespace sampling_policy
@@ -0,0 +1,42 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <sensor-bus.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+namespace sensor_bus {
+
+/* A mutex rather than a binary semaphore, so a low priority holder inherits the priority of a task waiting for it */
+static SemaphoreHandle_t s_mutex = NULL;
+
+esp_err_t init()
+{
+    if (s_mutex == NULL) {
+        s_mutex = xSemaphoreCreateMutex();
+    }
+    return s_mutex != NULL ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+void lock()
+{
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+}
+
+bool try_lock()
+{
+    return xSemaphoreTake(s_mutex, 0) == pdTRUE;
+}
+
+void unlock()
+{
+    xSemaphoreGive(s_mutex);
+}
+
+} // namespace sensor_bus
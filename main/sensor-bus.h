@@ -0,0 +1,45 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <esp_err.h>
+
+/** Ownership of the I2C bus shared by the SCD4x and the barometer
+ *
+ * Every SCD4x command sequence and every barometer transaction runs with the bus locked, so the sampling timer, the
+ * Matter event loop and the console never interleave on the wire. A maintenance job locks it only to take and hand
+ * back the sensor (see `sensor_maintenance::busy()`), so the long commands never hold it.
+ *
+ * When both are needed, the CHIP stack lock is taken first. The sampling timer never takes the CHIP stack lock and
+ * never waits for the bus: it uses `try_lock()` and retries from its timer.
+ */
+namespace sensor_bus {
+
+/** Create the bus mutex; must be called before any other task touches the bus
+ *
+ * @return ESP_OK on success.
+ * @return ESP_ERR_NO_MEM if the mutex could not be created.
+ */
+esp_err_t init();
+
+/** Wait until the bus is free and take it */
+void lock();
+
+/** Take the bus if it is free, without waiting
+ *
+ * For the sampling timer callbacks, which run in the esp_timer task and must not block.
+ *
+ * @return true if the bus was taken.
+ */
+bool try_lock();
+
+/** Hand the bus back */
+void unlock();
+
+} // namespace sensor_bus
@@ -0,0 +1,475 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <sensor-bus.h>
+#include <sensor-config.h>
+#include <sensor-maintenance.h>
+
+#include <esp_log.h>
+#include <esp_matter_console.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <nvs.h>
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "drivers/scd4x_i2c.h"
+#include "drivers/sensirion_common.h"
+
+static const char *TAG = "sensor_config";
+
+using namespace esp_matter;
+
+namespace sensor_config {
+
+static const char *k_nvs_namespace = "sensor_cfg";
+static const char *k_nvs_key = "config";
+/* Bump when config_t changes layout; a stored blob with another version is ignored */
+static const uint16_t k_nvs_version = 1;
+
+typedef struct {
+    uint16_t version;
+    config_t config;
+} nvs_blob_t;
+
+/** One cached setting: where it lives in config_t and how to move it over the bus */
+typedef struct {
+    const char *name;
+    size_t offset;
+    int16_t (*read)(uint16_t *value);
+    int16_t (*write)(uint16_t value);
+    bool optional; /* SCD41 only; a failed read at boot marks it unsupported */
+} setting_t;
+
+static const setting_t k_settings[] = {
+    {"temp_offset_raw", offsetof(config_t, temperature_offset_raw), scd4x_get_temperature_offset_raw,
+     scd4x_set_temperature_offset_raw, false},
+    {"altitude_m", offsetof(config_t, altitude_m), scd4x_get_sensor_altitude, scd4x_set_sensor_altitude, false},
+    {"asc", offsetof(config_t, asc_enabled), scd4x_get_automatic_self_calibration_enabled,
+     scd4x_set_automatic_self_calibration_enabled, false},
+    {"asc_target_ppm", offsetof(config_t, asc_target_ppm), scd4x_get_automatic_self_calibration_target,
+     scd4x_set_automatic_self_calibration_target, false},
+    {"asc_initial_h", offsetof(config_t, asc_initial_period_h), scd4x_get_automatic_self_calibration_initial_period,
+     scd4x_set_automatic_self_calibration_initial_period, true},
+    {"asc_standard_h", offsetof(config_t, asc_standard_period_h),
+     scd4x_get_automatic_self_calibration_standard_period, scd4x_set_automatic_self_calibration_standard_period, true},
+};
+static const size_t k_setting_count = sizeof(k_settings) / sizeof(k_settings[0]);
+
+/* Settings as cached, as last known in the sensor EEPROM, and the unsupported ones (bit per k_settings entry) */
+static config_t s_config;
+static config_t s_eeprom;
+/* Configuration queued by apply() for the maintenance task, valid while s_apply_queued */
+static config_t s_pending;
+static bool s_apply_queued = false;
+static uint32_t s_unsupported = 0;
+static uint32_t s_ambient_pressure_pa = 0;
+static stats_t s_stats;
+static esp_timer_handle_t s_nvs_timer = NULL;
+static esp_timer_handle_t s_persist_timer = NULL;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static uint16_t *field_ptr(config_t *config, const setting_t &setting)
+{
+    return (uint16_t *)((uint8_t *)config + setting.offset);
+}
+
+static uint16_t field_value(const config_t *config, const setting_t &setting)
+{
+    return *(const uint16_t *)((const uint8_t *)config + setting.offset);
+}
+
+static esp_err_t read_sensor(config_t *config)
+{
+    memset(config, 0, sizeof(*config));
+    for (size_t i = 0; i < k_setting_count; i++) {
+        int16_t error = k_settings[i].read(field_ptr(config, k_settings[i]));
+        if (error == NO_ERROR) {
+            continue;
+        }
+        if (!k_settings[i].optional) {
+            ESP_LOGE(TAG, "Failed to read %s, error:%d", k_settings[i].name, error);
+            return ESP_FAIL;
+        }
+        s_unsupported |= 1u << i;
+    }
+    return ESP_OK;
+}
+
+/* Write the settings that differ, updating `current` as each write succeeds. The sensor must be idle. */
+static esp_err_t write_changes(config_t *current, const config_t *wanted)
+{
+    for (size_t i = 0; i < k_setting_count; i++) {
+        uint16_t value = field_value(wanted, k_settings[i]);
+        if ((s_unsupported & (1u << i)) || value == field_value(current, k_settings[i])) {
+            continue;
+        }
+        int16_t error = k_settings[i].write(value);
+        if (error != NO_ERROR) {
+            ESP_LOGE(TAG, "Failed to write %s, error:%d", k_settings[i].name, error);
+            return ESP_FAIL;
+        }
+        *field_ptr(current, k_settings[i]) = value;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t load_nvs(config_t *config)
+{
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(k_nvs_namespace, NVS_READONLY, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+    nvs_blob_t blob;
+    size_t size = sizeof(blob);
+    err = nvs_get_blob(handle, k_nvs_key, &blob, &size);
+    nvs_close(handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (size != sizeof(blob) || blob.version != k_nvs_version) {
+        ESP_LOGW(TAG, "Ignoring stored configuration version %u", blob.version);
+        return ESP_ERR_INVALID_VERSION;
+    }
+    *config = blob.config;
+    return ESP_OK;
+}
+
+/* Runs in the esp_timer task once changes have settled */
+static void nvs_timer_cb(void *arg)
+{
+    nvs_blob_t blob = {.version = k_nvs_version, .config = {}};
+    taskENTER_CRITICAL(&s_lock);
+    blob.config = s_config;
+    taskEXIT_CRITICAL(&s_lock);
+
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(k_nvs_namespace, NVS_READWRITE, &handle);
+    if (err == ESP_OK) {
+        err = nvs_set_blob(handle, k_nvs_key, &blob, sizeof(blob));
+        if (err == ESP_OK) {
+            err = nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to store configuration, err:%d", err);
+        return;
+    }
+    taskENTER_CRITICAL(&s_lock);
+    s_stats.nvs_writes++;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+/* Runs in the esp_timer task. The stop/persist/restart cycle takes 1.3 s, so it goes to the maintenance task rather
+ * than the Matter event loop; the sample callback skips the sensor meanwhile. */
+static void persist_timer_cb(void *arg)
+{
+    taskENTER_CRITICAL(&s_lock);
+    bool eeprom_dirty = memcmp(&s_config, &s_eeprom, sizeof(s_config)) != 0;
+    taskEXIT_CRITICAL(&s_lock);
+    if (!eeprom_dirty) {
+        return;
+    }
+
+    esp_err_t err = sensor_maintenance::start(sensor_maintenance::JOB_PERSIST_SETTINGS, 0);
+    if (err == ESP_ERR_INVALID_STATE) {
+        /* Another job owns the sensor; try again after another delay */
+        esp_timer_start_once(s_persist_timer, (uint64_t)CONFIG_SENSOR_CONFIG_PERSIST_DELAY_S * 1000000);
+    } else if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to queue the EEPROM persist, err:%d", err);
+    }
+}
+
+/* Restart both debounce timers: each burst of changes costs one NVS write and at most one EEPROM write */
+static void schedule_persistence()
+{
+    esp_timer_stop(s_nvs_timer);
+    esp_timer_start_once(s_nvs_timer, (uint64_t)CONFIG_SENSOR_CONFIG_NVS_DEBOUNCE_MS * 1000);
+
+    taskENTER_CRITICAL(&s_lock);
+    bool eeprom_dirty = memcmp(&s_config, &s_eeprom, sizeof(s_config)) != 0;
+    s_stats.eeprom_dirty = eeprom_dirty;
+    taskEXIT_CRITICAL(&s_lock);
+    if (eeprom_dirty) {
+        esp_timer_stop(s_persist_timer);
+        esp_timer_start_once(s_persist_timer, (uint64_t)CONFIG_SENSOR_CONFIG_PERSIST_DELAY_S * 1000000);
+    }
+}
+
+esp_err_t init()
+{
+    const esp_timer_create_args_t nvs_timer_args = {
+        .callback = nvs_timer_cb,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "sensor_cfg_nvs",
+        .skip_unhandled_events = true,
+    };
+    const esp_timer_create_args_t persist_timer_args = {
+        .callback = persist_timer_cb,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "sensor_cfg_eeprom",
+        .skip_unhandled_events = true,
+    };
+    esp_err_t err = esp_timer_create(&nvs_timer_args, &s_nvs_timer);
+    if (err == ESP_OK) {
+        err = esp_timer_create(&persist_timer_args, &s_persist_timer);
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    /* The sensor keeps measuring across an MCU reset; the getters need it idle */
+    scd4x_stop_periodic_measurement();
+    err = read_sensor(&s_eeprom);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    config_t wanted;
+    bool stored = load_nvs(&wanted) == ESP_OK;
+    if (!stored) {
+        wanted = s_eeprom;
+#if CONFIG_SENSOR_ALTITUDE_M > 0
+        wanted.altitude_m = CONFIG_SENSOR_ALTITUDE_M;
+#endif
+    }
+
+    s_config = s_eeprom;
+    err = write_changes(&s_config, &wanted);
+    ESP_LOGI(TAG, "Configuration loaded from %s", stored ? "NVS" : "the sensor");
+    if (!stored || memcmp(&s_config, &s_eeprom, sizeof(s_config)) != 0) {
+        schedule_persistence();
+    }
+    return err;
+}
+
+void get(config_t *config)
+{
+    taskENTER_CRITICAL(&s_lock);
+    *config = s_config;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+esp_err_t apply(const config_t *config)
+{
+    /* Claiming s_apply_queued under the lock serializes concurrent callers: one change is in flight at a time */
+    taskENTER_CRITICAL(&s_lock);
+    bool queued = s_apply_queued;
+    bool unchanged = memcmp(&s_config, config, sizeof(s_config)) == 0;
+    if (!queued && !unchanged) {
+        s_pending = *config;
+        s_apply_queued = true;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+    if (queued) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (unchanged) {
+        return ESP_OK;
+    }
+
+    esp_err_t err = sensor_maintenance::start(sensor_maintenance::JOB_APPLY_CONFIG, 0);
+    if (err != ESP_OK) {
+        drop_pending();
+    }
+    return err;
+}
+
+esp_err_t write_pending()
+{
+    /* The job owns the sensor, so nothing else writes s_config until this returns */
+    taskENTER_CRITICAL(&s_lock);
+    config_t current = s_config;
+    config_t wanted = s_pending;
+    taskEXIT_CRITICAL(&s_lock);
+
+    /* All idle-only settings go in the job's single stop/apply/restart cycle */
+    esp_err_t err = write_changes(&current, &wanted);
+
+    taskENTER_CRITICAL(&s_lock);
+    s_config = current;
+    s_apply_queued = false;
+    s_stats.apply_cycles++;
+    taskEXIT_CRITICAL(&s_lock);
+    schedule_persistence();
+    return err;
+}
+
+void drop_pending()
+{
+    taskENTER_CRITICAL(&s_lock);
+    s_apply_queued = false;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+esp_err_t reload()
+{
+    config_t config;
+    esp_err_t err = read_sensor(&config);
+    if (err != ESP_OK) {
+        return err;
+    }
+    taskENTER_CRITICAL(&s_lock);
+    s_config = config;
+    s_eeprom = config;
+    s_ambient_pressure_pa = 0;
+    taskEXIT_CRITICAL(&s_lock);
+    schedule_persistence();
+    return ESP_OK;
+}
+
+esp_err_t persist()
+{
+    /* persist_settings is only accepted in idle mode and takes 800 ms */
+    int16_t error = scd4x_persist_settings();
+    if (error != NO_ERROR) {
+        ESP_LOGE(TAG, "Failed to persist settings, error:%d", error);
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "Settings persisted to the sensor EEPROM");
+
+    esp_timer_stop(s_persist_timer);
+    taskENTER_CRITICAL(&s_lock);
+    s_eeprom = s_config;
+    s_stats.eeprom_writes++;
+    s_stats.eeprom_dirty = false;
+    taskEXIT_CRITICAL(&s_lock);
+    return ESP_OK;
+}
+
+esp_err_t set_ambient_pressure(uint32_t pressure_pa)
+{
+    sensor_bus::lock();
+    if (sensor_maintenance::busy()) {
+        sensor_bus::unlock();
+        return ESP_ERR_INVALID_STATE;
+    }
+    int16_t error = scd4x_set_ambient_pressure(pressure_pa);
+    sensor_bus::unlock();
+    if (error != NO_ERROR) {
+        ESP_LOGW(TAG, "Failed to set ambient pressure, error:%d", error);
+        return ESP_FAIL;
+    }
+    taskENTER_CRITICAL(&s_lock);
+    s_ambient_pressure_pa = pressure_pa;
+    taskEXIT_CRITICAL(&s_lock);
+    return ESP_OK;
+}
+
+uint32_t get_ambient_pressure()
+{
+    taskENTER_CRITICAL(&s_lock);
+    uint32_t pressure_pa = s_ambient_pressure_pa;
+    taskEXIT_CRITICAL(&s_lock);
+    return pressure_pa;
+}
+
+void get_stats(stats_t *stats)
+{
+    taskENTER_CRITICAL(&s_lock);
+    *stats = s_stats;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+static esp_err_t sensorcfg_show_handler(int argc, char **argv)
+{
+    config_t config;
+    stats_t stats;
+    get(&config);
+    get_stats(&stats);
+
+    for (size_t i = 0; i < k_setting_count; i++) {
+        if (s_unsupported & (1u << i)) {
+            printf("%s,unsupported\r\n", k_settings[i].name);
+        } else {
+            printf("%s,%u\r\n", k_settings[i].name, field_value(&config, k_settings[i]));
+        }
+    }
+    printf("temp_offset_mdegc,%" PRIu32 "\r\n", (uint32_t)config.temperature_offset_raw * 175000 / 65535);
+    printf("ambient_pressure_pa,%" PRIu32 "\r\n", get_ambient_pressure());
+    printf("apply_cycles,%" PRIu32 "\r\n", stats.apply_cycles);
+    printf("nvs_writes,%" PRIu32 "\r\n", stats.nvs_writes);
+    printf("eeprom_writes,%" PRIu32 "\r\n", stats.eeprom_writes);
+    printf("eeprom_dirty,%d\r\n", stats.eeprom_dirty);
+    return ESP_OK;
+}
+
+/* Takes several name/value pairs so related settings change in a single apply cycle */
+static esp_err_t sensorcfg_set_handler(int argc, char **argv)
+{
+    if (argc < 2 || argc % 2 != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    config_t config;
+    get(&config);
+    for (int arg = 0; arg < argc; arg += 2) {
+        size_t i = 0;
+        while (i < k_setting_count && strcmp(argv[arg], k_settings[i].name) != 0) {
+            i++;
+        }
+        if (i == k_setting_count || (s_unsupported & (1u << i))) {
+            printf("Unknown or unsupported setting %s\r\n", argv[arg]);
+            return ESP_ERR_INVALID_ARG;
+        }
+        *field_ptr(&config, k_settings[i]) = (uint16_t)strtoul(argv[arg + 1], NULL, 0);
+    }
+
+    esp_err_t err = apply(&config);
+    if (err == ESP_ERR_INVALID_STATE) {
+        printf("A configuration change or maintenance job is already running\r\n");
+    }
+    return err;
+}
+
+static console::engine sensorcfg_console;
+
+static esp_err_t sensorcfg_dispatch(int argc, char **argv)
+{
+    if (argc <= 0) {
+        sensorcfg_console.for_each_command(console::print_description, NULL);
+        return ESP_OK;
+    }
+    return sensorcfg_console.exec_command(argc, argv);
+}
+
+esp_err_t register_commands()
+{
+    static const console::command_t command = {
+        .name = "sensorcfg",
+        .description = "SCD4x configuration cache. Usage: matter esp sensorcfg <show|set>.",
+        .handler = sensorcfg_dispatch,
+    };
+
+    static const console::command_t sensorcfg_commands[] = {
+        {
+            .name = "show",
+            .description = "Print the cached sensor settings and the persistence counters",
+            .handler = sensorcfg_show_handler,
+        },
+        {
+            .name = "set",
+            .description = "Change settings in one apply cycle. Usage: matter esp sensorcfg set <name> <value> "
+                           "[<name> <value> ...]",
+            .handler = sensorcfg_set_handler,
+        },
+    };
+    sensorcfg_console.register_commands(sensorcfg_commands, sizeof(sensorcfg_commands) / sizeof(console::command_t));
+
+    return console::add_commands(&command, 1);
+}
+
+} // namespace sensor_config
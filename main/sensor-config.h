@@ -0,0 +1,122 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <esp_err.h>
+
+#include <stdint.h>
+
+namespace sensor_config {
+
+/** SCD4x settings kept in the sensor EEPROM, in the raw units of the driver */
+typedef struct {
+    uint16_t temperature_offset_raw; /* Temperature offset, 175 / 65535 degC per LSB */
+    uint16_t altitude_m;             /* Sensor altitude above sea level */
+    uint16_t asc_enabled;            /* Automatic self-calibration enabled */
+    uint16_t asc_target_ppm;         /* Automatic self-calibration target */
+    uint16_t asc_initial_period_h;   /* Automatic self-calibration initial period */
+    uint16_t asc_standard_period_h;  /* Automatic self-calibration standard period */
+} config_t;
+
+/** Configuration cache counters */
+typedef struct {
+    uint32_t apply_cycles;  /* Stop/apply/restart cycles run for configuration changes */
+    uint32_t nvs_writes;    /* Configuration blobs written to NVS */
+    uint32_t eeprom_writes; /* persist_settings commands sent to the sensor */
+    bool eeprom_dirty;      /* The sensor EEPROM differs from the cached configuration */
+} stats_t;
+
+/** Load the sensor configuration
+ *
+ * Reads every setting from the sensor once, then reconciles it with the copy stored in NVS: stored values win and are
+ * written to the sensor. Without a stored copy the sensor values (and SENSOR_ALTITUDE_M, if set) seed the cache. Must
+ * be called after `scd4x_init()` and before periodic measurement is started.
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t init();
+
+/** Copy the cached configuration, without any bus access */
+void get(config_t *config);
+
+/** Apply a new configuration
+ *
+ * Queues a JOB_APPLY_CONFIG `sensor_maintenance` job and returns: the 500 ms stop/apply/restart cycle runs in the
+ * maintenance task, like the EEPROM persist, and the sample callback skips the sensor meanwhile. Only the settings
+ * that differ from the cache are written, in that single cycle; nothing is queued when nothing changed. The NVS copy
+ * and the sensor EEPROM are updated later, after SENSOR_CONFIG_NVS_DEBOUNCE_MS and SENSOR_CONFIG_PERSIST_DELAY_S
+ * without further changes. The outcome is in the job status. May be called from any task.
+ *
+ * @param[in] config New configuration.
+ *
+ * @return ESP_OK if the change was queued, or nothing changed.
+ * @return ESP_ERR_INVALID_STATE while another change or a maintenance job is queued or running.
+ * @return error in case of failure.
+ */
+esp_err_t apply(const config_t *config);
+
+/** Write the configuration queued by `apply()`
+ *
+ * Run by the JOB_APPLY_CONFIG job. The sensor must be idle and owned by the caller.
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure; the cache keeps the settings that were written.
+ */
+esp_err_t write_pending();
+
+/** Forget the configuration queued by `apply()`, when its job could not stop the sensor */
+void drop_pending();
+
+/** Reload the cache from the sensor
+ *
+ * Used after a factory reset, which restores the sensor defaults behind the cache's back. The new values are mirrored
+ * to NVS after the usual debounce delay. The sensor must be idle and owned by the caller (a maintenance job).
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t reload();
+
+/** Persist the cached configuration to the sensor EEPROM now
+ *
+ * Cancels any pending debounced persist. The sensor must be idle and owned by the caller (a maintenance job).
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t persist();
+
+/** Set the ambient pressure
+ *
+ * Ambient pressure can be written during periodic measurement and is not kept in the EEPROM, so it is sent at once
+ * and only cached in RAM. Must be called from the Matter event loop; takes the sensor bus.
+ *
+ * @param[in] pressure_pa Ambient pressure in Pa.
+ *
+ * @return ESP_OK on success.
+ * @return ESP_ERR_INVALID_STATE while a maintenance job runs.
+ * @return error in case of failure.
+ */
+esp_err_t set_ambient_pressure(uint32_t pressure_pa);
+
+/** Last ambient pressure written to the sensor in Pa, 0 if none */
+uint32_t get_ambient_pressure();
+
+/** Copy the configuration cache counters */
+void get_stats(stats_t *stats);
+
+/** Register the `sensorcfg` console commands
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t register_commands();
+
+} // namespace sensor_config
@@ -0,0 +1,385 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <sensor-events.h>
+
+#include <esp_log.h>
+#ifdef ESP_PLATFORM
+#include <esp_matter_console.h>
+#endif
+#include <freertos/FreeRTOS.h>
+#include <sdkconfig.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <app-common/zap-generated/ids/Clusters.h>
+#include <app/EventLogging.h>
+#include <lib/core/TLV.h>
+#include <platform/CHIPDeviceConfig.h>
+
+static const char *TAG = "sensor_events";
+
+#ifdef ESP_PLATFORM
+using namespace esp_matter;
+#endif
+using namespace chip;
+using namespace chip::app;
+using namespace chip::app::Clusters;
+
+namespace sensor_events {
+
+/* Rough size of one of these events in the event buffers once the path, event number, priority and system timestamp
+ * are added around the payload */
+static const size_t k_event_size_bytes = 72;
+
+namespace {
+
+struct AirQualityChangedEvent
+{
+    static constexpr PriorityLevel GetPriorityLevel() { return PriorityLevel::Info; }
+    static constexpr EventId GetEventId() { return k_air_quality_changed_event_id; }
+    static constexpr ClusterId GetClusterId() { return AirQuality::Id; }
+    static constexpr bool kIsFabricScoped = false;
+    FabricIndex GetFabricIndex() const { return kUndefinedFabricIndex; }
+
+    uint64_t sample_time_ms;
+    uint8_t previous_air_quality;
+    uint8_t air_quality;
+    uint16_t co2_ppm;
+
+    CHIP_ERROR Encode(TLV::TLVWriter &writer, TLV::Tag tag) const
+    {
+        TLV::TLVType outer;
+        ReturnErrorOnFailure(writer.StartContainer(tag, TLV::kTLVType_Structure, outer));
+        ReturnErrorOnFailure(writer.Put(TLV::ContextTag(0), sample_time_ms));
+        ReturnErrorOnFailure(writer.Put(TLV::ContextTag(1), previous_air_quality));
+        ReturnErrorOnFailure(writer.Put(TLV::ContextTag(2), air_quality));
+        ReturnErrorOnFailure(writer.Put(TLV::ContextTag(3), co2_ppm));
+        return writer.EndContainer(outer);
+    }
+};
+
+struct Co2ThresholdCrossedEvent
+{
+    static constexpr PriorityLevel GetPriorityLevel() { return PriorityLevel::Info; }
+    static constexpr EventId GetEventId() { return k_co2_threshold_crossed_event_id; }
+    static constexpr ClusterId GetClusterId() { return CarbonDioxideConcentrationMeasurement::Id; }
+    static constexpr bool kIsFabricScoped = false;
+    FabricIndex GetFabricIndex() const { return kUndefinedFabricIndex; }
+
+    uint64_t sample_time_ms;
+    uint16_t threshold_ppm;
+    bool rising;
+    uint16_t co2_ppm;
+
+    CHIP_ERROR Encode(TLV::TLVWriter &writer, TLV::Tag tag) const
+    {
+        TLV::TLVType outer;
+        ReturnErrorOnFailure(writer.StartContainer(tag, TLV::kTLVType_Structure, outer));
+        ReturnErrorOnFailure(writer.Put(TLV::ContextTag(0), sample_time_ms));
+        ReturnErrorOnFailure(writer.Put(TLV::ContextTag(1), threshold_ppm));
+        ReturnErrorOnFailure(writer.PutBoolean(TLV::ContextTag(2), rising));
+        ReturnErrorOnFailure(writer.Put(TLV::ContextTag(3), co2_ppm));
+        return writer.EndContainer(outer);
+    }
+};
+
+} // namespace
+
+static EndpointId s_endpoint_id = kInvalidEndpointId;
+static uint16_t s_thresholds_ppm[k_max_thresholds];
+static size_t s_threshold_count = 0;
+static bool s_above[k_max_thresholds];
+static bool s_primed = false;
+static measurement_pipeline::air_quality_t s_air_quality = measurement_pipeline::AIR_QUALITY_UNKNOWN;
+static stats_t s_stats;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+template <typename T>
+static void log_event(const T &event, uint32_t *counter)
+{
+    EventNumber event_number = 0;
+    CHIP_ERROR err = LogEvent(event, s_endpoint_id, event_number);
+    taskENTER_CRITICAL(&s_lock);
+    if (err == CHIP_NO_ERROR) {
+        (*counter)++;
+        s_stats.last_event_number = event_number;
+    } else {
+        s_stats.log_failures++;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+    if (err != CHIP_NO_ERROR) {
+        ESP_LOGW(TAG, "Failed to log event 0x%08" PRIX32 ", err:%" CHIP_ERROR_FORMAT, (uint32_t)T::GetEventId(),
+                 err.Format());
+    }
+}
+
+static void log_crossing(uint16_t threshold_ppm, bool rising, uint16_t co2_ppm, uint64_t sample_time_ms)
+{
+    Co2ThresholdCrossedEvent event;
+    event.sample_time_ms = sample_time_ms;
+    event.threshold_ppm = threshold_ppm;
+    event.rising = rising;
+    event.co2_ppm = co2_ppm;
+    log_event(event, &s_stats.threshold_crossings);
+}
+
+/* Sort in place; at most k_max_thresholds entries */
+static void sort_thresholds(uint16_t *thresholds_ppm, size_t count)
+{
+    for (size_t i = 1; i < count; i++) {
+        uint16_t value = thresholds_ppm[i];
+        size_t j = i;
+        for (; j > 0 && thresholds_ppm[j - 1] > value; j--) {
+            thresholds_ppm[j] = thresholds_ppm[j - 1];
+        }
+        thresholds_ppm[j] = value;
+    }
+}
+
+/* Parse the comma-separated Kconfig list, ignoring anything that is not a positive ppm value */
+static size_t parse_thresholds(const char *list, uint16_t *thresholds_ppm, size_t max_count)
+{
+    size_t count = 0;
+    const char *cursor = list;
+    while (*cursor != '\0' && count < max_count) {
+        char *end = nullptr;
+        long value = strtol(cursor, &end, 10);
+        if (end == cursor) {
+            cursor++;
+            continue;
+        }
+        if (value > 0 && value <= UINT16_MAX) {
+            thresholds_ppm[count++] = (uint16_t)value;
+        }
+        cursor = end;
+    }
+    return count;
+}
+
+static void check_buffers()
+{
+    /* Events are written to the lowest priority buffer first and move up as it fills, so Info events can use the
+     * Debug buffer as well as their own */
+    size_t capacity =
+        (CHIP_DEVICE_CONFIG_EVENT_LOGGING_DEBUG_BUFFER_SIZE + CHIP_DEVICE_CONFIG_EVENT_LOGGING_INFO_BUFFER_SIZE) /
+        k_event_size_bytes;
+    if (capacity < CONFIG_SENSOR_EVENTS_BACKLOG) {
+        ESP_LOGW(TAG, "Event buffers hold about %u sensor events, %d wanted; older events are lost in long outages",
+                 (unsigned)capacity, CONFIG_SENSOR_EVENTS_BACKLOG);
+    }
+}
+
+#ifdef ESP_PLATFORM
+esp_err_t init(endpoint_t *sensor_endpoint)
+{
+    cluster_t *air_quality = cluster::get(sensor_endpoint, AirQuality::Id);
+    cluster_t *co2 = cluster::get(sensor_endpoint, CarbonDioxideConcentrationMeasurement::Id);
+    if (air_quality == nullptr || co2 == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (event::create(air_quality, k_air_quality_changed_event_id) == nullptr ||
+        event::create(co2, k_co2_threshold_crossed_event_id) == nullptr) {
+        return ESP_ERR_NO_MEM;
+    }
+    return init(endpoint::get_id(sensor_endpoint));
+}
+#endif
+
+esp_err_t init(uint16_t endpoint_id)
+{
+    s_endpoint_id = endpoint_id;
+
+    uint16_t thresholds_ppm[k_max_thresholds];
+    size_t count = parse_thresholds(CONFIG_SENSOR_EVENTS_CO2_THRESHOLDS, thresholds_ppm, k_max_thresholds);
+    check_buffers();
+    return set_thresholds(thresholds_ppm, count);
+}
+
+void on_sample(const measurement_pipeline::result_t &result, int64_t timestamp_us)
+{
+    if (s_endpoint_id == kInvalidEndpointId) {
+        return;
+    }
+    uint64_t sample_time_ms = (uint64_t)(timestamp_us / 1000);
+
+    if (result.air_quality != s_air_quality) {
+        AirQualityChangedEvent event;
+        event.sample_time_ms = sample_time_ms;
+        event.previous_air_quality = (uint8_t)s_air_quality;
+        event.air_quality = (uint8_t)result.air_quality;
+        event.co2_ppm = result.co2_ppm;
+        log_event(event, &s_stats.category_changes);
+        s_air_quality = result.air_quality;
+    }
+
+    uint16_t thresholds_ppm[k_max_thresholds];
+    taskENTER_CRITICAL(&s_lock);
+    size_t count = s_threshold_count;
+    for (size_t i = 0; i < count; i++) {
+        thresholds_ppm[i] = s_thresholds_ppm[i];
+    }
+    bool primed = s_primed;
+    s_primed = true;
+    taskEXIT_CRITICAL(&s_lock);
+
+    bool above[k_max_thresholds];
+    for (size_t i = 0; i < count; i++) {
+        /* Rise at the threshold, fall only below it minus the hysteresis */
+        int32_t level_ppm = thresholds_ppm[i];
+        if (primed && s_above[i]) {
+            level_ppm -= CONFIG_SENSOR_EVENTS_CO2_HYSTERESIS_PPM;
+        }
+        above[i] = (int32_t)result.co2_ppm >= level_ppm;
+    }
+
+    /* A jump across several thresholds is logged in the order a slow change would produce: rises lowest first,
+     * falls highest first */
+    if (primed) {
+        for (size_t i = 0; i < count; i++) {
+            if (above[i] && !s_above[i]) {
+                log_crossing(thresholds_ppm[i], true, result.co2_ppm, sample_time_ms);
+            }
+        }
+        for (size_t i = count; i-- > 0;) {
+            if (!above[i] && s_above[i]) {
+                log_crossing(thresholds_ppm[i], false, result.co2_ppm, sample_time_ms);
+            }
+        }
+    }
+    for (size_t i = 0; i < count; i++) {
+        s_above[i] = above[i];
+    }
+}
+
+esp_err_t set_thresholds(const uint16_t *thresholds_ppm, size_t count)
+{
+    if (count > k_max_thresholds) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    uint16_t sorted[k_max_thresholds];
+    for (size_t i = 0; i < count; i++) {
+        if (thresholds_ppm[i] == 0) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        sorted[i] = thresholds_ppm[i];
+    }
+    sort_thresholds(sorted, count);
+
+    taskENTER_CRITICAL(&s_lock);
+    for (size_t i = 0; i < count; i++) {
+        s_thresholds_ppm[i] = sorted[i];
+    }
+    s_threshold_count = count;
+    s_primed = false;
+    taskEXIT_CRITICAL(&s_lock);
+    return ESP_OK;
+}
+
+size_t get_thresholds(uint16_t *thresholds_ppm, size_t max_count)
+{
+    taskENTER_CRITICAL(&s_lock);
+    size_t count = s_threshold_count < max_count ? s_threshold_count : max_count;
+    for (size_t i = 0; i < count; i++) {
+        thresholds_ppm[i] = s_thresholds_ppm[i];
+    }
+    taskEXIT_CRITICAL(&s_lock);
+    return count;
+}
+
+void get_stats(stats_t *stats)
+{
+    taskENTER_CRITICAL(&s_lock);
+    *stats = s_stats;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+#ifdef ESP_PLATFORM
+static esp_err_t events_stats_handler(int argc, char **argv)
+{
+    stats_t stats;
+    get_stats(&stats);
+
+    printf("category_changes,%" PRIu32 "\r\n", stats.category_changes);
+    printf("threshold_crossings,%" PRIu32 "\r\n", stats.threshold_crossings);
+    printf("log_failures,%" PRIu32 "\r\n", stats.log_failures);
+    printf("last_event_number,%" PRIu64 "\r\n", stats.last_event_number);
+    return ESP_OK;
+}
+
+static esp_err_t events_thresholds_handler(int argc, char **argv)
+{
+    if (argc > 0) {
+        if ((size_t)argc > k_max_thresholds) {
+            ESP_LOGE(TAG, "At most %u thresholds", (unsigned)k_max_thresholds);
+            return ESP_ERR_INVALID_ARG;
+        }
+        uint16_t thresholds_ppm[k_max_thresholds];
+        for (int i = 0; i < argc; i++) {
+            long value = strtol(argv[i], nullptr, 10);
+            if (value <= 0 || value > UINT16_MAX) {
+                ESP_LOGE(TAG, "Invalid threshold: %s", argv[i]);
+                return ESP_ERR_INVALID_ARG;
+            }
+            thresholds_ppm[i] = (uint16_t)value;
+        }
+        esp_err_t err = set_thresholds(thresholds_ppm, argc);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+
+    uint16_t thresholds_ppm[k_max_thresholds];
+    size_t count = get_thresholds(thresholds_ppm, k_max_thresholds);
+    for (size_t i = 0; i < count; i++) {
+        printf("threshold_ppm,%u\r\n", thresholds_ppm[i]);
+    }
+    printf("hysteresis_ppm,%d\r\n", CONFIG_SENSOR_EVENTS_CO2_HYSTERESIS_PPM);
+    return ESP_OK;
+}
+
+static console::engine events_console;
+
+static esp_err_t events_dispatch(int argc, char **argv)
+{
+    if (argc <= 0) {
+        events_console.for_each_command(console::print_description, NULL);
+        return ESP_OK;
+    }
+    return events_console.exec_command(argc, argv);
+}
+
+esp_err_t register_commands()
+{
+    static const console::command_t command = {
+        .name = "events",
+        .description = "Sensor events. Usage: matter esp events <stats|thresholds [ppm ...]>.",
+        .handler = events_dispatch,
+    };
+
+    static const console::command_t events_commands[] = {
+        {
+            .name = "stats",
+            .description = "Print how many category change and CO2 threshold events were logged",
+            .handler = events_stats_handler,
+        },
+        {
+            .name = "thresholds",
+            .description = "Print the CO2 thresholds, or replace them until reboot. Usage: thresholds [ppm ...]",
+            .handler = events_thresholds_handler,
+        },
+    };
+    events_console.register_commands(events_commands, sizeof(events_commands) / sizeof(console::command_t));
+
+    return console::add_commands(&command, 1);
+}
+#endif
+
+} // namespace sensor_events
@@ -0,0 +1,126 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <esp_err.h>
+#ifdef ESP_PLATFORM
+#include <esp_matter.h>
+#endif
+
+#include <sdkconfig.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <measurement-pipeline.h>
+
+/** Edge-triggered Matter events for the sensor endpoint
+ *
+ * Two manufacturer-specific events are logged, both at Info priority, with `CONFIG_SENSOR_VENDOR_ID` in the upper 16
+ * bits of their IDs:
+ * - AirQualityChanged (event 0x0000) on the AirQuality cluster whenever the published category changes.
+ * - CO2ThresholdCrossed (event 0x0001) on the CarbonDioxideConcentrationMeasurement cluster whenever the published CO2
+ *   goes above a threshold, or back below it minus the hysteresis.
+ *
+ * The event data is a TLV structure with context tags:
+ * - AirQualityChanged: 0 sample_time_ms (uint64), 1 previous_air_quality (uint8), 2 air_quality (uint8), 3 co2_ppm
+ *   (uint16). The air quality values are those of AirQualityEnum, 0 for Unknown before the first sample.
+ * - CO2ThresholdCrossed: 0 sample_time_ms (uint64), 1 threshold_ppm (uint16), 2 rising (bool, false when falling back
+ *   below it), 3 co2_ppm (uint16).
+ *
+ * `sample_time_ms` is the virtual_clock time the sample was read, in milliseconds since boot.
+ *
+ * Every event carries the time the sample was read and the CO2 value that caused it. Events are logged whether or not
+ * anyone is subscribed; the event buffers keep them, in event number order, until a controller reads or resubscribes
+ * from its last seen event number.
+ */
+namespace sensor_events {
+
+/** Manufacturer-specific event IDs */
+static constexpr uint32_t k_air_quality_changed_event_id = ((uint32_t)CONFIG_SENSOR_VENDOR_ID << 16) | 0x0000;
+static constexpr uint32_t k_co2_threshold_crossed_event_id = ((uint32_t)CONFIG_SENSOR_VENDOR_ID << 16) | 0x0001;
+
+/** Most CO2 thresholds tracked at once */
+static constexpr size_t k_max_thresholds = 4;
+
+/** Event counters */
+typedef struct {
+    uint32_t category_changes;    /* AirQualityChanged events logged */
+    uint32_t threshold_crossings; /* CO2ThresholdCrossed events logged */
+    uint32_t log_failures;        /* Events the event log refused */
+    uint64_t last_event_number;   /* Event number of the last event logged, 0 if none */
+} stats_t;
+
+#ifdef ESP_PLATFORM
+/** Declare the events on the sensor endpoint, then `init()` with its id
+ *
+ * @param[in] sensor_endpoint Endpoint hosting the AirQuality and CO2 concentration clusters.
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t init(esp_matter::endpoint_t *sensor_endpoint);
+#endif
+
+/** Log the events for the sensor endpoint and load the thresholds from Kconfig
+ *
+ * Warns when the event buffers cannot hold `CONFIG_SENSOR_EVENTS_BACKLOG` events. The Linux build calls this directly,
+ * its data model being generated.
+ *
+ * @param[in] endpoint_id Endpoint hosting the AirQuality and CO2 concentration clusters.
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t init(uint16_t endpoint_id);
+
+/** Log the events caused by a published sample
+ *
+ * The first sample sets the threshold states without logging crossings, and logs the category change from Unknown.
+ * Must be called from the Matter event loop, in acquisition order.
+ *
+ * @param[in] result Values that were just published.
+ * @param[in] timestamp_us Time the sample was read, in virtual_clock microseconds.
+ */
+void on_sample(const measurement_pipeline::result_t &result, int64_t timestamp_us);
+
+/** Replace the CO2 thresholds
+ *
+ * The thresholds are sorted; their states are set again from the next sample, without logging crossings. The change
+ * is kept in RAM only.
+ *
+ * @param[in] thresholds_ppm Thresholds in ppm, none of them 0.
+ * @param[in] count Number of thresholds, at most `k_max_thresholds`.
+ *
+ * @return ESP_OK on success.
+ * @return ESP_ERR_INVALID_ARG if a threshold is 0 or there are too many.
+ */
+esp_err_t set_thresholds(const uint16_t *thresholds_ppm, size_t count);
+
+/** Copy the current CO2 thresholds, lowest first
+ *
+ * @param[out] thresholds_ppm Destination array.
+ * @param[in] max_count Capacity of `thresholds_ppm`.
+ *
+ * @return Number of thresholds copied.
+ */
+size_t get_thresholds(uint16_t *thresholds_ppm, size_t max_count);
+
+/** Copy the event counters */
+void get_stats(stats_t *stats);
+
+#ifdef ESP_PLATFORM
+/** Register the `events` console commands
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t register_commands();
+#endif
+
+} // namespace sensor_events
@@ -0,0 +1,451 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <sensor-history.h>
+#include <virtual-clock.h>
+
+#include <esp_log.h>
+#ifdef ESP_PLATFORM
+#include <esp_heap_caps.h>
+#include <esp_matter_console.h>
+#endif
+#include <freertos/FreeRTOS.h>
+#include <sdkconfig.h>
+
+#include <inttypes.h>
+#ifndef ESP_PLATFORM
+#include <malloc.h>
+#endif
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <app/clusters/diagnostic-logs-server/diagnostic-logs-server.h>
+#include <system/SystemClock.h>
+
+static const char *TAG = "sensor_history";
+
+#ifdef ESP_PLATFORM
+using namespace esp_matter;
+#endif
+using namespace chip;
+using namespace chip::app::Clusters::DiagnosticLogs;
+
+namespace sensor_history {
+
+/* One interval, temperature and humidity in hundredths */
+typedef struct {
+    uint16_t co2_ppm;
+    int16_t temperature_c_deg_c;
+    uint16_t humidity_c_percent_rh;
+} record_t;
+
+/* CO2 value of an interval without samples */
+static const uint16_t k_missing = UINT16_MAX;
+
+static const char k_csv_header[] = "time_s,co2_ppm,temperature_c,humidity_percent\n";
+
+static const uint32_t k_capacity = CONFIG_SENSOR_HISTORY_RECORDS;
+static const int64_t k_interval_us = (int64_t)CONFIG_SENSOR_HISTORY_INTERVAL_S * 1000000;
+
+static record_t s_ring[CONFIG_SENSOR_HISTORY_RECORDS];
+static uint32_t s_next_seq = 0;       /* Sequence number of the next record to close */
+static int64_t s_base_interval = 0;   /* Interval index of sequence number 0 */
+static int64_t s_current_interval = 0;
+static bool s_started = false;
+static uint32_t s_count = 0;
+static uint32_t s_co2_sum = 0;
+static int64_t s_temperature_sum = 0;
+static int64_t s_humidity_sum = 0;
+static stats_t s_stats;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static uint32_t oldest_seq_locked()
+{
+    return s_next_seq > k_capacity ? s_next_seq - k_capacity : 0;
+}
+
+static void push_locked(const record_t &record)
+{
+    s_ring[s_next_seq % k_capacity] = record;
+    s_next_seq++;
+}
+
+static void close_interval()
+{
+    record_t record = { k_missing, 0, 0 };
+    if (s_count > 0) {
+        uint32_t co2_ppm = (s_co2_sum + s_count / 2) / s_count;
+        record.co2_ppm = co2_ppm < k_missing ? co2_ppm : k_missing - 1;
+        /* m°C and m%RH to hundredths, rounded; the sensor range keeps both well inside 16 bits */
+        int64_t temperature_m_deg_c = s_temperature_sum / s_count;
+        int64_t humidity_m_percent_rh = s_humidity_sum / s_count;
+        record.temperature_c_deg_c = (int16_t)((temperature_m_deg_c + (temperature_m_deg_c >= 0 ? 5 : -5)) / 10);
+        record.humidity_c_percent_rh = (uint16_t)((humidity_m_percent_rh + 5) / 10);
+    }
+    taskENTER_CRITICAL(&s_lock);
+    push_locked(record);
+    taskEXIT_CRITICAL(&s_lock);
+
+    s_count = 0;
+    s_co2_sum = 0;
+    s_temperature_sum = 0;
+    s_humidity_sum = 0;
+}
+
+static void clear()
+{
+    taskENTER_CRITICAL(&s_lock);
+    s_next_seq = 0;
+    taskEXIT_CRITICAL(&s_lock);
+    s_count = 0;
+    s_co2_sum = 0;
+    s_temperature_sum = 0;
+    s_humidity_sum = 0;
+    s_started = false;
+}
+
+void on_sample(const measurement_pipeline::result_t &result, int64_t timestamp_us)
+{
+    int64_t interval = timestamp_us / k_interval_us;
+    if (s_started && interval < s_current_interval) {
+        ESP_LOGW(TAG, "Time went backwards, history cleared");
+        clear();
+    }
+    if (!s_started) {
+        s_base_interval = interval;
+        s_current_interval = interval;
+        s_started = true;
+    }
+
+    if (interval > s_current_interval) {
+        close_interval();
+        /* Gaps are written as missing records; past a full ring only the sequence number needs to move */
+        int64_t gap = interval - s_current_interval - 1;
+        int64_t written = gap < k_capacity ? gap : k_capacity;
+        record_t missing = { k_missing, 0, 0 };
+        taskENTER_CRITICAL(&s_lock);
+        for (int64_t i = 0; i < written; i++) {
+            push_locked(missing);
+        }
+        s_next_seq += (uint32_t)(gap - written);
+        taskEXIT_CRITICAL(&s_lock);
+        s_current_interval = interval;
+    }
+
+    s_count++;
+    s_co2_sum += result.co2_ppm;
+    s_temperature_sum += result.temperature_m_deg_c;
+    s_humidity_sum += result.humidity_m_percent_rh;
+}
+
+void open_cursor(cursor_t *cursor)
+{
+    taskENTER_CRITICAL(&s_lock);
+    cursor->next_seq = oldest_seq_locked();
+    cursor->end_seq = s_next_seq;
+    taskEXIT_CRITICAL(&s_lock);
+    cursor->header_done = false;
+    cursor->skipped = 0;
+}
+
+/* Hundredths as a fixed-point decimal */
+static int format_hundredths(char *buffer, size_t size, int32_t value)
+{
+    uint32_t magnitude = value < 0 ? (uint32_t)(-value) : (uint32_t)value;
+    return snprintf(buffer, size, "%s%" PRIu32 ".%02" PRIu32, value < 0 ? "-" : "", magnitude / 100, magnitude % 100);
+}
+
+size_t read_csv(cursor_t *cursor, char *buffer, size_t size)
+{
+    size_t used = 0;
+    if (!cursor->header_done) {
+        if (size < sizeof(k_csv_header) - 1) {
+            return 0;
+        }
+        memcpy(buffer, k_csv_header, sizeof(k_csv_header) - 1);
+        used = sizeof(k_csv_header) - 1;
+        cursor->header_done = true;
+    }
+
+    while (cursor->next_seq < cursor->end_seq && size - used >= k_max_line_len) {
+        taskENTER_CRITICAL(&s_lock);
+        uint32_t oldest_seq = oldest_seq_locked();
+        if (cursor->next_seq < oldest_seq) {
+            cursor->skipped += oldest_seq - cursor->next_seq;
+            cursor->next_seq = oldest_seq;
+        }
+        record_t record = s_ring[cursor->next_seq % k_capacity];
+        uint32_t time_s = (uint32_t)((s_base_interval + cursor->next_seq) * CONFIG_SENSOR_HISTORY_INTERVAL_S);
+        taskEXIT_CRITICAL(&s_lock);
+        cursor->next_seq++;
+
+        if (record.co2_ppm == k_missing) {
+            continue;
+        }
+        char temperature[12];
+        char humidity[12];
+        format_hundredths(temperature, sizeof(temperature), record.temperature_c_deg_c);
+        format_hundredths(humidity, sizeof(humidity), record.humidity_c_percent_rh);
+        used += snprintf(buffer + used, size - used, "%" PRIu32 ",%u,%s,%s\n", time_s, record.co2_ppm, temperature,
+                         humidity);
+    }
+    return used;
+}
+
+size_t max_csv_size()
+{
+    taskENTER_CRITICAL(&s_lock);
+    uint32_t records = s_next_seq - oldest_seq_locked();
+    taskEXIT_CRITICAL(&s_lock);
+    return sizeof(k_csv_header) - 1 + (size_t)records * k_max_line_len;
+}
+
+void get_stats(stats_t *stats)
+{
+    taskENTER_CRITICAL(&s_lock);
+    *stats = s_stats;
+    stats->records = s_next_seq - oldest_seq_locked();
+    taskEXIT_CRITICAL(&s_lock);
+    stats->interval_s = CONFIG_SENSOR_HISTORY_INTERVAL_S;
+}
+
+/* Free heap on target. glibc has no such figure, so on Linux it is the bytes in use counted down from SIZE_MAX, which
+ * drops by as much as the heap use grows. */
+static size_t free_heap_bytes()
+{
+#ifdef ESP_PLATFORM
+    return heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+#else
+    return SIZE_MAX - mallinfo2().uordblks;
+#endif
+}
+
+namespace {
+
+/* Transfer timing is real time: virtual_clock runs sped up on Linux with a short --sample-period-ms */
+uint64_t monotonic_us()
+{
+    return System::SystemClock().GetMonotonicMicroseconds64().count();
+}
+
+/* Serves the history as the EndUserSupport log. The Diagnostic Logs server pulls one block per BDX block, in the
+ * Matter event loop, so a single cursor is all the state a download needs. */
+class HistoryLogProvider : public DiagnosticLogsProviderDelegate
+{
+public:
+    CHIP_ERROR StartLogCollection(IntentEnum intent, LogSessionHandle &outHandle, Optional<uint64_t> &outTimeStamp,
+                                  Optional<uint64_t> &outTimeSinceBoot) override
+    {
+        if (intent != IntentEnum::kEndUserSupport) {
+            return CHIP_ERROR_NOT_FOUND;
+        }
+        if (mActive) {
+            return CHIP_ERROR_BUSY;
+        }
+        open_cursor(&mCursor);
+        mActive = true;
+        mHandle++;
+        if (mHandle == kInvalidLogSessionHandle) {
+            mHandle++;
+        }
+        mBytes = 0;
+        mBlocks = 0;
+        mFirstBlockUs = 0;
+        mLastBlockUs = 0;
+        mStartFree = free_heap_bytes();
+        mMinFree = mStartFree;
+        outHandle = mHandle;
+        outTimeSinceBoot.SetValue((uint64_t)virtual_clock::now_us());
+        return CHIP_NO_ERROR;
+    }
+
+    CHIP_ERROR CollectLog(LogSessionHandle sessionHandle, MutableByteSpan &outBuffer, bool &outIsEndOfLog) override
+    {
+        if (!mActive || sessionHandle != mHandle) {
+            return CHIP_ERROR_INCORRECT_STATE;
+        }
+        uint64_t now_us = monotonic_us();
+        if (mBlocks == 0) {
+            mFirstBlockUs = now_us;
+        }
+        mLastBlockUs = now_us;
+        mBlocks++;
+        size_t used = read_csv(&mCursor, (char *)outBuffer.data(), outBuffer.size());
+        outBuffer.reduce_size(used);
+        outIsEndOfLog = mCursor.next_seq >= mCursor.end_seq;
+        if (mBlocks == 1) {
+            mFirstBlockBytes = (uint32_t)used;
+        }
+        mBytes += used;
+
+        size_t free_bytes = free_heap_bytes();
+        mMinFree = free_bytes < mMinFree ? free_bytes : mMinFree;
+        return CHIP_NO_ERROR;
+    }
+
+    CHIP_ERROR EndLogCollection(LogSessionHandle sessionHandle) override
+    {
+        if (!mActive || sessionHandle != mHandle) {
+            return CHIP_ERROR_INCORRECT_STATE;
+        }
+        mActive = false;
+
+        uint64_t duration_us = mLastBlockUs - mFirstBlockUs;
+        uint32_t duration_ms = (uint32_t)(duration_us / 1000);
+        /* Each block after the first one took a round trip within that time */
+        uint32_t bytes_per_s =
+            duration_us > 0 ? (uint32_t)((uint64_t)(mBytes - mFirstBlockBytes) * 1000000 / duration_us) : 0;
+        uint32_t peak_heap_bytes = (uint32_t)(mStartFree - mMinFree);
+        taskENTER_CRITICAL(&s_lock);
+        s_stats.transfers++;
+        s_stats.last_bytes = mBytes;
+        s_stats.last_duration_ms = duration_ms;
+        s_stats.last_bytes_per_s = bytes_per_s;
+        s_stats.last_peak_heap_bytes = peak_heap_bytes;
+        taskEXIT_CRITICAL(&s_lock);
+        ESP_LOGI(TAG, "History sent: %" PRIu32 " bytes in %" PRIu32 " ms (%" PRIu32 " B/s), peak heap %" PRIu32
+                      " bytes, %" PRIu32 " records overwritten during the transfer",
+                 mBytes, duration_ms, bytes_per_s, peak_heap_bytes, mCursor.skipped);
+        return CHIP_NO_ERROR;
+    }
+
+    size_t GetSizeForIntent(IntentEnum intent) override
+    {
+        return intent == IntentEnum::kEndUserSupport ? max_csv_size() : 0;
+    }
+
+    /* Small histories go inline in the response; whatever fits, oldest first */
+    CHIP_ERROR GetLogForIntent(IntentEnum intent, MutableByteSpan &outBuffer, Optional<uint64_t> &outTimeStamp,
+                               Optional<uint64_t> &outTimeSinceBoot) override
+    {
+        if (intent != IntentEnum::kEndUserSupport) {
+            return CHIP_ERROR_NOT_FOUND;
+        }
+        cursor_t cursor;
+        open_cursor(&cursor);
+        size_t used = 0;
+        size_t chunk = 0;
+        do {
+            chunk = read_csv(&cursor, (char *)outBuffer.data() + used, outBuffer.size() - used);
+            used += chunk;
+        } while (chunk > 0);
+        outBuffer.reduce_size(used);
+        outTimeSinceBoot.SetValue((uint64_t)virtual_clock::now_us());
+        return CHIP_NO_ERROR;
+    }
+
+private:
+    cursor_t mCursor;
+    bool mActive = false;
+    LogSessionHandle mHandle = kInvalidLogSessionHandle;
+    uint32_t mBytes = 0;
+    uint32_t mBlocks = 0;
+    uint32_t mFirstBlockBytes = 0;
+    uint64_t mFirstBlockUs = 0; /* monotonic_us() of the first and the last block requested */
+    uint64_t mLastBlockUs = 0;
+    size_t mStartFree = 0;
+    size_t mMinFree = 0;
+};
+
+HistoryLogProvider s_log_provider;
+
+} // namespace
+
+void set_log_provider(uint16_t endpoint_id)
+{
+    DiagnosticLogsServer::Instance().SetDiagnosticLogsProviderDelegate(endpoint_id, &s_log_provider);
+}
+
+#ifdef ESP_PLATFORM
+esp_err_t add_diagnostic_logs_cluster(node_t *node)
+{
+    endpoint_t *root_endpoint = endpoint::get(node, 0);
+    if (!root_endpoint) {
+        ESP_LOGE(TAG, "Root endpoint not found");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    /* The delegate is set through the config as well, so the cluster init callback does not clear it */
+    cluster::diagnostic_logs::config_t diagnostic_logs_config;
+    diagnostic_logs_config.delegate = &s_log_provider;
+    if (!cluster::diagnostic_logs::create(root_endpoint, &diagnostic_logs_config, CLUSTER_FLAG_SERVER)) {
+        ESP_LOGE(TAG, "Failed to create diagnostic logs cluster");
+        return ESP_FAIL;
+    }
+    set_log_provider(endpoint::get_id(root_endpoint));
+    return ESP_OK;
+}
+
+static esp_err_t history_stats_handler(int argc, char **argv)
+{
+    stats_t stats;
+    get_stats(&stats);
+
+    printf("records,%" PRIu32 "\r\n", stats.records);
+    printf("capacity,%" PRIu32 "\r\n", k_capacity);
+    printf("interval_s,%" PRIu32 "\r\n", stats.interval_s);
+    printf("transfers,%" PRIu32 "\r\n", stats.transfers);
+    printf("last_bytes,%" PRIu32 "\r\n", stats.last_bytes);
+    printf("last_duration_ms,%" PRIu32 "\r\n", stats.last_duration_ms);
+    printf("last_bytes_per_s,%" PRIu32 "\r\n", stats.last_bytes_per_s);
+    printf("last_peak_heap_bytes,%" PRIu32 "\r\n", stats.last_peak_heap_bytes);
+    return ESP_OK;
+}
+
+/* Same generator as the BDX download, through a small stack buffer */
+static esp_err_t history_dump_handler(int argc, char **argv)
+{
+    cursor_t cursor;
+    open_cursor(&cursor);
+    char buffer[4 * k_max_line_len];
+    size_t used = 0;
+    while ((used = read_csv(&cursor, buffer, sizeof(buffer))) > 0) {
+        fwrite(buffer, 1, used, stdout);
+    }
+    return ESP_OK;
+}
+
+static console::engine history_console;
+
+static esp_err_t history_dispatch(int argc, char **argv)
+{
+    if (argc <= 0) {
+        history_console.for_each_command(console::print_description, NULL);
+        return ESP_OK;
+    }
+    return history_console.exec_command(argc, argv);
+}
+
+esp_err_t register_commands()
+{
+    static const console::command_t command = {
+        .name = "history",
+        .description = "Measurement history. Usage: matter esp history <stats|dump>.",
+        .handler = history_dispatch,
+    };
+
+    static const console::command_t history_commands[] = {
+        {
+            .name = "stats",
+            .description = "Print the history size and the size, throughput and peak heap of the last download",
+            .handler = history_stats_handler,
+        },
+        {
+            .name = "dump",
+            .description = "Print the history as the CSV file a download would produce",
+            .handler = history_dump_handler,
+        },
+    };
+    history_console.register_commands(history_commands, sizeof(history_commands) / sizeof(console::command_t));
+
+    return console::add_commands(&command, 1);
+}
+#endif
+
+} // namespace sensor_history
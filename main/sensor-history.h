@@ -0,0 +1,112 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <esp_err.h>
+#ifdef ESP_PLATFORM
+#include <esp_matter.h>
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <measurement-pipeline.h>
+
+/** On-device measurement history and its download over Bulk Data Exchange
+ *
+ * Samples are averaged over fixed intervals (`CONFIG_SENSOR_HISTORY_INTERVAL_S`) and the averages are kept in a RAM
+ * ring of `CONFIG_SENSOR_HISTORY_RECORDS` 6-byte records. Controllers download the ring as CSV through the Diagnostic
+ * Logs cluster on endpoint 0 (EndUserSupport intent): the file is generated a block at a time while the BDX transfer
+ * runs, straight from the ring, so it never exists in RAM as a whole.
+ */
+namespace sensor_history {
+
+/** Longest CSV line produced, terminator included */
+static constexpr size_t k_max_line_len = 48;
+
+/** Position in the CSV stream */
+typedef struct {
+    uint32_t next_seq;  /* Next record to emit */
+    uint32_t end_seq;   /* Record after the last one to emit, fixed when the cursor is opened */
+    bool header_done;   /* Column header already emitted */
+    uint32_t skipped;   /* Records overwritten by new ones before they could be emitted */
+} cursor_t;
+
+/** History counters and the figures of the last download */
+typedef struct {
+    uint32_t records;            /* Records currently in the ring, including intervals without samples */
+    uint32_t interval_s;         /* Time covered by one record */
+    uint32_t transfers;          /* Downloads completed */
+    uint32_t last_bytes;         /* Size of the last download */
+    uint32_t last_duration_ms;   /* Real time from the first to the last block requested in the last download */
+    uint32_t last_bytes_per_s;   /* Bytes after the first block over that time, 0 for a single block */
+    uint32_t last_peak_heap_bytes; /* Largest drop in free heap below its value at the start of the last download */
+} stats_t;
+
+#ifdef ESP_PLATFORM
+/** Add the Diagnostic Logs cluster to the root endpoint and serve the history through it
+ *
+ * @param[in] node Matter node created by the application.
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t add_diagnostic_logs_cluster(esp_matter::node_t *node);
+#endif
+
+/** Serve the history through the Diagnostic Logs cluster of `endpoint_id`
+ *
+ * For a data model that already has the cluster, like the generated one of the Linux build; must be called once the
+ * server is initialised.
+ */
+void set_log_provider(uint16_t endpoint_id);
+
+/** Add a published sample to the current interval
+ *
+ * Closes the previous interval when the sample falls into a new one; intervals without samples are kept as gaps so
+ * every record sits at a fixed time. The history is cleared if time goes backwards (e.g. leaving simulated time). Must
+ * be called from the Matter event loop.
+ *
+ * @param[in] result Values that were just published.
+ * @param[in] timestamp_us Time the sample was read, in virtual_clock microseconds.
+ */
+void on_sample(const measurement_pipeline::result_t &result, int64_t timestamp_us);
+
+/** Open a cursor over the records closed so far, oldest first */
+void open_cursor(cursor_t *cursor);
+
+/** Emit the next CSV lines of a cursor
+ *
+ * Writes whole lines only: `time_s,co2_ppm,temperature_c,humidity_percent`, time in virtual_clock seconds at the
+ * start of the interval. Intervals without samples are left out.
+ *
+ * @param[inout] cursor Cursor returned by `open_cursor()`.
+ * @param[out] buffer Destination, not NUL-terminated.
+ * @param[in] size Capacity of `buffer`, at least `k_max_line_len` to make progress.
+ *
+ * @return Number of bytes written; 0 once the cursor is exhausted.
+ */
+size_t read_csv(cursor_t *cursor, char *buffer, size_t size);
+
+/** Upper bound of the CSV size for the records currently in the ring */
+size_t max_csv_size();
+
+/** Copy the history counters */
+void get_stats(stats_t *stats);
+
+#ifdef ESP_PLATFORM
+/** Register the `history` console commands
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t register_commands();
+#endif
+
+} // namespace sensor_history
@@ -0,0 +1,374 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <pressure-compensation.h>
+#include <sampling-policy.h>
+#include <sensor-bus.h>
+#include <sensor-config.h>
+#include <sensor-maintenance.h>
+#include <virtual-clock.h>
+
+#include <esp_log.h>
+#include <esp_matter_console.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+#include <platform/CHIPDeviceLayer.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "drivers/scd4x_i2c.h"
+#include "drivers/sensirion_common.h"
+
+static const char *TAG = "sensor_maint";
+
+using namespace esp_matter;
+
+namespace sensor_maintenance {
+
+/* stop_periodic_measurement plus the restart */
+static const uint32_t k_stop_restart_ms = 500 + 1;
+/* perform_forced_recalibration answers 0xffff when the recalibration failed */
+static const uint16_t k_frc_failed = 0xffff;
+/* Job failures that do not come from the driver */
+static const int16_t k_error_frc_rejected = -1;
+static const int16_t k_error_config_cache = -2;
+
+typedef struct {
+    job_type_t type;
+    uint16_t argument;
+} job_request_t;
+
+static QueueHandle_t s_queue = NULL;
+static job_status_t s_status;
+static bool s_busy = false;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static const char *job_name(job_type_t type)
+{
+    switch (type) {
+    case JOB_SELF_TEST:
+        return "selftest";
+    case JOB_FORCED_RECALIBRATION:
+        return "frc";
+    case JOB_FACTORY_RESET:
+        return "factoryreset";
+    case JOB_PERSIST_SETTINGS:
+        return "persist";
+    case JOB_SWITCH_PROFILE:
+        return "profile";
+    case JOB_APPLY_CONFIG:
+        return "config";
+    default:
+        return "none";
+    }
+}
+
+static const char *state_name(job_state_t state)
+{
+    switch (state) {
+    case JOB_STATE_QUEUED:
+        return "queued";
+    case JOB_STATE_RUNNING:
+        return "running";
+    case JOB_STATE_DONE:
+        return "done";
+    case JOB_STATE_FAILED:
+        return "failed";
+    default:
+        return "idle";
+    }
+}
+
+static uint32_t expected_ms(job_type_t type)
+{
+    switch (type) {
+    case JOB_SELF_TEST:
+        return k_stop_restart_ms + 10000;
+    case JOB_FORCED_RECALIBRATION:
+        return k_stop_restart_ms + 400;
+    case JOB_FACTORY_RESET:
+        return k_stop_restart_ms + 1200;
+    case JOB_PERSIST_SETTINGS:
+        return k_stop_restart_ms + 800;
+    case JOB_SWITCH_PROFILE:
+        return k_stop_restart_ms;
+    case JOB_APPLY_CONFIG:
+        /* One 1 ms set command per changed setting */
+        return k_stop_restart_ms + 6;
+    default:
+        return 0;
+    }
+}
+
+/* The command itself; the sensor is idle and owned by the job task */
+static int16_t run_command(const job_request_t &request, int32_t *result)
+{
+    int16_t error = NO_ERROR;
+    *result = 0;
+
+    switch (request.type) {
+    case JOB_SELF_TEST: {
+        uint16_t sensor_status = 0;
+        error = scd4x_perform_self_test(&sensor_status);
+        *result = sensor_status;
+        break;
+    }
+    case JOB_FORCED_RECALIBRATION: {
+        uint16_t correction = k_frc_failed;
+        error = scd4x_perform_forced_recalibration(request.argument, &correction);
+        if (error == NO_ERROR && correction == k_frc_failed) {
+            error = k_error_frc_rejected;
+        }
+        *result = error == NO_ERROR ? (int32_t)correction - 0x8000 : 0;
+        break;
+    }
+    case JOB_FACTORY_RESET:
+        error = scd4x_perform_factory_reset();
+        /* Even a failed reset may have restored the default ambient pressure */
+        pressure_compensation::on_sensor_reset();
+        if (error == NO_ERROR) {
+            error = sensor_config::reload() == ESP_OK ? NO_ERROR : k_error_config_cache;
+        }
+        break;
+    case JOB_PERSIST_SETTINGS:
+        error = sensor_config::persist() == ESP_OK ? NO_ERROR : k_error_config_cache;
+        break;
+    case JOB_APPLY_CONFIG:
+        error = sensor_config::write_pending() == ESP_OK ? NO_ERROR : k_error_config_cache;
+        break;
+    default:
+        break;
+    }
+    return error;
+}
+
+static void run_job(const job_request_t &request)
+{
+    /* Every other SCD4x access checks busy() with the bus locked, so taking the bus lock guarantees no command is in
+     * flight when the sensor changes hands. The long part of the job runs without the lock. */
+    sensor_bus::lock();
+    taskENTER_CRITICAL(&s_lock);
+    s_busy = true;
+    s_status.state = JOB_STATE_RUNNING;
+    s_status.started_us = virtual_clock::now_us();
+    taskEXIT_CRITICAL(&s_lock);
+    sensor_bus::unlock();
+
+    ESP_LOGI(TAG, "Running %s", job_name(request.type));
+    int32_t result = 0;
+    int16_t error = scd4x_stop_periodic_measurement();
+    if (error == NO_ERROR) {
+        error = run_command(request, &result);
+    } else if (request.type == JOB_APPLY_CONFIG) {
+        /* Nothing was written; let a later apply() queue again */
+        sensor_config::drop_pending();
+    }
+
+    /* The acquisition profile belongs to the Matter event loop */
+    chip::DeviceLayer::PlatformMgr().LockChipStack();
+    sensor_bus::lock();
+    /* A profile switch has nothing to run while the sensor is idle; the restart below starts the new profile */
+    if (request.type == JOB_SWITCH_PROFILE && error == NO_ERROR) {
+        sampling_policy::set_profile((sampling_policy::acquisition_profile_t)request.argument);
+    }
+    int16_t restart_error = sampling_policy::start_measurement();
+    error = error != NO_ERROR ? error : restart_error;
+    taskENTER_CRITICAL(&s_lock);
+    s_status.error = error;
+    s_status.result = result;
+    s_status.state = error == NO_ERROR ? JOB_STATE_DONE : JOB_STATE_FAILED;
+    s_status.finished_us = virtual_clock::now_us();
+    s_busy = false;
+    taskEXIT_CRITICAL(&s_lock);
+    sensor_bus::unlock();
+    chip::DeviceLayer::PlatformMgr().UnlockChipStack();
+
+    ESP_LOGI(TAG, "%s %s, error:%d result:%" PRId32, job_name(request.type), error == NO_ERROR ? "done" : "failed",
+             error, result);
+}
+
+static void job_task(void *arg)
+{
+    job_request_t request;
+    while (true) {
+        if (xQueueReceive(s_queue, &request, portMAX_DELAY) == pdTRUE) {
+            run_job(request);
+        }
+    }
+}
+
+esp_err_t init()
+{
+    s_queue = xQueueCreate(1, sizeof(job_request_t));
+    if (s_queue == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (xTaskCreate(job_task, "sensor_maint", 3072, NULL, 5, NULL) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t start(job_type_t type, uint16_t argument)
+{
+    if (s_queue == NULL || type == JOB_NONE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    taskENTER_CRITICAL(&s_lock);
+    bool pending = s_status.state == JOB_STATE_QUEUED || s_status.state == JOB_STATE_RUNNING;
+    if (!pending) {
+        memset(&s_status, 0, sizeof(s_status));
+        s_status.type = type;
+        s_status.state = JOB_STATE_QUEUED;
+        s_status.expected_ms = expected_ms(type);
+    }
+    taskEXIT_CRITICAL(&s_lock);
+    if (pending) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    job_request_t request = {.type = type, .argument = argument};
+    return xQueueSend(s_queue, &request, 0) == pdTRUE ? ESP_OK : ESP_FAIL;
+}
+
+bool busy()
+{
+    taskENTER_CRITICAL(&s_lock);
+    bool is_busy = s_busy;
+    taskEXIT_CRITICAL(&s_lock);
+    return is_busy;
+}
+
+void get_status(job_status_t *status)
+{
+    taskENTER_CRITICAL(&s_lock);
+    *status = s_status;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+uint8_t get_progress()
+{
+    job_status_t status;
+    get_status(&status);
+    if (status.state == JOB_STATE_DONE || status.state == JOB_STATE_FAILED) {
+        return 100;
+    }
+    if (status.state != JOB_STATE_RUNNING || status.expected_ms == 0) {
+        return 0;
+    }
+    /* The driver sleeps through the command, so time is the only progress measure; hold at 99 until it returns */
+    int64_t elapsed_ms = (virtual_clock::now_us() - status.started_us) / 1000;
+    return (uint8_t)(elapsed_ms >= status.expected_ms ? 99 : elapsed_ms * 100 / status.expected_ms);
+}
+
+static esp_err_t start_handler(job_type_t type, uint16_t argument)
+{
+    esp_err_t err = start(type, argument);
+    if (err == ESP_ERR_INVALID_STATE) {
+        printf("A job is already running\r\n");
+    }
+    return err;
+}
+
+static esp_err_t maint_selftest_handler(int argc, char **argv)
+{
+    return start_handler(JOB_SELF_TEST, 0);
+}
+
+static esp_err_t maint_frc_handler(int argc, char **argv)
+{
+    if (argc != 1) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return start_handler(JOB_FORCED_RECALIBRATION, (uint16_t)strtoul(argv[0], NULL, 0));
+}
+
+static esp_err_t maint_factoryreset_handler(int argc, char **argv)
+{
+    return start_handler(JOB_FACTORY_RESET, 0);
+}
+
+static esp_err_t maint_persist_handler(int argc, char **argv)
+{
+    return start_handler(JOB_PERSIST_SETTINGS, 0);
+}
+
+static esp_err_t maint_status_handler(int argc, char **argv)
+{
+    job_status_t status;
+    get_status(&status);
+
+    printf("job,%s\r\n", job_name(status.type));
+    printf("state,%s\r\n", state_name(status.state));
+    printf("progress_percent,%u\r\n", get_progress());
+    printf("expected_ms,%" PRIu32 "\r\n", status.expected_ms);
+    if (status.finished_us != 0) {
+        printf("duration_ms,%" PRId64 "\r\n", (status.finished_us - status.started_us) / 1000);
+    }
+    printf("error,%d\r\n", status.error);
+    printf("result,%" PRId32 "\r\n", status.result);
+    return ESP_OK;
+}
+
+static console::engine maint_console;
+
+static esp_err_t maint_dispatch(int argc, char **argv)
+{
+    if (argc <= 0) {
+        maint_console.for_each_command(console::print_description, NULL);
+        return ESP_OK;
+    }
+    return maint_console.exec_command(argc, argv);
+}
+
+esp_err_t register_commands()
+{
+    static const console::command_t command = {
+        .name = "maint",
+        .description = "SCD4x maintenance jobs. Usage: matter esp maint <selftest|frc|factoryreset|persist|status>.",
+        .handler = maint_dispatch,
+    };
+
+    static const console::command_t maint_commands[] = {
+        {
+            .name = "selftest",
+            .description = "Run the sensor self test (~10 s) in the background",
+            .handler = maint_selftest_handler,
+        },
+        {
+            .name = "frc",
+            .description = "Run a forced recalibration. Usage: matter esp maint frc <target_ppm>",
+            .handler = maint_frc_handler,
+        },
+        {
+            .name = "factoryreset",
+            .description = "Restore the sensor factory settings and reload the configuration cache",
+            .handler = maint_factoryreset_handler,
+        },
+        {
+            .name = "persist",
+            .description = "Persist the cached configuration to the sensor EEPROM now",
+            .handler = maint_persist_handler,
+        },
+        {
+            .name = "status",
+            .description = "Print the state, progress and result of the current or last job",
+            .handler = maint_status_handler,
+        },
+    };
+    maint_console.register_commands(maint_commands, sizeof(maint_commands) / sizeof(console::command_t));
+
+    return console::add_commands(&command, 1);
+}
+
+} // namespace sensor_maintenance
@@ -0,0 +1,86 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <esp_err.h>
+
+#include <stdint.h>
+
+namespace sensor_maintenance {
+
+/** Long-running SCD4x commands */
+typedef enum {
+    JOB_NONE = 0,
+    JOB_SELF_TEST,             /* perform_self_test, ~10 s */
+    JOB_FORCED_RECALIBRATION,  /* perform_forced_recalibration, ~400 ms */
+    JOB_FACTORY_RESET,         /* perform_factory_reset, ~1.2 s */
+    JOB_PERSIST_SETTINGS,      /* persist_settings, ~800 ms */
+    JOB_SWITCH_PROFILE,        /* Restart in another acquisition profile, ~500 ms */
+    JOB_APPLY_CONFIG,          /* Write the configuration queued by sensor_config::apply(), ~500 ms */
+} job_type_t;
+
+typedef enum {
+    JOB_STATE_IDLE = 0, /* No job was ever run */
+    JOB_STATE_QUEUED,
+    JOB_STATE_RUNNING,
+    JOB_STATE_DONE,
+    JOB_STATE_FAILED,
+} job_state_t;
+
+/** Progress and outcome of the current or last job */
+typedef struct {
+    job_type_t type;
+    job_state_t state;
+    int64_t started_us;     /* virtual_clock time the job took the sensor */
+    int64_t finished_us;    /* virtual_clock time the sensor was handed back, 0 while running */
+    uint32_t expected_ms;   /* Expected duration, including stopping and restarting measurement */
+    int16_t error;          /* Driver error code of the failed step, 0 if none */
+    int32_t result;         /* Self-test: sensor status (0 is OK). FRC: correction in ppm. Otherwise 0. */
+} job_status_t;
+
+/** Start the job runner task
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t init();
+
+/** Queue a maintenance job
+ *
+ * The job runs in its own task. It takes the sensor from the sampling path, stops periodic measurement, runs the
+ * command and restarts measurement in the current acquisition profile. Meanwhile the sample callback skips the
+ * sensor, so subscribers keep being served the last good measurement. Only one job runs at a time.
+ *
+ * @param[in] type Job to run.
+ * @param[in] argument Target CO2 concentration in ppm for forced recalibration, the `sampling_policy` acquisition
+ *                     profile to restart in for a profile switch, ignored otherwise.
+ *
+ * @return ESP_OK on success.
+ * @return ESP_ERR_INVALID_STATE if a job is already queued or running.
+ * @return error in case of failure.
+ */
+esp_err_t start(job_type_t type, uint16_t argument);
+
+/** True while a job owns the sensor; callers on the sampling path must not touch it */
+bool busy();
+
+/** Copy the status of the current or last job */
+void get_status(job_status_t *status);
+
+/** Progress of the running job in percent, estimated from its expected duration */
+uint8_t get_progress();
+
+/** Register the `maint` console commands
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t register_commands();
+
+} // namespace sensor_maintenance
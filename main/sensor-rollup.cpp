@@ -0,0 +1,406 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <sensor-rollup.h>
+
+#include <esp_log.h>
+#ifdef ESP_PLATFORM
+#include <esp_matter_console.h>
+#endif
+#include <freertos/FreeRTOS.h>
+#include <sdkconfig.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <app-common/zap-generated/ids/Clusters.h>
+
+static const char *TAG = "sensor_rollup";
+
+#ifdef ESP_PLATFORM
+using namespace esp_matter;
+using namespace chip::app::Clusters;
+#endif
+
+namespace sensor_rollup {
+
+static const int64_t k_max_hold_us = (int64_t)CONFIG_SENSOR_ROLLUP_MAX_HOLD_S * 1000000;
+static const uint32_t k_exposure_ppm = CONFIG_SENSOR_ROLLUP_EXPOSURE_PPM;
+static const uint32_t k_ms_per_hour = 3600000;
+
+/* Ring and open bucket of one level */
+typedef struct {
+    const char *name;
+    uint32_t length_s;
+    uint32_t capacity;
+    bucket_t *ring;
+    uint32_t next_seq;      /* Sequence number of the next bucket to close */
+    int64_t base_index;     /* Bucket index of sequence number 0 */
+    int64_t current_index;  /* Bucket index of the open bucket */
+    bucket_t current;
+} level_state_t;
+
+static bucket_t s_minutes[CONFIG_SENSOR_ROLLUP_MINUTES];
+static bucket_t s_hours[CONFIG_SENSOR_ROLLUP_HOURS];
+static bucket_t s_days[CONFIG_SENSOR_ROLLUP_DAYS];
+
+static level_state_t s_levels[LEVEL_MAX] = {
+    { "minute", 60, CONFIG_SENSOR_ROLLUP_MINUTES, s_minutes, 0, 0, 0, {} },
+    { "hour", 3600, CONFIG_SENSOR_ROLLUP_HOURS, s_hours, 0, 0, 0, {} },
+    { "day", 86400, CONFIG_SENSOR_ROLLUP_DAYS, s_days, 0, 0, 0, {} },
+};
+static bool s_started = false;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/* Matter event loop only */
+#ifdef ESP_PLATFORM
+static uint16_t s_endpoint_id = chip::kInvalidEndpointId;
+#endif
+static uint16_t s_held_ppm;  /* Last sample, held until the next one */
+static int64_t s_held_us;
+
+static const bucket_t k_empty = { 0, UINT16_MAX, 0, 0, 0, 0, 0 };
+
+static int64_t length_us(const level_state_t *level)
+{
+    return (int64_t)level->length_s * 1000000;
+}
+
+static uint32_t oldest_seq_locked(const level_state_t *level)
+{
+    return level->next_seq > level->capacity ? level->next_seq - level->capacity : 0;
+}
+
+static void push_locked(level_state_t *level, const bucket_t &bucket)
+{
+    level->ring[level->next_seq % level->capacity] = bucket;
+    level->next_seq++;
+}
+
+/* Account the held value over [from_us, to_us) */
+static void hold_locked(bucket_t *bucket, uint16_t co2_ppm, int64_t from_us, int64_t to_us)
+{
+    if (to_us <= from_us) {
+        return;
+    }
+    uint32_t held_ms = (uint32_t)((to_us - from_us) / 1000);
+    bucket->held_ms += held_ms;
+    bucket->weighted_ppm_ms += (uint64_t)co2_ppm * held_ms;
+    if (co2_ppm > k_exposure_ppm) {
+        bucket->exposure_ppm_ms += (uint64_t)(co2_ppm - k_exposure_ppm) * held_ms;
+    }
+}
+
+/* Account the part of [from_us, to_us) that falls in the bucket at `index` */
+static void hold_in_locked(const level_state_t *level, bucket_t *bucket, int64_t index, uint16_t co2_ppm,
+                           int64_t from_us, int64_t to_us)
+{
+    int64_t start_us = index * length_us(level);
+    int64_t end_us = start_us + length_us(level);
+    hold_locked(bucket, co2_ppm, from_us > start_us ? from_us : start_us, to_us < end_us ? to_us : end_us);
+}
+
+/* Close the open bucket and open the one at `index`. Buckets in between are kept without samples, and the rest of
+ * the hold over [from_us, to_us) is spread over them and the new bucket. Buckets that no longer fit in the ring are
+ * skipped. */
+static void advance_locked(level_state_t *level, int64_t index, uint16_t co2_ppm, int64_t from_us, int64_t to_us)
+{
+    push_locked(level, level->current);
+    int64_t gap = index - level->current_index - 1;
+    int64_t skipped = gap > level->capacity ? gap - level->capacity : 0;
+    level->next_seq += (uint32_t)skipped;
+    for (int64_t i = level->current_index + 1 + skipped; i < index; i++) {
+        bucket_t bucket = k_empty;
+        hold_in_locked(level, &bucket, i, co2_ppm, from_us, to_us);
+        push_locked(level, bucket);
+    }
+    level->current_index = index;
+    level->current = k_empty;
+    hold_in_locked(level, &level->current, index, co2_ppm, from_us, to_us);
+}
+
+static void add_locked(bucket_t *bucket, uint16_t co2_ppm)
+{
+    bucket->count++;
+    bucket->sum_ppm += co2_ppm;
+    bucket->min_ppm = co2_ppm < bucket->min_ppm ? co2_ppm : bucket->min_ppm;
+    bucket->max_ppm = co2_ppm > bucket->max_ppm ? co2_ppm : bucket->max_ppm;
+}
+
+static void summarise(const bucket_t &bucket, int64_t index, uint32_t length_s, summary_t *summary)
+{
+    summary->start_s = (uint32_t)(index * length_s);
+    summary->count = bucket.count;
+    summary->min_ppm = bucket.count ? bucket.min_ppm : 0;
+    summary->max_ppm = bucket.count ? bucket.max_ppm : 0;
+    summary->mean_ppm = bucket.count ? (uint16_t)((bucket.sum_ppm + bucket.count / 2) / bucket.count) : 0;
+    summary->held_s = bucket.held_ms / 1000;
+    summary->time_weighted_mean_ppm =
+        bucket.held_ms ? (uint16_t)((bucket.weighted_ppm_ms + bucket.held_ms / 2) / bucket.held_ms) : 0;
+    summary->exposure_ppm_h = (float)bucket.exposure_ppm_ms / k_ms_per_hour;
+}
+
+static void clear()
+{
+    taskENTER_CRITICAL(&s_lock);
+    for (level_state_t &level : s_levels) {
+        level.next_seq = 0;
+        level.current = k_empty;
+    }
+    s_started = false;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+#ifdef ESP_PLATFORM
+static uint32_t attribute_id(level_t level, field_t field)
+{
+    return k_attribute_base + (uint32_t)level * k_level_stride + (uint32_t)field;
+}
+
+static void update(level_t level, field_t field, esp_matter_attr_val_t value)
+{
+    if (attribute::update(s_endpoint_id, CarbonDioxideConcentrationMeasurement::Id, attribute_id(level, field),
+                          &value) != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to update %s rollup attribute %d", s_levels[level].name, field);
+    }
+}
+
+static esp_matter_attr_val_t nullable_ppm(uint16_t ppm, bool valid)
+{
+    return valid ? esp_matter_nullable_uint16(ppm) : esp_matter_nullable_uint16(nullable<uint16_t>());
+}
+#endif
+
+/* The Linux data model is generated without the rollup attributes, so there a closed bucket only goes to the log */
+static void publish(level_t level, const summary_t &summary)
+{
+#ifdef ESP_PLATFORM
+    if (s_endpoint_id == chip::kInvalidEndpointId) {
+        return;
+    }
+    bool have_samples = summary.count > 0;
+    update(level, FIELD_START, esp_matter_uint32(summary.start_s));
+    update(level, FIELD_COUNT, esp_matter_uint32(summary.count));
+    update(level, FIELD_MIN, nullable_ppm(summary.min_ppm, have_samples));
+    update(level, FIELD_MAX, nullable_ppm(summary.max_ppm, have_samples));
+    update(level, FIELD_MEAN, nullable_ppm(summary.mean_ppm, have_samples));
+    /* Samples only in the last second of the bucket leave it without a whole second of held time */
+    update(level, FIELD_TIME_WEIGHTED_MEAN, nullable_ppm(summary.time_weighted_mean_ppm, summary.held_s > 0));
+    update(level, FIELD_EXPOSURE, esp_matter_float(summary.exposure_ppm_h));
+#else
+    ESP_LOGD(TAG, "%s bucket at %" PRIu32 " s closed: %" PRIu32 " samples, mean %u ppm, twa %u ppm",
+             s_levels[level].name, summary.start_s, summary.count, summary.mean_ppm, summary.time_weighted_mean_ppm);
+#endif
+}
+
+#ifdef ESP_PLATFORM
+esp_err_t init(endpoint_t *sensor_endpoint)
+{
+    cluster_t *co2 = cluster::get(sensor_endpoint, CarbonDioxideConcentrationMeasurement::Id);
+    if (co2 == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_matter_attr_val_t null_ppm = esp_matter_nullable_uint16(nullable<uint16_t>());
+    for (int level = 0; level < LEVEL_MAX; level++) {
+        level_t l = (level_t)level;
+        if (!attribute::create(co2, attribute_id(l, FIELD_START), ATTRIBUTE_FLAG_NONE, esp_matter_uint32(0)) ||
+            !attribute::create(co2, attribute_id(l, FIELD_COUNT), ATTRIBUTE_FLAG_NONE, esp_matter_uint32(0)) ||
+            !attribute::create(co2, attribute_id(l, FIELD_MIN), ATTRIBUTE_FLAG_NULLABLE, null_ppm) ||
+            !attribute::create(co2, attribute_id(l, FIELD_MAX), ATTRIBUTE_FLAG_NULLABLE, null_ppm) ||
+            !attribute::create(co2, attribute_id(l, FIELD_MEAN), ATTRIBUTE_FLAG_NULLABLE, null_ppm) ||
+            !attribute::create(co2, attribute_id(l, FIELD_TIME_WEIGHTED_MEAN), ATTRIBUTE_FLAG_NULLABLE, null_ppm) ||
+            !attribute::create(co2, attribute_id(l, FIELD_EXPOSURE), ATTRIBUTE_FLAG_NONE, esp_matter_float(0))) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    s_endpoint_id = endpoint::get_id(sensor_endpoint);
+    return ESP_OK;
+}
+#endif
+
+void on_sample(const measurement_pipeline::result_t &result, int64_t timestamp_us)
+{
+    if (s_started && timestamp_us < s_held_us) {
+        ESP_LOGW(TAG, "Time went backwards, rollups cleared");
+        clear();
+    }
+
+    /* The bucket each level closes, published once the lock is released */
+    bool closed[LEVEL_MAX] = {};
+    bucket_t closed_buckets[LEVEL_MAX];
+    int64_t closed_indexes[LEVEL_MAX];
+    int64_t hold_end_us = timestamp_us < s_held_us + k_max_hold_us ? timestamp_us : s_held_us + k_max_hold_us;
+    taskENTER_CRITICAL(&s_lock);
+    for (int i = 0; i < LEVEL_MAX; i++) {
+        level_state_t *level = &s_levels[i];
+        int64_t index = timestamp_us / length_us(level);
+        if (!s_started) {
+            level->base_index = index;
+            level->current_index = index;
+            level->current = k_empty;
+        } else {
+            /* The held value covers the end of the open bucket and, past a boundary, the buckets after it */
+            hold_in_locked(level, &level->current, level->current_index, s_held_ppm, s_held_us, hold_end_us);
+            if (index > level->current_index) {
+                closed[i] = true;
+                closed_buckets[i] = level->current;
+                closed_indexes[i] = level->current_index;
+                advance_locked(level, index, s_held_ppm, s_held_us, hold_end_us);
+            }
+        }
+        add_locked(&level->current, result.co2_ppm);
+    }
+    s_started = true;
+    taskEXIT_CRITICAL(&s_lock);
+
+    s_held_ppm = result.co2_ppm;
+    s_held_us = timestamp_us;
+
+    for (int i = 0; i < LEVEL_MAX; i++) {
+        if (closed[i]) {
+            summary_t summary;
+            summarise(closed_buckets[i], closed_indexes[i], s_levels[i].length_s, &summary);
+            publish((level_t)i, summary);
+        }
+    }
+}
+
+bool get_current(level_t level, summary_t *summary)
+{
+    const level_state_t &state = s_levels[level];
+    taskENTER_CRITICAL(&s_lock);
+    bool started = s_started;
+    bucket_t bucket = state.current;
+    int64_t index = state.current_index;
+    taskEXIT_CRITICAL(&s_lock);
+    if (!started) {
+        return false;
+    }
+    summarise(bucket, index, state.length_s, summary);
+    return true;
+}
+
+bool get_closed(level_t level, uint32_t age, summary_t *summary)
+{
+    const level_state_t &state = s_levels[level];
+    taskENTER_CRITICAL(&s_lock);
+    if (age >= state.next_seq - oldest_seq_locked(&state)) {
+        taskEXIT_CRITICAL(&s_lock);
+        return false;
+    }
+    uint32_t seq = state.next_seq - 1 - age;
+    bucket_t bucket = state.ring[seq % state.capacity];
+    int64_t index = state.base_index + seq;
+    taskEXIT_CRITICAL(&s_lock);
+    summarise(bucket, index, state.length_s, summary);
+    return true;
+}
+
+#ifdef ESP_PLATFORM
+static const char k_csv_header[] = "level,start_s,count,min_ppm,max_ppm,mean_ppm,held_s,twa_ppm,exposure_ppm_h\r\n";
+
+static void print_summary(level_t level, const summary_t &summary)
+{
+    /* Thousandths of a ppm-hour, so the console needs no float formatting */
+    uint32_t exposure_milli = (uint32_t)(summary.exposure_ppm_h * 1000 + 0.5f);
+    printf("%s,%" PRIu32 ",%" PRIu32 ",%u,%u,%u,%" PRIu32 ",%u,%" PRIu32 ".%03" PRIu32 "\r\n",
+           s_levels[level].name, summary.start_s, summary.count, summary.min_ppm, summary.max_ppm, summary.mean_ppm,
+           summary.held_s, summary.time_weighted_mean_ppm, exposure_milli / 1000, exposure_milli % 1000);
+}
+
+static esp_err_t rollup_current_handler(int argc, char **argv)
+{
+    printf("%s", k_csv_header);
+    for (int level = 0; level < LEVEL_MAX; level++) {
+        summary_t summary;
+        if (get_current((level_t)level, &summary)) {
+            print_summary((level_t)level, summary);
+        }
+    }
+    return ESP_OK;
+}
+
+static esp_err_t rollup_dump_handler(int argc, char **argv)
+{
+    if (argc < 1) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    int level = 0;
+    while (level < LEVEL_MAX && strcmp(argv[0], s_levels[level].name) != 0) {
+        level++;
+    }
+    if (level == LEVEL_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    printf("%s", k_csv_header);
+    summary_t summary;
+    for (uint32_t age = s_levels[level].capacity; age-- > 0;) {
+        if (get_closed((level_t)level, age, &summary) && (summary.count > 0 || summary.held_s > 0)) {
+            print_summary((level_t)level, summary);
+        }
+    }
+    return ESP_OK;
+}
+
+static esp_err_t rollup_config_handler(int argc, char **argv)
+{
+    printf("exposure_ppm,%" PRIu32 "\r\n", k_exposure_ppm);
+    printf("max_hold_s,%d\r\n", CONFIG_SENSOR_ROLLUP_MAX_HOLD_S);
+    for (const level_state_t &level : s_levels) {
+        printf("%s_capacity,%" PRIu32 "\r\n", level.name, level.capacity);
+    }
+    printf("attribute_base,0x%08" PRIX32 "\r\n", k_attribute_base);
+    return ESP_OK;
+}
+
+static console::engine rollup_console;
+
+static esp_err_t rollup_dispatch(int argc, char **argv)
+{
+    if (argc <= 0) {
+        rollup_console.for_each_command(console::print_description, NULL);
+        return ESP_OK;
+    }
+    return rollup_console.exec_command(argc, argv);
+}
+
+esp_err_t register_commands()
+{
+    static const console::command_t command = {
+        .name = "rollup",
+        .description = "CO2 rollups. Usage: matter esp rollup <current|dump|config> [minute|hour|day].",
+        .handler = rollup_dispatch,
+    };
+
+    static const console::command_t rollup_commands[] = {
+        {
+            .name = "current",
+            .description = "Print the open minute, hour and day buckets as CSV",
+            .handler = rollup_current_handler,
+        },
+        {
+            .name = "dump",
+            .description = "Print the closed buckets of one level with samples or held time as CSV, oldest first. "
+                           "Usage: matter esp rollup dump <minute|hour|day>",
+            .handler = rollup_dump_handler,
+        },
+        {
+            .name = "config",
+            .description = "Print the exposure threshold, hold limit, ring sizes and attribute base",
+            .handler = rollup_config_handler,
+        },
+    };
+    rollup_console.register_commands(rollup_commands, sizeof(rollup_commands) / sizeof(console::command_t));
+
+    return console::add_commands(&command, 1);
+}
+#endif
+
+} // namespace sensor_rollup
@@ -0,0 +1,130 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <esp_err.h>
+#ifdef ESP_PLATFORM
+#include <esp_matter.h>
+#endif
+
+#include <sdkconfig.h>
+#include <stdint.h>
+
+#include <measurement-pipeline.h>
+
+/** CO2 aggregates per minute, hour and day
+ *
+ * Every level keeps one open bucket and a fixed ring of closed ones (`CONFIG_SENSOR_ROLLUP_MINUTES`, `_HOURS` and
+ * `_DAYS`). A sample updates the open bucket of each level with a constant amount of work; a bucket closes when the
+ * first sample of a later one arrives, and buckets without samples stay in the ring as gaps so every bucket sits at a
+ * fixed time, as in the measurement history.
+ *
+ * Each sample's value is held until the next sample, for at most `CONFIG_SENSOR_ROLLUP_MAX_HOLD_S`; the held time
+ * weights the time-weighted mean and the exposure, i.e. the ppm-hours above `CONFIG_SENSOR_ROLLUP_EXPOSURE_PPM`. A
+ * hold that crosses bucket boundaries is split between every bucket it covers, including those left without samples
+ * by a gap, so each bucket gets exactly the held time that falls in it.
+ *
+ * When a sample closes a bucket, that bucket is published as manufacturer-specific attributes of the
+ * CarbonDioxideConcentrationMeasurement cluster at `k_attribute_base + level * k_level_stride + field`, the base
+ * carrying `CONFIG_SENSOR_VENDOR_ID` in its upper 16 bits; buckets without samples are not published.
+ */
+namespace sensor_rollup {
+
+typedef enum {
+    LEVEL_MINUTE = 0,
+    LEVEL_HOUR,
+    LEVEL_DAY,
+    LEVEL_MAX,
+} level_t;
+
+/** Manufacturer-specific attribute IDs */
+static constexpr uint32_t k_attribute_base = (uint32_t)CONFIG_SENSOR_VENDOR_ID << 16;
+static constexpr uint32_t k_level_stride = 0x10;
+
+typedef enum {
+    FIELD_START = 0,          /* uint32, start of the bucket in virtual_clock seconds */
+    FIELD_COUNT,              /* uint32, samples in the bucket */
+    FIELD_MIN,                /* nullable uint16, ppm */
+    FIELD_MAX,                /* nullable uint16, ppm */
+    FIELD_MEAN,               /* nullable uint16, ppm */
+    FIELD_TIME_WEIGHTED_MEAN, /* nullable uint16, ppm */
+    FIELD_EXPOSURE,           /* float, ppm-hours above the exposure threshold */
+    FIELD_MAX_ID,
+} field_t;
+
+/** One bucket, in the form the rings keep it */
+typedef struct {
+    uint32_t count;
+    uint16_t min_ppm;
+    uint16_t max_ppm;
+    uint32_t sum_ppm;
+    uint32_t held_ms;           /* Time the values of the samples were held for */
+    uint64_t weighted_ppm_ms;   /* CO2 integrated over held_ms */
+    uint64_t exposure_ppm_ms;   /* CO2 above the threshold integrated over held_ms */
+} bucket_t;
+
+/** Figures derived from a bucket */
+typedef struct {
+    uint32_t start_s;
+    uint32_t count;
+    uint16_t min_ppm;
+    uint16_t max_ppm;
+    uint16_t mean_ppm;
+    uint32_t held_s;                 /* Time behind the time-weighted mean and the exposure */
+    uint16_t time_weighted_mean_ppm; /* 0 if no time was held */
+    float exposure_ppm_h;
+} summary_t;
+
+#ifdef ESP_PLATFORM
+/** Add the rollup attributes to the CO2 concentration cluster of the sensor endpoint
+ *
+ * Must be called before `esp_matter::start()`. Without it, as in the Linux build, the rollups are kept but not
+ * published.
+ *
+ * @return ESP_OK on success.
+ * @return ESP_ERR_INVALID_ARG if the endpoint has no CO2 concentration cluster.
+ * @return ESP_ERR_NO_MEM if an attribute could not be created.
+ */
+esp_err_t init(esp_matter::endpoint_t *sensor_endpoint);
+#endif
+
+/** Add a published sample to every level
+ *
+ * Closes the buckets the sample has moved past and publishes the one that had samples. The rollups are
+ * cleared if time goes backwards. Must be called from the Matter event loop.
+ *
+ * @param[in] result Values that were just published.
+ * @param[in] timestamp_us Time the sample was read, in virtual_clock microseconds.
+ */
+void on_sample(const measurement_pipeline::result_t &result, int64_t timestamp_us);
+
+/** Summarise the open bucket of a level
+ *
+ * @return false if the level has no open bucket yet.
+ */
+bool get_current(level_t level, summary_t *summary);
+
+/** Summarise a closed bucket of a level
+ *
+ * @param[in] age 0 for the last closed bucket, 1 for the one before, ...
+ *
+ * @return false if the ring holds no bucket that old.
+ */
+bool get_closed(level_t level, uint32_t age, summary_t *summary);
+
+#ifdef ESP_PLATFORM
+/** Register the `rollup` console commands
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t register_commands();
+#endif
+
+} // namespace sensor_rollup
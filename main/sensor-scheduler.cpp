@@ -0,0 +1,200 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <sensor-scheduler.h>
+#include <virtual-clock.h>
+
+#include <esp_log.h>
+#include <esp_matter_console.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "sensor_scheduler";
+
+using namespace esp_matter;
+
+namespace sensor_scheduler {
+
+static esp_timer_handle_t s_timer = NULL;
+static sample_cb_t s_callback = NULL;
+static deadline_grid::grid_t s_grid;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/* Runs in the esp_timer task, above the Matter task, so a sample is never preempted by the attribute reads of the
+ * value it is writing. The callback only starts the sample and returns; a sample still in progress from the previous
+ * deadline makes this one a missed deadline rather than a queued one. */
+static void timer_cb(void *arg)
+{
+    int64_t deadline_us;
+    taskENTER_CRITICAL(&s_lock);
+    int64_t next_deadline_us = deadline_grid::advance(&s_grid, virtual_clock::now_us(), &deadline_us);
+    taskEXIT_CRITICAL(&s_lock);
+
+    int64_t delay_us = next_deadline_us - virtual_clock::now_us();
+    esp_timer_start_once(s_timer, delay_us > 0 ? delay_us : 0);
+
+    int64_t jitter_us = virtual_clock::now_us() - deadline_us;
+    bool started = s_callback(deadline_us);
+    taskENTER_CRITICAL(&s_lock);
+    if (started) {
+        deadline_grid::record_jitter(&s_grid, jitter_us);
+    } else {
+        deadline_grid::record_missed(&s_grid);
+    }
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+esp_err_t init(uint32_t period_ms, sample_cb_t callback)
+{
+    if (period_ms == 0 || !callback) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_timer) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = timer_cb,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "sensor_sample",
+        .skip_unhandled_events = true,
+    };
+    esp_err_t err = esp_timer_create(&timer_args, &s_timer);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create sampling timer, err:%d", err);
+        return err;
+    }
+
+    s_callback = callback;
+    s_grid.period_ms = period_ms;
+    reset_jitter_stats();
+    return ESP_OK;
+}
+
+esp_err_t start(uint32_t warm_up_ms)
+{
+    if (!s_timer) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    int64_t now = virtual_clock::now_us();
+    taskENTER_CRITICAL(&s_lock);
+    int64_t first_delay_us = deadline_grid::start(&s_grid, now, warm_up_ms);
+    taskEXIT_CRITICAL(&s_lock);
+
+    esp_timer_stop(s_timer);
+    return esp_timer_start_once(s_timer, first_delay_us);
+}
+
+void set_period(uint32_t period_ms)
+{
+    if (period_ms == 0) {
+        return;
+    }
+    taskENTER_CRITICAL(&s_lock);
+    s_grid.period_ms = period_ms;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+uint32_t get_period()
+{
+    taskENTER_CRITICAL(&s_lock);
+    uint32_t period_ms = s_grid.period_ms;
+    taskEXIT_CRITICAL(&s_lock);
+    return period_ms;
+}
+
+void get_jitter_stats(jitter_stats_t *stats)
+{
+    taskENTER_CRITICAL(&s_lock);
+    *stats = s_grid.stats;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+void reset_jitter_stats()
+{
+    taskENTER_CRITICAL(&s_lock);
+    memset(&s_grid.stats, 0, sizeof(s_grid.stats));
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+static esp_err_t sampling_stats_handler(int argc, char **argv)
+{
+    jitter_stats_t stats;
+    get_jitter_stats(&stats);
+
+    printf("period_ms,%" PRIu32 "\r\n", get_period());
+    printf("samples,%" PRIu32 "\r\n", stats.samples);
+    printf("missed_deadlines,%" PRIu32 "\r\n", stats.missed_deadlines);
+    if (stats.samples > 0) {
+        printf("jitter_us,min,%" PRId64 ",mean,%" PRId64 ",max,%" PRId64 "\r\n", stats.min_us,
+               stats.total_us / stats.samples, stats.max_us);
+    }
+    for (int i = 0; i < SENSOR_SCHEDULER_JITTER_BUCKETS - 1; i++) {
+        printf("jitter_lt_us,%" PRId64 ",%" PRIu32 "\r\n", deadline_grid::k_bucket_limits_us[i], stats.buckets[i]);
+    }
+    printf("jitter_ge_us,%" PRId64 ",%" PRIu32 "\r\n",
+           deadline_grid::k_bucket_limits_us[SENSOR_SCHEDULER_JITTER_BUCKETS - 2],
+           stats.buckets[SENSOR_SCHEDULER_JITTER_BUCKETS - 1]);
+    /* Samples run on the esp_timer task's stack, shared with every other esp_timer callback */
+    TaskHandle_t timer_task = xTaskGetHandle("esp_timer");
+    if (timer_task) {
+        printf("timer_task_stack_free_bytes,%" PRIu32 "\r\n", (uint32_t)uxTaskGetStackHighWaterMark(timer_task));
+    }
+    return ESP_OK;
+}
+
+static esp_err_t sampling_reset_handler(int argc, char **argv)
+{
+    reset_jitter_stats();
+    return ESP_OK;
+}
+
+static console::engine sampling_console;
+
+static esp_err_t sampling_dispatch(int argc, char **argv)
+{
+    if (argc <= 0) {
+        sampling_console.for_each_command(console::print_description, NULL);
+        return ESP_OK;
+    }
+    return sampling_console.exec_command(argc, argv);
+}
+
+esp_err_t register_commands()
+{
+    static const console::command_t command = {
+        .name = "sampling",
+        .description = "Sensor sampling scheduler. Usage: matter esp sampling <stats|reset>.",
+        .handler = sampling_dispatch,
+    };
+
+    static const console::command_t sampling_commands[] = {
+        {
+            .name = "stats",
+            .description = "Print the sampling period and the jitter distribution",
+            .handler = sampling_stats_handler,
+        },
+        {
+            .name = "reset",
+            .description = "Reset the jitter statistics",
+            .handler = sampling_reset_handler,
+        },
+    };
+    sampling_console.register_commands(sampling_commands, sizeof(sampling_commands) / sizeof(console::command_t));
+
+    return console::add_commands(&command, 1);
+}
+
+} // namespace sensor_scheduler
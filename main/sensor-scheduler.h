@@ -0,0 +1,84 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <deadline-grid.h>
+#include <esp_err.h>
+
+#include <stdint.h>
+
+namespace sensor_scheduler {
+
+/** Sample callback
+ *
+ * Invoked from the esp_timer task once per sampling deadline, without the CHIP stack lock. That task runs above the
+ * Matter task and serves every esp_timer in the system, so the callback must not block or sleep: it starts the sample
+ * and carries it on from timers of its own. Anything that needs the data model must be handed to the Matter event
+ * loop.
+ *
+ * @param[in] deadline_us Absolute deadline of this sample, in virtual_clock microseconds.
+ *
+ * @return false if the previous sample is still in progress and this one was not started; counted as a missed
+ *         deadline.
+ */
+typedef bool (*sample_cb_t)(int64_t deadline_us);
+
+#define SENSOR_SCHEDULER_JITTER_BUCKETS DEADLINE_GRID_JITTER_BUCKETS
+
+/** Sampling jitter statistics, see `deadline_grid::jitter_stats_t` */
+typedef deadline_grid::jitter_stats_t jitter_stats_t;
+
+/** Initialize the scheduler
+ *
+ * @param[in] period_ms Sampling period.
+ * @param[in] callback Function run for every sample.
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t init(uint32_t period_ms, sample_cb_t callback);
+
+/** Start sampling
+ *
+ * The first deadline is one period or `warm_up_ms` from now, whichever is later; subsequent deadlines are spaced
+ * exactly one period apart, regardless of how long each sample takes. A deadline that comes up while the previous
+ * sample is still in progress is counted as missed rather than queued.
+ *
+ * @param[in] warm_up_ms Minimum delay before the first sample, e.g. until the sensor has a first measurement.
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t start(uint32_t warm_up_ms = 0);
+
+/** Change the sampling period
+ *
+ * Takes effect from the deadline following the next one.
+ *
+ * @param[in] period_ms New sampling period.
+ */
+void set_period(uint32_t period_ms);
+
+/** Current sampling period in milliseconds */
+uint32_t get_period();
+
+/** Copy the jitter statistics */
+void get_jitter_stats(jitter_stats_t *stats);
+
+/** Reset the jitter statistics */
+void reset_jitter_stats();
+
+/** Register the `sampling` console commands
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t register_commands();
+
+} // namespace sensor_scheduler
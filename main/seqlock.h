@@ -0,0 +1,69 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+/** Single-writer sequence lock around a small value
+ *
+ * The writer never blocks and never waits for readers; a reader copies the value and retries if a write overlapped
+ * its copy. The value is held as relaxed atomic words, so an overlapping copy is merely discarded rather than being
+ * a data race. Only one task may write.
+ */
+template <typename T>
+class Seqlock
+{
+public:
+    static_assert(std::is_trivially_copyable<T>::value, "Seqlock values are copied word by word");
+
+    void Write(const T &value)
+    {
+        uint32_t words[kWords] = {};
+        memcpy(words, &value, sizeof(T));
+        uint32_t seq = mSeq.load(std::memory_order_relaxed);
+        /* Odd while the words are being replaced */
+        mSeq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < kWords; i++) {
+            mWords[i].store(words[i], std::memory_order_relaxed);
+        }
+        mSeq.store(seq + 2, std::memory_order_release);
+    }
+
+    /** Copy the value once; false if nothing was written yet or a write overlapped the copy */
+    bool TryRead(T *value) const
+    {
+        uint32_t before = mSeq.load(std::memory_order_acquire);
+        if (before == 0 || (before & 1)) {
+            return false;
+        }
+        uint32_t words[kWords];
+        for (size_t i = 0; i < kWords; i++) {
+            words[i] = mWords[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (mSeq.load(std::memory_order_relaxed) != before) {
+            return false;
+        }
+        memcpy(value, words, sizeof(T));
+        return true;
+    }
+
+    /** True once the first write has completed */
+    bool Written() const { return mSeq.load(std::memory_order_acquire) >= 2; }
+
+private:
+    static constexpr size_t kWords = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+    std::atomic<uint32_t> mSeq{0};
+    std::atomic<uint32_t> mWords[kWords] = {};
+};
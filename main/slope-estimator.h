@@ -0,0 +1,117 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+/** Least-squares slope over a sliding window of samples
+ *
+ * The regression sums are updated incrementally, so pushing a sample and reading the slope are O(1). Times are kept
+ * relative to an origin that is moved forward every few hours to keep the sums well inside 64 bits.
+ */
+class SlopeEstimator
+{
+public:
+    static constexpr uint8_t kMaxWindow = 16;
+
+    explicit SlopeEstimator(uint8_t window) : mWindow(window < 2 ? 2 : (window > kMaxWindow ? kMaxWindow : window))
+    {
+        Reset();
+    }
+
+    void Reset()
+    {
+        mCount = 0;
+        mHead = 0;
+        mOriginMs = 0;
+        mSumT = mSumY = mSumTT = mSumTY = 0;
+    }
+
+    void Push(int64_t timestampMs, int32_t value)
+    {
+        if (mCount == 0) {
+            mOriginMs = timestampMs;
+        } else if (timestampMs - mOriginMs > kRebaseAfterMs) {
+            Rebase(timestampMs);
+        }
+
+        if (mCount == mWindow) {
+            Remove(mTimes[mHead], mValues[mHead]);
+        } else {
+            mCount++;
+        }
+        mTimes[mHead] = timestampMs - mOriginMs;
+        mValues[mHead] = value;
+        Add(mTimes[mHead], value);
+        mHead = (mHead + 1) % mWindow;
+    }
+
+    /** True once at least two samples are in the window */
+    bool Ready() const { return mCount >= 2; }
+
+    /** Slope in value units per minute, 0 until two samples with distinct timestamps are available */
+    int32_t SlopePerMinute() const
+    {
+        int64_t n = mCount;
+        int64_t denominator = n * mSumTT - mSumT * mSumT;
+        if (n < 2 || denominator == 0) {
+            return 0;
+        }
+        return (int32_t)((n * mSumTY - mSumT * mSumY) * 60000 / denominator);
+    }
+
+private:
+    /* Relative times stay below 2^24 ms (~4.6 h), so n * sum(t * t) stays below 2^57 */
+    static constexpr int64_t kRebaseAfterMs = 1 << 24;
+
+    void Add(int64_t t, int64_t y)
+    {
+        mSumT += t;
+        mSumY += y;
+        mSumTT += t * t;
+        mSumTY += t * y;
+    }
+
+    void Remove(int64_t t, int64_t y)
+    {
+        mSumT -= t;
+        mSumY -= y;
+        mSumTT -= t * t;
+        mSumTY -= t * y;
+    }
+
+    /* Move the origin to the oldest sample in the window and rebuild the sums, O(window) every few hours */
+    void Rebase(int64_t timestampMs)
+    {
+        uint8_t oldest = mCount == mWindow ? mHead : 0;
+        int64_t shift = mTimes[oldest];
+        mSumT = mSumY = mSumTT = mSumTY = 0;
+        for (uint8_t i = 0; i < mCount; i++) {
+            mTimes[i] -= shift;
+            Add(mTimes[i], mValues[i]);
+        }
+        mOriginMs += shift;
+        /* A window that spans more than the rebase horizon is stale, start over */
+        if (timestampMs - mOriginMs > kRebaseAfterMs) {
+            Reset();
+            mOriginMs = timestampMs;
+        }
+    }
+
+    const uint8_t mWindow;
+    uint8_t mCount;
+    uint8_t mHead;
+    int64_t mOriginMs;
+    int64_t mTimes[kMaxWindow];
+    int32_t mValues[kMaxWindow];
+    int64_t mSumT;
+    int64_t mSumY;
+    int64_t mSumTT;
+    int64_t mSumTY;
+};
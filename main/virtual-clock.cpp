@@ -0,0 +1,26 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <virtual-clock.h>
+
+#include "drivers/sensirion_i2c_hal.h"
+
+namespace virtual_clock {
+
+int64_t now_us()
+{
+    /* The HAL clock is the single time source, so a clock installed there moves this one too */
+    return (int64_t)sensirion_i2c_hal_get_time_usec();
+}
+
+void sleep_us(uint32_t duration_us)
+{
+    sensirion_i2c_hal_sleep_usec(duration_us);
+}
+
+} // namespace virtual_clock
@@ -0,0 +1,27 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+/** Clock and sleep used by the sensor HAL, the sampling scheduler and the statistics code
+ *
+ * Both read the Sensirion HAL clock: esp_timer time and a FreeRTOS delay on target. A host build installs a simulated
+ * clock with `sensirion_i2c_hal_set_clock()` instead, where sleeping only moves the time on, so hours of sensor timing
+ * (command execution times, sampling periods) run in as long as the code takes; see the host tests in `linux`.
+ */
+namespace virtual_clock {
+
+/** Current time in microseconds */
+int64_t now_us();
+
+/** Sleep at least `duration_us` */
+void sleep_us(uint32_t duration_us);
+
+} // namespace virtual_clock